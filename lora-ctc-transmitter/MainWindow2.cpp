@@ -20,11 +20,11 @@
 //------------------------------------------------------------------------------
 
 #include "MainWindow2.h"
-#include <QDateTime>
 #include "WiMODLRHCI.h"
 #include "SerialDevice.h"
 #include <cstdio>
 #include <stdlib.h>
+#include <unistd.h>
 //------------------------------------------------------------------------------
 //
 //  TMainWindow - Class Constructor
@@ -35,11 +35,12 @@ TMainWindow::TMainWindow()
 {
     //CreateGUI();
     //cmdConnection_Query();
-    //TimerPeriod = 50; // 50ms polling period
-    //TimerID     = startTimer(TimerPeriod);
     // register for rx-messages and debug output
 
     RadioIF.RegisterClient(this);
+
+    // 2.480GHz, channel 26
+    Frequency = 2480000000.0;
 }
 
 //------------------------------------------------------------------------------
@@ -73,24 +74,17 @@ TMainWindow::~TMainWindow()
 //------------------------------------------------------------------------------
 
 void
-TMainWindow::cmdConnection_Open()
+TMainWindow::cmdConnection_Open(std::string_view port)
 {
-    char cmd[] = "sudo fuser -k /dev/ttyUSBx";
-    printf("Using ttyUSB1...\n");
-    QString Port;
-    int Port_Number = 1;
-
-    //scanf("%d",&Port_Number);
-    cmd[sizeof(cmd)-2] = '0' + Port_Number;
-    system(cmd);
-
-    Port.append("ttyUSB");
-    Port.append(QString::number(Port_Number));
-
+    printf("Using %.*s...\n", (int)port.size(), port.data());
 
-    if (RadioIF.Open(Port))
+    if (RadioIF.Open(port))
     {
         printf("Connection OK\n");
+
+        // read responses in the background
+        if (!RadioIF.StartReceiver())
+            printf("warning - no receiver thread, polling comport\n");
     }
     else
     {
@@ -116,7 +110,7 @@ TMainWindow::cmdConnection_Query()
     //Connection.ComPorts->clear();
 
     // get available comports from device monitor
-    QStringList comPorts;
+    TStringList comPorts;
 
     // get available comports
     TSerialDevice::GetComPorts(comPorts);
@@ -146,20 +140,17 @@ TMainWindow::cmdConnection_Close()
     RadioIF.Close();
 }
 
-//------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 //
-//  timerEvent
+//  Poll
 //
-//  @brief: handle comport receiver path in timer event
+//  @brief: handle receiver path from the application loop, non-blocking
 //
 //------------------------------------------------------------------------------
-//------------------------------------------------------------------------------
 
 void
-TMainWindow::timerEvent(QTimerEvent* /* ev */)
+TMainWindow::Poll()
 {
-    // poll radio interface for message reception
     RadioIF.Process();
 }
 
@@ -197,6 +188,37 @@ TMainWindow::cmdDevice_Ping()
     printf("-------------------------\n");
 }
 
+//------------------------------------------------------------------------------
+//
+//  cmdDevice_PingAsync
+//
+//  @brief: ping without blocking, round trip is reported from Poll()
+//
+//------------------------------------------------------------------------------
+
+void
+TMainWindow::cmdDevice_PingAsync()
+{
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    TWiMODLRResult result = RadioIF.PingRequestAsync([start](const TWiMODLR_HCIResponse& response)
+    {
+        if (response.Result == WiMODLR_RESULT_OK)
+        {
+            long rtt = (long)std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+            printf("* ping: rtt=%ld us\n", rtt);
+        }
+        else
+        {
+            printf("* ping: no response\n");
+        }
+    });
+
+    if (result != WiMODLR_RESULT_OK)
+        printf("* ping: not sent (%d)\n", result);
+}
+
 //------------------------------------------------------------------------------
 //
 //  cmdDevice_FactoryReset
@@ -250,7 +272,7 @@ TMainWindow::cmdDevice_GetRadioConfiguration()
         }
         else
         {
-            ShowResult("error - " + QString(RadioIF.GetDeviceMgmtStatusString(status)));
+            ShowResult("error - ", RadioIF.GetDeviceMgmtStatusString(status));
         }
     }
     else
@@ -288,7 +310,7 @@ TMainWindow::cmdDevice_SetRadioConfiguration(int power)
             //config.Frequency = 12451840;            //2.470GHz Channel 24
             config.PowerLevel = power;
             //printf("%d\n", (2480000000/((double)52000000/double(1 << 18))));
-            config.Frequency = (2480000000/((double)52000000/double(1 << 18)));
+            config.Frequency = (UINT32)(Frequency/((double)52000000/double(1 << 18)));
             //config.Frequency = 12477046;            //2.475GHZ Channel 25
             //config.Frequency = 12492170;              //2478
             //config.Frequency = 12494690;              //2478.5
@@ -319,7 +341,7 @@ TMainWindow::cmdDevice_SetRadioConfiguration(int power)
                 }
                 else
                 {
-                    ShowResult("error - " + QString(RadioIF.GetDeviceMgmtStatusString(status)));
+                    ShowResult("error - ", RadioIF.GetDeviceMgmtStatusString(status));
                 }
             }
             else
@@ -424,7 +446,7 @@ TMainWindow::cmdDevice_SetRadioConfiguration3()
                 }
                 else
                 {
-                    ShowResult("error - " + QString(RadioIF.GetDeviceMgmtStatusString(status)));
+                    ShowResult("error - ", RadioIF.GetDeviceMgmtStatusString(status));
                 }
             }
             else
@@ -499,7 +521,7 @@ TMainWindow::cmdRadioLink_SendUMessage()
         }
         else
         {
-            ShowResult("error - " + QString(RadioIF.GetRadioLinkStatusString(status)));
+            ShowResult("error - ", RadioIF.GetRadioLinkStatusString(status));
         }
     }
     else
@@ -512,7 +534,6 @@ extern UINT8 txMessage[];
 void
 TMainWindow::cmdRadioLink_SendUMessage2(UINT16 pl)
 {
-
     //UINT16 numBytes;
     //numBytes = (UINT16)sizeof(txMessage);
     // send unreliable message
@@ -524,11 +545,135 @@ TMainWindow::cmdRadioLink_SendUMessage2(UINT16 pl)
     //RadioIF.SendURadioMessage2(txMessage, numBytes, status);
     if(pl <= 0){
         return;
-    }else{
+    }
+    // pre-encoded frame available ? -> single write
+    if (RadioIF.SendCachedURadioMessage(pl) == WiMODLR_RESULT_FRAME_NOT_CACHED)
+    {
         RadioIF.SendURadioMessage2(txMessage, pl, status);
     }
 }
 
+//------------------------------------------------------------------------------
+//
+//  cmdRadioLink_CacheUMessages
+//
+//  @brief: pre-encode txMessage for every CTC payload length
+//
+//------------------------------------------------------------------------------
+
+void
+TMainWindow::cmdRadioLink_CacheUMessages(const UINT8* lengths, int count)
+{
+    ShowCommand("cache unreliable radio messages");
+
+    for(int i = 0; i < count; i++)
+    {
+        if (RadioIF.CacheURadioMessage(txMessage, lengths[i]) != WiMODLR_RESULT_OK)
+        {
+            printf("error - length %d not cached\n", lengths[i]);
+        }
+    }
+    printf("-------------------------\n");
+}
+
+//------------------------------------------------------------------------------
+//
+//  cmdRadioLink_ProfileTx
+//
+//  @brief: enable/disable serial tx profiling, see SERIAL_TXPROF_xxx
+//
+//------------------------------------------------------------------------------
+
+void
+TMainWindow::cmdRadioLink_ProfileTx(int mode)
+{
+    RadioIF.GetSerialDevice().SetTxProfiling(mode);
+}
+
+//------------------------------------------------------------------------------
+//
+//  cmdRadioLink_SaveTxProfile
+//
+//  @brief: export tx histograms per payload length as CSV
+//
+//------------------------------------------------------------------------------
+
+void
+TMainWindow::cmdRadioLink_SaveTxProfile(const char* fileName)
+{
+    FILE* out = fopen(fileName, "w");
+
+    if (!out)
+    {
+        printf("error - cannot write %s\n", fileName);
+        return;
+    }
+    RadioIF.GetSerialDevice().WriteTxStatsCSV(out);
+    fclose(out);
+}
+
+//------------------------------------------------------------------------------
+//
+//  cmdRadioLink_CalibrateTx
+//
+//  @brief: measure write-to-drain time of every CTC payload length and
+//          derive the lead [us] that makes all frames leave the serial
+//          port as if they were as short as lengths[0]
+//
+//------------------------------------------------------------------------------
+
+bool
+TMainWindow::cmdRadioLink_CalibrateTx(const UINT8* lengths, int count, int rounds, INT32* lead)
+{
+    TSerialDevice& device = RadioIF.GetSerialDevice();
+    int prevMode = device.GetTxProfiling();
+
+    ShowCommand("calibrate serial tx lead");
+
+    device.ResetTxStats();
+    device.SetTxProfiling(SERIAL_TXPROF_OUTQ);
+
+    // interleave lengths so slow drifts hit all of them alike
+    for(int r = 0; r < rounds; r++)
+    {
+        for(int i = 0; i < count; i++)
+        {
+            cmdRadioLink_SendUMessage2(lengths[i]);
+
+            // let the radio finish the frame before the next one
+            usleep(50000);
+            Poll();
+        }
+    }
+    device.SetTxProfiling(prevMode);
+
+    const TSerialTxStats* ref = device.GetTxStats(lengths[0]);
+    if (!ref || !ref->Drains)
+    {
+        printf("error - no samples\n");
+        return false;
+    }
+    double refDrain = (double)ref->DrainSum / ref->Drains;
+
+    for(int i = 0; i < count; i++)
+    {
+        const TSerialTxStats* st = device.GetTxStats(lengths[i]);
+
+        if (!st || !st->Drains)
+        {
+            printf("error - no samples for length %d\n", lengths[i]);
+            return false;
+        }
+        double drain = (double)st->DrainSum / st->Drains;
+
+        lead[i] = (INT32)((drain - refDrain) / 1000.0 + 0.5);
+
+        printf("code %2d: len=%3d drain avg=%.1f min=%.1f max=%.1f us -> lead %d us\n",
+               i, lengths[i], drain / 1000.0, st->DrainMin / 1000.0, st->DrainMax / 1000.0, lead[i]);
+    }
+    printf("-------------------------\n");
+    return true;
+}
 
 //------------------------------------------------------------------------------
 //
@@ -559,9 +704,9 @@ TMainWindow::evRadioLink_RxUMessage(const TWiMODLR_HCIMessage& rxMsg)
 //------------------------------------------------------------------------------
 
 void
-TMainWindow::evRadio_ShowMessage(const QString& prefix, const QString& msg)
+TMainWindow::evRadio_ShowMessage(std::string_view prefix, std::string_view msg)
 {
-    ShowMessage(prefix + ":" + msg);
+    printf("%.*s:%.*s\n", (int)prefix.size(), prefix.data(), (int)msg.size(), msg.data());
 }
 
 //------------------------------------------------------------------------------
@@ -743,7 +888,7 @@ TMainWindow::CreateLogWindow()
 //------------------------------------------------------------------------------
 
 void
-TMainWindow::ShowMessage(const QString& msg)
+TMainWindow::ShowMessage(std::string_view msg)
 {
     //QDate   date = QDate::currentDate();
     //QString dateString = date.toString(tr("yyyy-MM-dd"));
@@ -752,8 +897,7 @@ TMainWindow::ShowMessage(const QString& msg)
     //QString timeString = time.toString(tr("hh:mm:ss.zzz"));
 
     //LogWindow.Box->append(dateString + ";" + timeString + ";" + msg);
-    printf(msg.toStdString().c_str());
-    printf("\n");
+    printf("%.*s\n", (int)msg.size(), msg.data());
 }
 
 //------------------------------------------------------------------------------
@@ -765,20 +909,19 @@ TMainWindow::ShowMessage(const QString& msg)
 //------------------------------------------------------------------------------
 
 void
-TMainWindow::ShowMessage(const QString& prefix, const QStringList& list)
+TMainWindow::ShowMessage(std::string_view prefix, const TStringList& list)
 {
     if(1)
     {
-        QString msg = prefix + ":" + list.join(";");
-        ShowMessage(msg);
+        printf("%.*s:", (int)prefix.size(), prefix.data());
+        for(int i = 0; i < list.count(); i++)
+            printf(i ? ";%.*s" : "%.*s", (int)list[i].size(), list[i].data());
+        printf("\n");
     }
     else
     {
         for(int i = 0; i < list.count(); i++)
-        {
-            QString msg = prefix + ":" + list[i];
-            ShowMessage(msg);
-        }
+            printf("%.*s:%.*s\n", (int)prefix.size(), prefix.data(), (int)list[i].size(), list[i].data());
     }
 }
 
@@ -791,9 +934,9 @@ TMainWindow::ShowMessage(const QString& prefix, const QStringList& list)
 //------------------------------------------------------------------------------
 
 void
-TMainWindow::ShowCommand(const QString& cmd)
+TMainWindow::ShowCommand(std::string_view cmd)
 {
-    ShowMessage("Command:" + cmd);
+    printf("Command:%.*s\n", (int)cmd.size(), cmd.data());
 }
 
 //------------------------------------------------------------------------------
@@ -805,9 +948,9 @@ TMainWindow::ShowCommand(const QString& cmd)
 //------------------------------------------------------------------------------
 
 void
-TMainWindow::ShowResult(const QString& result)
+TMainWindow::ShowResult(std::string_view result, std::string_view detail)
 {
-    ShowMessage("Result:" + result);
+    printf("Result:%.*s%.*s\n", (int)result.size(), result.data(), (int)detail.size(), detail.data());
 }
 
 //------------------------------------------------------------------------------
@@ -819,9 +962,10 @@ TMainWindow::ShowResult(const QString& result)
 //------------------------------------------------------------------------------
 
 void
-TMainWindow::ShowEvent(const QString& event, const QStringList& list)
+TMainWindow::ShowEvent(std::string_view event, const TStringList& list)
 {
-    ShowMessage("Event:" + event, list);
+    printf("Event:");
+    ShowMessage(event, list);
 }
 
 //------------------------------------------------------------------------------
@@ -34,7 +34,7 @@
 */
 #include "WiMODLRHCI.h"
 #include "KeyValueList.h"
-#include <QObject>
+#include <string_view>
 
 //------------------------------------------------------------------------------
 //
@@ -51,26 +51,37 @@ public:
     
 
     // handlers for connection handling
-    void            cmdConnection_Open();
+    void            cmdConnection_Open(std::string_view port);
     void            cmdConnection_Close();
     void            cmdConnection_Query();
 
+    // receiver path, dispatches responses of asynchronous requests
+    void            Poll();
+
     // handlers for device management commands
     void            cmdDevice_Ping();
+    void            cmdDevice_PingAsync();
     void            cmdDevice_FactoryReset();
     void            cmdDevice_GetRadioConfiguration();
     void            cmdDevice_SetRadioConfiguration(int power);
     void            cmdDevice_SetRadioConfiguration2(int power);
     void            cmdDevice_SetRadioConfiguration3();
 
+    // carrier frequency [Hz] used by cmdDevice_SetRadioConfiguration
+    void            SetFrequency(double frequency) { Frequency = frequency; }
+
     // handlers for radiolink commands
     void            cmdRadioLink_SendUMessage();
     void            cmdRadioLink_SendUMessage2(UINT16 pl);
+    void            cmdRadioLink_CacheUMessages(const UINT8* lengths, int count);
+    void            cmdRadioLink_ProfileTx(int mode);
+    void            cmdRadioLink_SaveTxProfile(const char* fileName);
+    bool            cmdRadioLink_CalibrateTx(const UINT8* lengths, int count, int rounds, INT32* lead);
 
 
 private:
     // radio callback interface
-    void            evRadio_ShowMessage(const QString& prefix, const QString& msg);
+    void            evRadio_ShowMessage(std::string_view prefix, std::string_view msg);
     void            evRadioLink_RxUMessage(const TWiMODLR_HCIMessage& rxMsg);
 
 
@@ -81,15 +92,12 @@ private:
     //QTextEdit*      CreateLogWindow();
 
     // logging support
-    void            ShowMessage(const QString &msg);
-    void            ShowMessage(const QString& prefix, const QStringList& list);
+    void            ShowMessage(std::string_view msg);
+    void            ShowMessage(std::string_view prefix, const TStringList& list);
     void            ShowLine();
-    void            ShowCommand(const QString& cmd);
-    void            ShowResult(const QString& result);
-    void            ShowEvent(const QString& event, const QStringList& list);
-
-    // timer support
-    void            timerEvent(QTimerEvent* ev);
+    void            ShowCommand(std::string_view cmd);
+    void            ShowResult(std::string_view result, std::string_view detail = std::string_view());
+    void            ShowEvent(std::string_view event, const TStringList& list);
 
 private:
     // Connection widgets (connection is implemneted via (virtual) serial comport)
@@ -114,9 +122,8 @@ private:
     // Radio Interface (WiMODLRHCI supports iM880A-L)
     TWiMODLRHCI     RadioIF;
 
-    // Timer for comport polling
-    int             TimerID;
-    int             TimerPeriod;
+    // carrier frequency [Hz]
+    double          Frequency;
 };
 
 #endif // MAINWINDOW_H
@@ -20,6 +20,13 @@
 //------------------------------------------------------------------------------
 
 #include "ComSlip.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 //------------------------------------------------------------------------------
 //
@@ -39,6 +46,72 @@
 #define	SLIPDEC_IN_FRAME_STATE		2
 #define	SLIPDEC_ESC_STATE			3
 
+// bytes checked at once by HasSpecial()
+#define SLIP_BLOCK_SIZE             16
+
+//------------------------------------------------------------------------------
+//
+//  HasSpecial
+//
+//  @brief: true if one of the SLIP_BLOCK_SIZE bytes at data is SLIP_END or
+//          SLIP_ESC
+//
+//------------------------------------------------------------------------------
+
+static inline bool
+HasSpecial(const UINT8* data)
+{
+#if defined(__SSE2__)
+    __m128i v = _mm_loadu_si128((const __m128i*)data);
+
+    return _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8((char)SLIP_END)),
+                                          _mm_cmpeq_epi8(v, _mm_set1_epi8((char)SLIP_ESC)))) != 0;
+#elif defined(__ARM_NEON)
+    uint8x16_t v = vld1q_u8(data);
+    uint64x2_t m = vreinterpretq_u64_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8(SLIP_END)),
+                                                 vceqq_u8(v, vdupq_n_u8(SLIP_ESC))));
+
+    return (vgetq_lane_u64(m, 0) | vgetq_lane_u64(m, 1)) != 0;
+#else
+    // 8 bytes per word: a byte of x ^ c is zero where x has byte c
+    const UINT64 ones  = 0x0101010101010101ULL;
+    const UINT64 highs = 0x8080808080808080ULL;
+    UINT64       found = 0;
+
+    for(int i = 0; i < SLIP_BLOCK_SIZE; i += 8)
+    {
+        UINT64 x, e, s;
+
+        memcpy(&x, data + i, 8);
+        e = x ^ (ones * SLIP_END);
+        s = x ^ (ones * SLIP_ESC);
+        found |= ((e - ones) & ~e) | ((s - ones) & ~s);
+    }
+    return (found & highs) != 0;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//
+//  FindSpecial
+//
+//  @brief: first SLIP_END or SLIP_ESC in [data, end), end if none
+//
+//------------------------------------------------------------------------------
+
+static inline const UINT8*
+FindSpecial(const UINT8* data, const UINT8* end)
+{
+    // skip blocks without special bytes, locate the hit byte by byte
+    while((end - data >= SLIP_BLOCK_SIZE) && !HasSpecial(data))
+        data += SLIP_BLOCK_SIZE;
+
+    while((data < end) && (*data != SLIP_END) && (*data != SLIP_ESC))
+        data++;
+
+    return data;
+}
+
 //------------------------------------------------------------------------------
 //
 //  Class Constructor
@@ -66,60 +139,71 @@ TComSlip::TComSlip()
 int
 TComSlip::EncodeData(UINT8* dstBuffer, UINT16 dstBufferSize, UINT8* srcPtr, UINT16 msgLength)
 {
-    // save start pointer
-    //int txLength = 0;
+    const UINT8* srcEnd = srcPtr + msgLength;
+    UINT8*       dstPtr = dstBuffer;
+    UINT8*       dstEnd = dstBuffer + dstBufferSize;
 
-    // init TxBuffer
-    TxBuffer = dstBuffer;
-
-    // init TxIndex
-    TxIndex  = 0;
-
-    // init size
-    TxBufferSize = dstBufferSize;
+    // start and end of SLIP message must fit
+    if (dstBufferSize < 2)
+        return -1;
 
     // send start of SLIP message
-    StoreTxByte(SLIP_END);
+    *dstPtr++ = SLIP_END;
 
-    // iterate over all message bytes
-    while(msgLength--)
+    while(srcPtr < srcEnd)
     {
-        switch (*srcPtr)
+        // clean block: copy up to the next special byte at once
+        if ((srcEnd - srcPtr >= SLIP_BLOCK_SIZE) && !HasSpecial(srcPtr))
         {
-                case SLIP_END:
-                    StoreTxByte(SLIP_ESC);
-                    StoreTxByte(SLIP_ESC_END);
-                    break;
+            const UINT8* special = FindSpecial(srcPtr + SLIP_BLOCK_SIZE, srcEnd);
+            size_t       run     = special - srcPtr;
 
-                case SLIP_ESC:
-                    StoreTxByte(SLIP_ESC);
-                    StoreTxByte(SLIP_ESC_ESC);
-                    break;
+            if (run > (size_t)(dstEnd - dstPtr))
+                return -1;
 
-                default:
-                    StoreTxByte(*srcPtr);
-                    break;
+            memcpy(dstPtr, srcPtr, run);
+            dstPtr += run;
+            srcPtr  = (UINT8*)special;
+            continue;
+        }
+
+        // short tail or block with special bytes: byte by byte
+        const UINT8* blockEnd = (srcEnd - srcPtr > SLIP_BLOCK_SIZE) ? srcPtr + SLIP_BLOCK_SIZE : srcEnd;
+
+        while(srcPtr < blockEnd)
+        {
+            // room for an escape sequence
+            if (dstEnd - dstPtr < 2)
+                return -1;
+
+            switch (*srcPtr)
+            {
+                    case SLIP_END:
+                        *dstPtr++ = SLIP_ESC;
+                        *dstPtr++ = SLIP_ESC_END;
+                        break;
+
+                    case SLIP_ESC:
+                        *dstPtr++ = SLIP_ESC;
+                        *dstPtr++ = SLIP_ESC_ESC;
+                        break;
+
+                    default:
+                        *dstPtr++ = *srcPtr;
+                        break;
+            }
+            // next byte
+            srcPtr++;
         }
-        // next byte
-        srcPtr++;
     }
 
     // send end of SLIP message
-    StoreTxByte(SLIP_END);
-
-    // length ok ?
-    if (TxIndex <= TxBufferSize)
-        return TxIndex;
+    if (dstPtr >= dstEnd)
+        return -1;
 
-    // return tx length error
-    return -1;
-}
+    *dstPtr++ = SLIP_END;
 
-void
-TComSlip::StoreTxByte(UINT8 txByte)
-{
-  if (TxIndex < TxBufferSize)
-      TxBuffer[TxIndex++] = txByte;
+    return (int)(dstPtr - dstBuffer);
 }
 
 //------------------------------------------------------------------------------
@@ -159,12 +243,30 @@ TComSlip::SetRxBuffer(UINT8* rxBuffer, UINT16  rxBufferSize)
 void
 TComSlip::DecodeData(UINT8* rxData, UINT16 length)
 {
-    // init result
-    //int result = 0;
+    const UINT8* rxEnd = rxData + length;
 
     // iterate over all received bytes
-    while(length--)
+    while(rxData < rxEnd)
     {
+        if (RxState == SLIPDEC_IN_FRAME_STATE)
+        {
+            // clean block: store up to the next special byte at once
+            if ((rxEnd - rxData >= SLIP_BLOCK_SIZE) && !HasSpecial(rxData))
+            {
+                const UINT8* special = FindSpecial(rxData + SLIP_BLOCK_SIZE, rxEnd);
+
+                StoreRxData(rxData, (UINT16)(special - rxData));
+                rxData = (UINT8*)special;
+            }
+
+            // short run: byte by byte
+            while((rxData < rxEnd) && (*rxData != SLIP_END) && (*rxData != SLIP_ESC))
+                StoreRxByte(*rxData++);
+
+            if (rxData == rxEnd)
+                break;
+        }
+
         // get rxByte
         UINT8 rxByte = *rxData++;
 
@@ -268,6 +370,26 @@ TComSlip::StoreRxByte(UINT8 rxByte)
         RxBuffer[RxIndex++] = rxByte;
 }
 
+//------------------------------------------------------------------------------
+//
+//  StoreRxData
+//
+//  @brief: store SLIP decoded bytes, bytes beyond RxBufferSize are dropped
+//
+//------------------------------------------------------------------------------
+
+void
+TComSlip::StoreRxData(const UINT8* rxData, UINT16 length)
+{
+    UINT16 free = RxIndex < RxBufferSize ? RxBufferSize - RxIndex : 0;
+
+    if (length > free)
+        length = free;
+
+    memcpy(RxBuffer + RxIndex, rxData, length);
+    RxIndex += length;
+}
+
 //------------------------------------------------------------------------------
 // end of file
 //------------------------------------------------------------------------------
@@ -54,16 +54,18 @@ class TComSlip
 
     void            RegisterClient(TComSlipClient* client) { RxClient = client; }
 
+    // returns the frame length or -1 if the frame does not fit into dstBuffer
     int             EncodeData(UINT8* dstBuffer, UINT16 dstBufferSize, UINT8* srcBuffer, UINT16 length);
 
     bool            SetRxBuffer(UINT8*  rxBuffer, UINT16 rxbufferSize);
 
+    // decodes into the buffer passed by SetRxBuffer / ProcessRxMessage
     void            DecodeData(UINT8* rxData, UINT16 length);
 
     private:
 
-    void            StoreTxByte(UINT8 txByte);
     void            StoreRxByte(UINT8 rxByte);
+    void            StoreRxData(const UINT8* rxData, UINT16 length);
 
     private:
 
@@ -81,15 +83,6 @@ class TComSlip
 
     // client for received messages
     TComSlipClient* RxClient;
-
-    // pointer to Txbuffer
-    UINT8*          TxBuffer;
-
-    // size of TxBuffer
-    UINT16          TxBufferSize;
-
-    // tx buffer index
-    UINT16          TxIndex;
 };
 
 #endif // COMSLIP_H
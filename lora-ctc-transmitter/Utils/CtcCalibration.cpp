@@ -0,0 +1,445 @@
+//------------------------------------------------------------------------------
+//
+//	File:		CtcCalibration.cpp
+//
+//	Abstract:	CTC Code Table and Closed-Loop Calibration Class Implementation
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//
+//  Include Files
+//
+//------------------------------------------------------------------------------
+
+#include "CtcCalibration.h"
+#include "evlog.h"
+#include <stdlib.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+//
+//  TCtcCodeTable - Class Constructor
+//
+//------------------------------------------------------------------------------
+
+TCtcCodeTable::TCtcCodeTable()
+{
+    Codes = 0;
+    memset(Length, 0, sizeof(Length));
+    memset(Offset, 0, sizeof(Offset));
+}
+
+//------------------------------------------------------------------------------
+//
+//  SetLinear
+//
+//  @brief: build the hand-tuned default table
+//
+//------------------------------------------------------------------------------
+
+void
+TCtcCodeTable::SetLinear(int codes, const UINT8* lengths, UINT32 offset0, UINT32 step)
+{
+    if (codes > CTC_MAX_CODES)
+        codes = CTC_MAX_CODES;
+
+    Codes = codes;
+    for(int c = 0; c < codes; c++)
+    {
+        Length[c] = lengths[c];
+        Offset[c] = offset0 - c * step;
+    }
+}
+
+//------------------------------------------------------------------------------
+//
+//  Load
+//
+//  @brief: read table, '#' starts a comment line
+//
+//------------------------------------------------------------------------------
+
+bool
+TCtcCodeTable::Load(const char* fileName)
+{
+    FILE* in = fopen(fileName, "r");
+    char  line[128];
+    TCtcCodeTable table;
+
+    if (!in)
+        return false;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        int code, length;
+        unsigned offset;
+
+        if (line[0] == '#')
+            continue;
+        if (sscanf(line, "%d %d %u", &code, &length, &offset) != 3)
+            continue;
+
+        // codes must be listed in order
+        if ((code != table.Codes) || (code >= CTC_MAX_CODES) ||
+            (length < CTC_MIN_LENGTH) || (length > CTC_MAX_LENGTH))
+        {
+            fclose(in);
+            return false;
+        }
+        table.Length[code] = (UINT8)length;
+        table.Offset[code] = offset;
+        table.Codes++;
+    }
+    fclose(in);
+
+    // keep current table on error
+    if (!table.Codes)
+        return false;
+
+    *this = table;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//
+//  Save
+//
+//------------------------------------------------------------------------------
+
+bool
+TCtcCodeTable::Save(const char* fileName) const
+{
+    FILE* out = fopen(fileName, "w");
+
+    if (!out)
+        return false;
+
+    fprintf(out, "# code length offset_us\n");
+    for(int c = 0; c < Codes; c++)
+        fprintf(out, "%d %u %u\n", c, Length[c], Offset[c]);
+
+    return fclose(out) == 0;
+}
+
+void
+TCtcCodeTable::Print(FILE* out) const
+{
+    for(int c = 0; c < Codes; c++)
+        fprintf(out, "code %2d: len=%3u offset=%5u us\n", c, Length[c], Offset[c]);
+}
+
+//------------------------------------------------------------------------------
+//
+//  TCtcCalibration - Class Constructor
+//
+//------------------------------------------------------------------------------
+
+TCtcCalibration::TCtcCalibration(int codes, int block, UINT32 frameLength)
+{
+    Codes       = codes;
+    Block       = block > 0 ? block : 1;
+    FrameLength = frameLength;
+    NumSamples  = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+//  ParseLog
+//
+//  @brief: collect CTC_CAL records of the event log ("@" + base64, see
+//          evlog.h) and "[ASN=x] CTC-CAL: code width start" lines of nodes
+//          built without it, any prefix added by serialdump or a logger
+//          is skipped
+//
+//------------------------------------------------------------------------------
+
+int
+TCtcCalibration::ParseLog(FILE* in)
+{
+    char line[256];
+
+    while (fgets(line, sizeof(line), in) && NumSamples < CTC_CAL_MAX_SAMPLES)
+    {
+        const char* asn = strstr(line, "[ASN=");
+        const char* cal = strstr(line, "CTC-CAL:");
+        unsigned long a;
+        int code;
+        unsigned width, start;
+        Event ev;
+
+        if (parse(line, &ev))
+        {
+            if (ev.type != CTC_CAL)
+                continue;
+            TSample& s = Samples[NumSamples++];
+            s.Asn   = ev.asn;
+            s.Code  = (int8_t)ev.flow;
+            s.Width = ev.seq;
+            s.Start = (UINT16)ev.arg;
+            continue;
+        }
+        if (!asn || !cal)
+            continue;
+        if (sscanf(asn, "[ASN=%lu]", &a) != 1)
+            continue;
+        if (sscanf(cal, "CTC-CAL: %d %u %u", &code, &width, &start) != 3)
+            continue;
+
+        TSample& s = Samples[NumSamples++];
+        s.Asn   = (UINT32)a;
+        s.Code  = code;
+        s.Width = (UINT16)width;
+        s.Start = (UINT16)start;
+    }
+    return NumSamples;
+}
+
+//------------------------------------------------------------------------------
+//
+//  FindPhase
+//
+//  @brief: offset of the first logged frame within the code sequence
+//
+//          Decoded codes cannot be trusted before calibration, so the phase
+//          is the one that groups pulse widths tightest per sent code
+//
+//------------------------------------------------------------------------------
+
+int
+TCtcCalibration::FindPhase() const
+{
+    double sum[CTC_MAX_CODES], sum2[CTC_MAX_CODES];
+    int    num[CTC_MAX_CODES];
+    double total = 0, total2 = 0;
+    int    count = 0;
+    double bestSSE = -1;
+    int    best = -1;
+
+    for(int i = 0; i < NumSamples; i++)
+    {
+        if (!Samples[i].Width)
+            continue;
+        total  += Samples[i].Width;
+        total2 += (double)Samples[i].Width * Samples[i].Width;
+        count++;
+    }
+    if (count < 2 || Codes > CTC_MAX_CODES)
+        return -1;
+
+    for(int phase = 0; phase < Codes * Block; phase++)
+    {
+        memset(sum,  0, sizeof(sum));
+        memset(sum2, 0, sizeof(sum2));
+        memset(num,  0, sizeof(num));
+
+        for(int i = 0; i < NumSamples; i++)
+        {
+            UINT32 frame = (Samples[i].Asn - Samples[0].Asn + FrameLength / 2) / FrameLength;
+            int    c     = ExpectedCode(frame + phase);
+
+            if (!Samples[i].Width)
+                continue;
+            sum[c]  += Samples[i].Width;
+            sum2[c] += (double)Samples[i].Width * Samples[i].Width;
+            num[c]++;
+        }
+
+        // within-code sum of squared errors
+        double sse = 0;
+        for(int c = 0; c < Codes; c++)
+        {
+            if (num[c])
+                sse += sum2[c] - sum[c] * sum[c] / num[c];
+        }
+        if (best < 0 || sse < bestSSE)
+        {
+            bestSSE = sse;
+            best    = phase;
+        }
+    }
+
+    // sent codes must explain most of the width variance, otherwise the
+    // log does not belong to this sequence or the node lost sync
+    double variance = total2 - total * total / count;
+    if (variance <= 0 || bestSSE > variance / 2)
+        return -1;
+
+    // shifting by whole blocks only renames the groups: code 0 is the
+    // group right after the largest drop of the mean width
+    memset(sum, 0, sizeof(sum));
+    memset(num, 0, sizeof(num));
+    for(int i = 0; i < NumSamples; i++)
+    {
+        UINT32 frame = (Samples[i].Asn - Samples[0].Asn + FrameLength / 2) / FrameLength;
+        int    c     = ExpectedCode(frame + best);
+
+        if (!Samples[i].Width)
+            continue;
+        sum[c] += Samples[i].Width;
+        num[c]++;
+    }
+
+    int    first = 0;
+    double drop  = 0;
+    for(int c = 0; c < Codes; c++)
+    {
+        int prev = (c + Codes - 1) % Codes;
+
+        if (!num[c] || !num[prev])
+            continue;
+
+        double d = sum[prev] / num[prev] - sum[c] / num[c];
+        if (d > drop)
+        {
+            drop  = d;
+            first = c;
+        }
+    }
+
+    return (best + Codes * Block - first * Block) % (Codes * Block);
+}
+
+//------------------------------------------------------------------------------
+//
+//  Median
+//
+//------------------------------------------------------------------------------
+
+static int
+CompareUINT32(const void* a, const void* b)
+{
+    UINT32 x = *(const UINT32*)a, y = *(const UINT32*)b;
+    return x < y ? -1 : x > y;
+}
+
+int
+TCtcCalibration::Median(UINT32* values, int count)
+{
+    qsort(values, count, sizeof(UINT32), CompareUINT32);
+    return values[count / 2];
+}
+
+//------------------------------------------------------------------------------
+//
+//  Fit
+//
+//  @brief: per sent code take median pulse width W and start S, fit
+//
+//              W = a + b * length          (air time)
+//              S - offset = l0 + l1 * length   (serial + radio latency)
+//
+//          then choose for every new code the length whose width is
+//          closest to the center of its decoder bin, and an offset that
+//          ends all pulses at the mean end time measured so far
+//
+//------------------------------------------------------------------------------
+
+bool
+TCtcCalibration::Fit(const TCtcCodeTable& sent, TCtcCodeTable& result, int codes, UINT32 firstBin, UINT32 step)
+{
+    static UINT32 width[CTC_CAL_MAX_SAMPLES], start[CTC_CAL_MAX_SAMPLES];
+    double sx = 0, sy = 0, sxx = 0, sxy = 0, sd = 0, sxd = 0, end = 0;
+    int n = 0;
+
+    if (codes > CTC_MAX_CODES)
+        codes = CTC_MAX_CODES;
+
+    int phase = FindPhase();
+    if (phase < 0)
+    {
+        printf("calibration: code sequence not found in %d samples\n", NumSamples);
+        return false;
+    }
+
+    for(int c = 0; c < Codes && c < sent.Codes; c++)
+    {
+        int count = 0;
+
+        for(int i = 0; i < NumSamples; i++)
+        {
+            UINT32 frame = (Samples[i].Asn - Samples[0].Asn + FrameLength / 2) / FrameLength;
+
+            // timeouts carry no width
+            if ((ExpectedCode(frame + phase) != c) || !Samples[i].Width)
+                continue;
+
+            width[count] = Samples[i].Width;
+            start[count] = Samples[i].Start;
+            count++;
+        }
+        if (count < CTC_CAL_MIN_SAMPLES)
+        {
+            printf("calibration: code %2d: %d samples, skipped\n", c, count);
+            continue;
+        }
+
+        double x = sent.Length[c];
+        double w = Median(width, count);
+        double d = Median(start, count) - (double)sent.Offset[c];
+
+        printf("calibration: code %2d: len=%3u n=%4d width=%5.0f start=%5.0f us\n",
+               c, sent.Length[c], count, w, d + sent.Offset[c]);
+
+        sx  += x;  sy  += w;
+        sxx += x * x;  sxy += x * w;
+        sd  += d;  sxd += x * d;
+        end += d + sent.Offset[c] + w;
+        n++;
+    }
+
+    double det = n * sxx - sx * sx;
+    if (n < 2 || det <= 0)
+    {
+        printf("calibration: need two codes with distinct lengths\n");
+        return false;
+    }
+
+    double b  = (n * sxy - sx * sy) / det;
+    double a  = (sy - b * sx) / n;
+    double l1 = (n * sxd - sx * sd) / det;
+    double l0 = (sd - l1 * sx) / n;
+    end /= n;
+
+    printf("calibration: width = %.1f + %.2f * len, latency = %.1f + %.2f * len [us]\n", a, b, l0, l1);
+
+    if (b <= 0)
+    {
+        printf("calibration: width does not grow with length\n");
+        return false;
+    }
+
+    int prev = CTC_MIN_LENGTH - 1;
+    for(int c = 0; c < codes; c++)
+    {
+        double target = (double)firstBin + c * (double)step - step / 2.0;
+        int length = (int)((target - a) / b + 0.5);
+
+        // lengths must stay distinct to keep one cache entry per code
+        if (length <= prev)
+            length = prev + 1;
+        if (length > CTC_MAX_LENGTH)
+        {
+            printf("calibration: code %d needs length > %d\n", c, CTC_MAX_LENGTH);
+            return false;
+        }
+        prev = length;
+
+        double w      = a + b * length;
+        double offset = end - w - (l0 + l1 * length);
+
+        result.Length[c] = (UINT8)length;
+        result.Offset[c] = offset > 0 ? (UINT32)(offset + 0.5) : 0;
+    }
+    result.Codes = codes;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
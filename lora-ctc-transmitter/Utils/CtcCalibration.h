@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+//
+//	File:		CtcCalibration.h
+//
+//	Abstract:	CTC Code Table and Closed-Loop Calibration Class Declaration
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+#ifndef CTCCALIBRATION_H
+#define CTCCALIBRATION_H
+
+//------------------------------------------------------------------------------
+//
+// Include Files
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include "WMDefs.h"
+
+//------------------------------------------------------------------------------
+//
+// General Definitions
+//
+//------------------------------------------------------------------------------
+
+// max. number of codes in a table
+#define CTC_MAX_CODES               16
+
+// max. number of node log samples used for a fit
+#define CTC_CAL_MAX_SAMPLES         4096
+
+// min. samples per code for a valid fit
+#define CTC_CAL_MIN_SAMPLES         3
+
+// payload length limits of a CTC frame
+#define CTC_MIN_LENGTH              4
+#define CTC_MAX_LENGTH              240
+
+//------------------------------------------------------------------------------
+//
+// TCtcCodeTable - payload length and tx offset per code
+//
+//------------------------------------------------------------------------------
+
+class TCtcCodeTable
+{
+public:
+                TCtcCodeTable();
+
+    // hand-tuned table: offset of code c is offset0 - c * step
+    void        SetLinear(int codes, const UINT8* lengths, UINT32 offset0, UINT32 step);
+
+    // text file, one "code length offset" line per code
+    bool        Load(const char* fileName);
+    bool        Save(const char* fileName) const;
+    void        Print(FILE* out) const;
+
+public:
+    int         Codes;
+
+    // LoRa payload length
+    UINT8       Length[CTC_MAX_CODES];
+
+    // tx start relative to slot start [us]
+    UINT32      Offset[CTC_MAX_CODES];
+};
+
+//------------------------------------------------------------------------------
+//
+// TCtcCalibration - fit a code table from decoded node pulses
+//
+// The transmitter sends every code for Block consecutive APP frames, cycling
+// through all codes. The node logs one "CTC-CAL: code width start" line per
+// APP frame (CTC_CONF_CALIBRATION). Frames are aligned by ASN, the phase of
+// the code sequence is recovered from the decoded codes.
+//
+//------------------------------------------------------------------------------
+
+class TCtcCalibration
+{
+public:
+                TCtcCalibration(int codes, int block, UINT32 frameLength);
+
+    // code to send in APP frame number frame
+    int         ExpectedCode(UINT32 frame) const { return (frame / Block) % Codes; }
+
+    // number of APP frames for a given number of rounds
+    UINT32      Frames(int rounds) const { return (UINT32)rounds * Block * Codes; }
+
+    // read serialdump output of the node
+    int         ParseLog(FILE* in);
+
+    // fit a table of codes entries from the samples of the sent table,
+    // decoder bins end at firstBin + c * step [us]
+    bool        Fit(const TCtcCodeTable& sent, TCtcCodeTable& result, int codes, UINT32 firstBin, UINT32 step);
+
+private:
+    typedef struct
+    {
+        UINT32  Asn;
+        int     Code;
+        UINT16  Width;
+        UINT16  Start;
+    }TSample;
+
+    int         FindPhase() const;
+    static int  Median(UINT32* values, int count);
+
+private:
+    int         Codes;
+    int         Block;
+    UINT32      FrameLength;
+
+    int         NumSamples;
+    TSample     Samples[CTC_CAL_MAX_SAMPLES];
+};
+
+#endif // CTCCALIBRATION_H
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
@@ -0,0 +1,222 @@
+//------------------------------------------------------------------------------
+//
+//	File:		DownlinkQueue.cpp
+//
+//	Abstract:	CTC Downlink Message Queue and Segmentation Class Implementation
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//
+//  Include Files
+//
+//------------------------------------------------------------------------------
+
+#include "DownlinkQueue.h"
+#include <stdio.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+//
+//  TDownlinkQueue - Class Constructor
+//
+//------------------------------------------------------------------------------
+
+TDownlinkQueue::TDownlinkQueue()
+{
+    Count      = 0;
+    Order      = 0;
+    ServeCount = 0;
+    memset(Served, 0, sizeof(Served));
+}
+
+//------------------------------------------------------------------------------
+//
+//  Push
+//
+//------------------------------------------------------------------------------
+
+bool
+TDownlinkQueue::Push(const TDownlinkMessage& msg)
+{
+    if ((msg.Flow >= CTC_DL_MAX_FLOWS) || (msg.Command > CTC_DL_MAX_CMD))
+        return false;
+
+    std::lock_guard<std::mutex> guard(Lock);
+
+    if (Count >= DL_QUEUE_SIZE)
+        return false;
+
+    Queue[Count] = msg;
+    Queue[Count].Order = Order++;
+    Count++;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//
+//  Pop
+//
+//  @brief: highest priority first, then the flow served longest ago, then
+//          the oldest message
+//
+//------------------------------------------------------------------------------
+
+bool
+TDownlinkQueue::Pop(UINT8 tx, TDownlinkMessage& msg)
+{
+    // slot loops must not wait for the command thread
+    std::unique_lock<std::mutex> guard(Lock, std::try_to_lock);
+    int best = -1;
+
+    if (!guard.owns_lock())
+        return false;
+
+    for(int i = 0; i < Count; i++)
+    {
+        const TDownlinkMessage& m = Queue[i];
+
+        if ((m.Tx != DL_TX_ANY) && (m.Tx != tx))
+            continue;
+        if (best < 0)
+        {
+            best = i;
+            continue;
+        }
+
+        const TDownlinkMessage& b = Queue[best];
+        if (m.Priority != b.Priority)
+        {
+            if (m.Priority > b.Priority)
+                best = i;
+        }
+        else if (Served[m.Flow] != Served[b.Flow])
+        {
+            if (Served[m.Flow] < Served[b.Flow])
+                best = i;
+        }
+        else if (m.Order < b.Order)
+            best = i;
+    }
+    if (best < 0)
+        return false;
+
+    msg = Queue[best];
+    Served[msg.Flow] = ++ServeCount;
+
+    // keep the remaining messages packed
+    Queue[best] = Queue[--Count];
+    return true;
+}
+
+int
+TDownlinkQueue::Size()
+{
+    return Count;
+}
+
+//------------------------------------------------------------------------------
+//
+//  Parse
+//
+//------------------------------------------------------------------------------
+
+bool
+TDownlinkQueue::Parse(const char* line, TDownlinkMessage& msg)
+{
+    unsigned flow, seqNo, command, priority = 0, tx = DL_TX_ANY;
+
+    if (sscanf(line, "%u %u %u %u %u", &flow, &seqNo, &command, &priority, &tx) < 3)
+        return false;
+    if ((flow >= CTC_DL_MAX_FLOWS) || (seqNo > 0xFFFF) || (command > CTC_DL_MAX_CMD) ||
+        (priority > 0xFF) || (tx > DL_TX_ANY))
+        return false;
+
+    msg.Flow     = (UINT8)flow;
+    msg.SeqNo    = (UINT16)seqNo;
+    msg.Command  = (UINT16)command;
+    msg.Priority = (UINT8)priority;
+    msg.Tx       = (UINT8)tx;
+    msg.Order    = 0;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//
+//  TDownlinkStream - Class Constructor
+//
+//------------------------------------------------------------------------------
+
+TDownlinkStream::TDownlinkStream(int repeats)
+{
+    Messages = 0;
+    NumCodes = 0;
+    Pos      = 0;
+    Sent     = 0;
+    Repeats  = repeats > 0 ? repeats : 1;
+}
+
+//------------------------------------------------------------------------------
+//
+//  NextCode
+//
+//------------------------------------------------------------------------------
+
+int
+TDownlinkStream::NextCode(TDownlinkQueue& queue, UINT8 tx)
+{
+    if (Pos >= NumCodes)
+    {
+        if (queue.Pop(tx, Msg))
+        {
+            Segment();
+            Sent = 1;
+            Messages++;
+        }
+        else if (NumCodes && (Sent < Repeats))
+        {
+            // spare slots: send the last message again
+            Pos = 0;
+            Sent++;
+        }
+        else
+            return -1;
+    }
+    return Codes[Pos++];
+}
+
+//------------------------------------------------------------------------------
+//
+//  Segment
+//
+//  @brief: message -> bell, header word, bell, command word, bell
+//
+//------------------------------------------------------------------------------
+
+void
+TDownlinkStream::Segment()
+{
+    const UINT32 words[CTC_DL_WORDS_MSG] =
+    {
+        (UINT32)CTC_DL_HEADER_WORD(Msg.Flow, Msg.SeqNo),
+        Msg.Command
+    };
+
+    NumCodes = 0;
+    for(int i = 0; i < CTC_DL_WORDS_MSG; i++)
+    {
+        Codes[NumCodes++] = ctc_cb_downlink.codes - 1;
+        NumCodes += ctc_cb_encode(&ctc_cb_downlink, words[i], &Codes[NumCodes]);
+    }
+    // close the command word
+    Codes[NumCodes++] = ctc_cb_downlink.codes - 1;
+    Pos = 0;
+}
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
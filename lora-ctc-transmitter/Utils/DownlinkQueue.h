@@ -0,0 +1,147 @@
+//------------------------------------------------------------------------------
+//
+//	File:		DownlinkQueue.h
+//
+//	Abstract:	CTC Downlink Message Queue and Segmentation Class Declaration
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+#ifndef DOWNLINKQUEUE_H
+#define DOWNLINKQUEUE_H
+
+//------------------------------------------------------------------------------
+//
+// Include Files
+//
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <mutex>
+#include "WMDefs.h"
+#include "ctc-codebook.h"
+
+//------------------------------------------------------------------------------
+//
+// General Definitions
+//
+//------------------------------------------------------------------------------
+
+// max. number of queued messages of all flows
+#define DL_QUEUE_SIZE               64
+
+// any transmitter may send the message
+#define DL_TX_ANY                   0xFF
+
+// codes of one segmented message: bell + word per word, closing bell
+#define DL_MAX_CODES                (CTC_DL_WORDS_MSG * (1 + CTC_CB_MAX_SYMBOLS) + 1)
+
+//------------------------------------------------------------------------------
+//
+// Downlink Message
+//
+//------------------------------------------------------------------------------
+
+typedef struct
+{
+    // flow id, 0 .. CTC_DL_MAX_FLOWS - 1
+    UINT8   Flow;
+
+    // sequence number, sent modulo CTC_DL_SEQ_MOD
+    UINT16  SeqNo;
+
+    // command, 0 .. CTC_DL_MAX_CMD
+    UINT16  Command;
+
+    // higher values are sent first
+    UINT8   Priority;
+
+    // transmitter id or DL_TX_ANY
+    UINT8   Tx;
+
+    // enqueue order, set by Push()
+    UINT32  Order;
+}TDownlinkMessage;
+
+//------------------------------------------------------------------------------
+//
+// TDownlinkQueue - priority queue shared by all transmitters
+//
+// Messages are sent by priority; flows of equal priority take turns, and
+// messages of one flow keep their order. Push() is called by the command
+// thread, Pop() by the slot loops and never blocks.
+//
+//------------------------------------------------------------------------------
+
+class TDownlinkQueue
+{
+public:
+                TDownlinkQueue();
+
+    // false if the queue is full or a field is out of range
+    bool        Push(const TDownlinkMessage& msg);
+
+    // next message for transmitter tx, false if none or the queue is locked
+    bool        Pop(UINT8 tx, TDownlinkMessage& msg);
+
+    // queued messages, never blocks
+    int         Size();
+
+    // "flow seqno command [priority [tx]]"
+    static bool Parse(const char* line, TDownlinkMessage& msg);
+
+private:
+    std::mutex          Lock;
+    std::atomic<int>    Count; // written under Lock, read by Size()
+    UINT32              Order;
+
+    // pop stamp of the last message per flow
+    UINT32              Served[CTC_DL_MAX_FLOWS];
+    UINT32              ServeCount;
+
+    TDownlinkMessage    Queue[DL_QUEUE_SIZE];
+};
+
+//------------------------------------------------------------------------------
+//
+// TDownlinkStream - code sequence of one transmitter's APP slots
+//
+// A message is a header word (flow, seqno) and a command word of the
+// ctc_cb_downlink codebook, each led by a bell, and a closing bell that lets
+// the node decode the last word. While idle, APP slots stay silent. Without
+// other queued messages a message is repeated up to Repeats times in total,
+// the node drops the copies by seqno.
+//
+//------------------------------------------------------------------------------
+
+class TDownlinkStream
+{
+public:
+                TDownlinkStream(int repeats = 1);
+
+    // code for the next APP slot, -1: nothing to send
+    int         NextCode(TDownlinkQueue& queue, UINT8 tx);
+
+    // sent messages, without repetitions
+    UINT32      Messages;
+
+private:
+    void        Segment();
+
+private:
+    TDownlinkMessage    Msg;
+    int8_t              Codes[DL_MAX_CODES];
+    int                 NumCodes;
+    int                 Pos;
+    int                 Sent;
+    int                 Repeats;
+};
+
+#endif // DOWNLINKQUEUE_H
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
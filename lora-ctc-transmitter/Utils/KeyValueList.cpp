@@ -41,56 +41,59 @@ TKeyValueList::TKeyValueList()
 
 void
 TKeyValueList::AddHexKeyValue(
-                    const QString&      key,
+                    std::string_view    key,
                     UINT8               value)
 {
-    QString valueString = QString("%1").arg(value, 2, 16, QLatin1Char('0')).toUpper();
-
-    append(key + ":" + valueString);
+    appendFormat("%.*s:%02X", (int)key.size(), key.data(), value);
 }
 
 void
 TKeyValueList::AddHexKeyValue(
-                    const QString&      key,
+                    std::string_view    key,
                     UINT16              value)
 {
-    QString valueString = QString("%1").arg(value, 4, 16, QLatin1Char('0')).toUpper();
+    appendFormat("%.*s:%04X", (int)key.size(), key.data(), value);
+}
 
-    append(key + ":" + valueString);
+void
+TKeyValueList::AddKeyValue(
+                    std::string_view    key,
+                    UINT32              value)
+{
+    appendFormat("%.*s:%u", (int)key.size(), key.data(), (unsigned)value);
 }
 
 void
 TKeyValueList::AddKeyValue(
-                    const QString&      key,
+                    std::string_view    key,
                     int                 value)
 {
-    QString valueString = QString("%1").arg(value);
-
-    append(key + ":" + valueString);
+    appendFormat("%.*s:%d", (int)key.size(), key.data(), value);
 }
 
 void
 TKeyValueList::AddKeyValue(
-                    const QString&      key,
-                    const QString&      value)
+                    std::string_view    key,
+                    std::string_view    value)
 {
-    append(key + ":" + value);
+    appendFormat("%.*s:%.*s", (int)key.size(), key.data(), (int)value.size(), value.data());
 }
 
 
 void
 TKeyValueList::AddHexKeyValue(
-                    const QString&      key,
+                    std::string_view    key,
                     const UINT8*        payload,
                     int                 length)
 {
-    QString payloadStr;
+    // up to 255 bytes: "XX " each
+    TFixedString<800> payloadStr;
 
     for(int i = 0; i < length; i++)
-        payloadStr.append(QString("%1 ").arg(payload[i], 2, 16, QLatin1Char('0')).toUpper());
-    payloadStr.chop(1);
+        payloadStr.AppendFormat("%02X ", payload[i]);
+    payloadStr.Chop(1);
 
-    append(key + ":" + payloadStr);
+    AddKeyValue(key, payloadStr);
 }
 
 //------------------------------------------------------------------------------
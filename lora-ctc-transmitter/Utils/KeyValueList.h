@@ -22,7 +22,7 @@
 //
 //------------------------------------------------------------------------------
 
-#include <QStringList>
+#include "StringList.h"
 #include "WMDefs.h"
 
 //------------------------------------------------------------------------------
@@ -31,29 +31,29 @@
 //
 //------------------------------------------------------------------------------
 
-class TKeyValueList : public QStringList
+class TKeyValueList : public TStringList
 {
 public:
     TKeyValueList();
 
-    void         AddHexKeyValue(const QString&      key,
+    void         AddHexKeyValue(std::string_view    key,
                                 UINT8               value);
 
-    void         AddHexKeyValue(const QString&      key,
+    void         AddHexKeyValue(std::string_view    key,
                                 UINT16              value);
 
-    void         AddHexKeyValue(const QString&      key,
+    void         AddHexKeyValue(std::string_view    key,
                                 const UINT8*        payload,
                                 int                 length);
 
-    void         AddKeyValue(const QString&      key,
+    void         AddKeyValue(std::string_view    key,
                              UINT32              value);
 
-    void         AddKeyValue(const QString&      key,
+    void         AddKeyValue(std::string_view    key,
                              int                 value);
 
-    void         AddKeyValue(const QString&      key,
-                             const QString&      value);
+    void         AddKeyValue(std::string_view    key,
+                             std::string_view    value);
 
 };
 
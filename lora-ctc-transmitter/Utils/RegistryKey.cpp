@@ -17,7 +17,26 @@
 #include "RegistryKey.h"
 
 // only supported for windows platforms !
-#ifdef Q_OS_WIN
+#ifdef  _WIN32
+
+// UTF-8 name -> terminated wide string
+static void
+ToWide(std::string_view name, wchar_t* wide, int size)
+{
+    int length = MultiByteToWideChar(CP_UTF8, 0, name.data(), (int)name.size(), wide, size - 1);
+    wide[length > 0 ? length : 0] = 0;
+}
+
+// terminated wide string -> UTF-8, appended to text
+static void
+FromWide(const wchar_t* wide, TStringBuffer& text)
+{
+    char name[MAX_KEY_LENGTH * 3];
+    int  length = WideCharToMultiByte(CP_UTF8, 0, wide, -1, name, sizeof(name), NULL, NULL);
+
+    if (length > 0)
+        text.Append(std::string_view(name, length - 1));
+}
 
 TRegistryKey::TRegistryKey()
 {
@@ -43,15 +62,14 @@ TRegistryKey::LocalMachine()
 }
 
 TRegistryKey*
-TRegistryKey::OpenSubKey(const QString& keyName)
+TRegistryKey::OpenSubKey(std::string_view keyName)
 {
     if(!HKey)
         return 0;
 
     wchar_t subKeyName[1024];
 
-    int length = keyName.toWCharArray(subKeyName);
-    subKeyName[length] = 0;
+    ToWide(keyName, subKeyName, 1024);
 
     HKEY hNewKey = 0;
 
@@ -66,7 +84,7 @@ TRegistryKey::OpenSubKey(const QString& keyName)
     return 0;
 }
 
-const QStringList&
+const TStringList&
 TRegistryKey::GetSubKeyNames()
 {
     TCHAR    achKey[MAX_KEY_LENGTH];    // buffer for subkey name
@@ -121,8 +139,9 @@ TRegistryKey::GetSubKeyNames()
 
             if (retCode == ERROR_SUCCESS)
             {
-                QString keyString = QString::fromWCharArray(achKey);
+                TFixedString<MAX_KEY_LENGTH * 3> keyString;
 
+                FromWide(achKey, keyString);
                 SubKeys.append(keyString);
             }
             else
@@ -133,7 +152,7 @@ TRegistryKey::GetSubKeyNames()
 }
 
 int
-TRegistryKey::GetKeyValues(QStringList& list)
+TRegistryKey::GetKeyValues(TStringList& list)
 {
     //TCHAR    achKey[MAX_KEY_LENGTH];    // buffer for subkey name
     //DWORD    cbName;                    // size of name string
@@ -188,7 +207,9 @@ TRegistryKey::GetKeyValues(QStringList& list)
 
             if (retCode == ERROR_SUCCESS )
             {
-                QString keyString = QString::fromWCharArray(achValue);
+                TFixedString<MAX_KEY_LENGTH * 3> keyString;
+
+                FromWide(achValue, keyString);
 
      //           MainWindow->showMessage(keyString);
 
@@ -199,10 +220,10 @@ TRegistryKey::GetKeyValues(QStringList& list)
     return list.count();
 }
 
-const QString&
-TRegistryKey::GetValue(const QString keyName)
+std::string_view
+TRegistryKey::GetValue(std::string_view keyName)
 {
-    Value = QString("");
+    Value.Clear();
 
     WCHAR   value_data[256];
     DWORD   value_size = 256;
@@ -210,8 +231,7 @@ TRegistryKey::GetValue(const QString keyName)
 
     wchar_t key[1024];
 
-    int length = keyName.toWCharArray(key);
-    key[length] = 0;
+    ToWide(keyName, key, 1024);
 
     DWORD retcode = RegQueryValueEx(HKey,                   // HKEY (hkey) handle of key to query
                                     key,                    // LPSTR (lpValueName) address of name of value to query
@@ -223,7 +243,7 @@ TRegistryKey::GetValue(const QString keyName)
     if (retcode == ERROR_SUCCESS)
     {
 
-        Value = QString::fromWCharArray(value_data);
+        FromWide(value_data, Value);
     }
     return Value;
 }
@@ -16,12 +16,10 @@
 #ifndef REGISTRYKEY_H
 #define REGISTRYKEY_H
 
-#include <Qt>
-
 // only supported for windows platforms !
-#ifdef  Q_OS_WIN
+#ifdef  _WIN32
 
-#include <qstringlist.h>
+#include "StringList.h"
 #include <windows.h>
 
 #define MAX_KEY_LENGTH 256
@@ -42,18 +40,18 @@ public:
     virtual             ~TRegistryKey();
 
     void                LocalMachine();
-    TRegistryKey*       OpenSubKey(const QString& keyName);
-    const QStringList&  GetSubKeyNames();
-    int                 GetKeyValues(QStringList& list);
-    const QString&      GetValue(const QString keyName);
+    TRegistryKey*       OpenSubKey(std::string_view keyName);
+    const TStringList&  GetSubKeyNames();
+    int                 GetKeyValues(TStringList& list);
+    std::string_view    GetValue(std::string_view keyName);
 
 private:
 
 private:
     HKEY                HKey;
 
-    QStringList         SubKeys;
-    QString             Value;
+    TStringList         SubKeys;
+    TFixedString<256>   Value;
 };
 
 #endif // WINDOWS
@@ -14,12 +14,14 @@
 //------------------------------------------------------------------------------
 
 #include "SerialDevice.h"
+#include <string.h>
+#include <time.h>
 
-#ifdef Q_OS_WIN
+#ifdef  _WIN32
     // used to query COM ports
     #include "RegistryKey.h"
-#elif defined(Q_OS_MAC) || defined(Q_OS_LINUX)
-    #include <QDir>
+#elif defined(__APPLE__) || defined(__linux__)
+    #include <dirent.h>
 #endif
 
 //------------------------------------------------------------------------------
@@ -32,6 +34,10 @@ TSerialDevice::TSerialDevice()
 {
     // init handle
     ComHandle = INVALID_HANDLE_VALUE;
+
+    // no profiling
+    TxProfMode = SERIAL_TXPROF_OFF;
+    ResetTxStats();
 }
 
 //------------------------------------------------------------------------------
@@ -55,19 +61,19 @@ TSerialDevice::~TSerialDevice()
 //------------------------------------------------------------------------------
 
 bool
-TSerialDevice::Open(const QString& comPort, UINT32 baudRate, int bits, UINT8 parity)
+TSerialDevice::Open(std::string_view comPort, UINT32 baudRate, int bits, UINT8 parity)
 {
     if (ComHandle != INVALID_HANDLE_VALUE)
         Close();
 
-#ifdef Q_OS_WIN
-    char devName[80];
+#ifdef  _WIN32
+    TFixedString<80> devName;
 
     // check if COM Port is higher than COM9
-    strcpy(devName, "\\\\.\\");
-    strcat(devName, comPort.toUtf8());
+    devName.Append("\\\\.\\");
+    devName.Append(comPort);
 
-    ComHandle = CreateFileA(devName,
+    ComHandle = CreateFileA(devName.c_str(),
                             GENERIC_WRITE | GENERIC_READ,
                             0,
                             NULL,
@@ -115,7 +121,7 @@ TSerialDevice::Open(const QString& comPort, UINT32 baudRate, int bits, UINT8 par
         Close();
     }
 
-#elif defined( Q_OS_MAC )
+#elif defined(__APPLE__)
 
     // Open the serial port read/write, with no controlling terminal,
     // and don't wait for a connection.
@@ -123,10 +129,11 @@ TSerialDevice::Open(const QString& comPort, UINT32 baudRate, int bits, UINT8 par
     // be non-blocking.
     // See open(2) ("man 2 open") for details.
 
-    QString portName = QString("/dev/") + comPort;
-    QByteArray name  = portName.toLocal8Bit();
-    //const char* ptr = "/dev/tty.usbserial-IMST2"; //name.constData();
-    const char* ptr =name.constData();
+    TFixedString<80> portName;
+    portName.Append("/dev/");
+    portName.Append(comPort);
+    //const char* ptr = "/dev/tty.usbserial-IMST2";
+    const char* ptr = portName.c_str();
 
     ComHandle = ::open(ptr, O_RDWR | O_NOCTTY | O_NONBLOCK);
     if (ComHandle != INVALID_HANDLE_VALUE)
@@ -170,7 +177,7 @@ TSerialDevice::Open(const QString& comPort, UINT32 baudRate, int bits, UINT8 par
         }
         Close();
     }
-#elif defined( Q_OS_LINUX )
+#elif defined(__linux__)
 
     // Open the serial port read/write, with no controlling terminal,
     // and don't wait for a connection.
@@ -178,10 +185,11 @@ TSerialDevice::Open(const QString& comPort, UINT32 baudRate, int bits, UINT8 par
     // be non-blocking.
     // See open(2) ("man 2 open") for details.
 
-    QString portName = QString("/dev/") + comPort;
-    QByteArray name  = portName.toLocal8Bit();
-    //const char* ptr = "/dev/tty.usbserial-IMST2"; //name.constData();
-    const char* ptr =name.constData();
+    TFixedString<80> portName;
+    portName.Append("/dev/");
+    portName.Append(comPort);
+    //const char* ptr = "/dev/tty.usbserial-IMST2";
+    const char* ptr = portName.c_str();
 
     ComHandle = ::open(ptr, O_RDWR | O_NOCTTY | O_NONBLOCK);
     if (ComHandle != INVALID_HANDLE_VALUE)
@@ -238,7 +246,7 @@ TSerialDevice::Open(const QString& comPort, UINT32 baudRate, int bits, UINT8 par
 bool
 TSerialDevice::Close()
 {
-#ifdef Q_OS_WIN
+#ifdef  _WIN32
     if(ComHandle != INVALID_HANDLE_VALUE)
     {
         CancelIo(ComHandle);
@@ -250,7 +258,7 @@ TSerialDevice::Close()
         ComHandle = INVALID_HANDLE_VALUE;
         return true;
     }
-#elif defined( Q_OS_MAC )
+#elif defined(__APPLE__)
 
     if(ComHandle != INVALID_HANDLE_VALUE)
     {
@@ -259,7 +267,7 @@ TSerialDevice::Close()
         ComHandle = INVALID_HANDLE_VALUE;
         return true;
     }
-#elif defined( Q_OS_LINUX )
+#elif defined(__linux__)
 
     if(ComHandle != INVALID_HANDLE_VALUE)
     {
@@ -281,13 +289,20 @@ TSerialDevice::Close()
 //------------------------------------------------------------------------------
 
 bool
-TSerialDevice::SendData(UINT8* data, int txLength)
+TSerialDevice::SendData(UINT8* data, int txLength, int profLength)
 {
 
     if(ComHandle == INVALID_HANDLE_VALUE)
         return false;
 
-#ifdef Q_OS_WIN
+#ifndef _WIN32
+    if (TxProfMode != SERIAL_TXPROF_OFF)
+        return ProfiledWrite(data, txLength, profLength < 0 ? txLength : profLength);
+#else
+    (void)profLength;
+#endif
+
+#ifdef  _WIN32
     UINT32  numTxBytes;
     if(!WriteFile(ComHandle, data, txLength, (DWORD*)&numTxBytes, 0))
     {
@@ -298,7 +313,7 @@ TSerialDevice::SendData(UINT8* data, int txLength)
     {
         return true;
     }
-#elif defined( Q_OS_MAC )
+#elif defined(__APPLE__)
 
     size_t  numTxBytes = ::write(ComHandle, data, txLength);
 
@@ -307,7 +322,7 @@ TSerialDevice::SendData(UINT8* data, int txLength)
         return true;
     }
 
-#elif defined( Q_OS_LINUX )
+#elif defined(__linux__)
 
     size_t  numTxBytes = ::write(ComHandle, data, txLength);
 
@@ -321,6 +336,195 @@ TSerialDevice::SendData(UINT8* data, int txLength)
 
 }
 
+//------------------------------------------------------------------------------
+//
+//  SetTxProfiling
+//
+//  @brief  select profiling mode, see SERIAL_TXPROF_xxx
+//
+//------------------------------------------------------------------------------
+
+void
+TSerialDevice::SetTxProfiling(int mode)
+{
+#ifdef  _WIN32
+    (void)mode;
+#else
+    TxProfMode = mode;
+#endif
+}
+
+//------------------------------------------------------------------------------
+//
+//  ResetTxStats
+//
+//  @brief  clear all profiling samples
+//
+//------------------------------------------------------------------------------
+
+void
+TSerialDevice::ResetTxStats()
+{
+    memset(TxStats, 0, sizeof(TxStats));
+
+    for(int i = 0; i < SERIAL_TXPROF_LENGTHS; i++)
+        TxStats[i].Length = -1;
+
+    TxLastDrain = -1;
+}
+
+//------------------------------------------------------------------------------
+//
+//  GetTxStats
+//
+//  @brief  samples recorded for one length, 0 if none
+//
+//------------------------------------------------------------------------------
+
+const TSerialTxStats*
+TSerialDevice::GetTxStats(int length) const
+{
+    for(int i = 0; i < SERIAL_TXPROF_LENGTHS; i++)
+    {
+        if (TxStats[i].Length == length)
+            return &TxStats[i];
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//
+//  WriteTxStatsCSV
+//
+//  @brief  export one line per length, times in us, followed by the drain
+//          histogram bins
+//
+//------------------------------------------------------------------------------
+
+void
+TSerialDevice::WriteTxStatsCSV(FILE* out) const
+{
+    fprintf(out, "length,count,write_avg,write_max,drain_min,drain_avg,drain_max");
+    for(int b = 0; b < SERIAL_TXPROF_BINS; b++)
+        fprintf(out, ",h%d", b * SERIAL_TXPROF_BIN_US);
+    fprintf(out, "\n");
+
+    for(int i = 0; i < SERIAL_TXPROF_LENGTHS; i++)
+    {
+        const TSerialTxStats& st = TxStats[i];
+
+        if (st.Length < 0 || !st.Count)
+            continue;
+
+        fprintf(out, "%d,%u,%.1f,%.1f,%.1f,%.1f,%.1f", st.Length, st.Count,
+                (double)st.WriteSum / st.Count / 1000.0, st.WriteMax / 1000.0,
+                st.DrainMin / 1000.0, st.Drains ? (double)st.DrainSum / st.Drains / 1000.0 : 0.0, st.DrainMax / 1000.0);
+
+        for(int b = 0; b < SERIAL_TXPROF_BINS; b++)
+            fprintf(out, ",%u", st.Hist[b]);
+        fprintf(out, "\n");
+    }
+}
+
+#ifndef _WIN32
+
+static inline INT64
+MonotonicNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (INT64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//------------------------------------------------------------------------------
+//
+//  ProfiledWrite
+//
+//  @brief  write and measure until the kernel output queue is empty
+//
+//------------------------------------------------------------------------------
+
+bool
+TSerialDevice::ProfiledWrite(UINT8* data, int txLength, int profLength)
+{
+    INT64 start = MonotonicNs();
+
+    ssize_t numTxBytes = ::write(ComHandle, data, txLength);
+
+    INT64 written = MonotonicNs();
+    INT64 drained = -1;
+
+    switch(TxProfMode)
+    {
+        case    SERIAL_TXPROF_TCDRAIN:
+                tcdrain(ComHandle);
+                drained = MonotonicNs();
+                break;
+
+        case    SERIAL_TXPROF_OUTQ:
+#ifdef TIOCOUTQ
+                {
+                    int pending;
+                    while ((ioctl(ComHandle, TIOCOUTQ, &pending) == 0) && (pending > 0));
+                }
+#else
+                tcdrain(ComHandle);
+#endif
+                drained = MonotonicNs();
+                break;
+    }
+
+    RecordTx(profLength, written - start, drained < 0 ? -1 : drained - start);
+
+    return numTxBytes == (ssize_t)txLength;
+}
+
+#endif
+
+//------------------------------------------------------------------------------
+//
+//  RecordTx
+//
+//  @brief  account one write to its length entry
+//
+//------------------------------------------------------------------------------
+
+void
+TSerialDevice::RecordTx(int length, INT64 write, INT64 drain)
+{
+    TSerialTxStats* st = 0;
+
+    for(int i = 0; !st && i < SERIAL_TXPROF_LENGTHS; i++)
+    {
+        if (TxStats[i].Length == length || TxStats[i].Length < 0)
+            st = &TxStats[i];
+    }
+    // table full
+    if (!st)
+        return;
+
+    st->Length = length;
+    st->Count++;
+    st->WriteSum += write;
+    if (write > st->WriteMax)
+        st->WriteMax = write;
+
+    TxLastDrain = drain;
+    if (drain < 0)
+        return;
+
+    if (!st->Drains++ || drain < st->DrainMin)
+        st->DrainMin = drain;
+    if (drain > st->DrainMax)
+        st->DrainMax = drain;
+    st->DrainSum += drain;
+
+    INT64 bin = drain / (SERIAL_TXPROF_BIN_US * 1000LL);
+    if (bin >= SERIAL_TXPROF_BINS)
+        bin = SERIAL_TXPROF_BINS - 1;
+    st->Hist[bin]++;
+}
+
 //------------------------------------------------------------------------------
 //
 //  ReadData
@@ -336,17 +540,17 @@ TSerialDevice::ReadData(UINT8* rxBuffer, int bufferSize)
     if(ComHandle == INVALID_HANDLE_VALUE)
         return 0;
 
-#ifdef  Q_OS_WIN
+#ifdef  _WIN32
     DWORD numRxBytes = 0;
     if (ReadFile(ComHandle, rxBuffer, bufferSize, &numRxBytes, 0))
     {
         return (int)numRxBytes;
     }
-#elif defined ( Q_OS_MAC )
+#elif defined (__APPLE__)
     ssize_t  numRxBytes = ::read(ComHandle, rxBuffer, bufferSize);
     if(numRxBytes > 0)
         return (int)numRxBytes;
-#elif defined ( Q_OS_LINUX )
+#elif defined (__linux__)
     ssize_t  numRxBytes = ::read(ComHandle, rxBuffer, bufferSize);
     if(numRxBytes > 0)
         return (int)numRxBytes;
@@ -364,9 +568,9 @@ TSerialDevice::ReadData(UINT8* rxBuffer, int bufferSize)
 //
 //------------------------------------------------------------------------------
 
-#ifdef  Q_OS_WIN
+#ifdef  _WIN32
 int
-TSerialDevice::GetComPorts(QStringList& portList)
+TSerialDevice::GetComPorts(TStringList& portList)
 {
     TRegistryKey key1;
     key1.LocalMachine();
@@ -378,17 +582,24 @@ TSerialDevice::GetComPorts(QStringList& portList)
     }
     return portList.count();
 }
-#elif defined(Q_OS_MAC) || defined(Q_OS_LINUX)
+#elif defined(__APPLE__) || defined(__linux__)
 int
-TSerialDevice::GetComPorts(QStringList& portList)
+TSerialDevice::GetComPorts(TStringList& portList)
 {
-    QDir myDir("/dev");
-
-    QStringList filters;
+    DIR* dir = opendir("/dev");
+    struct dirent* entry;
 
-    filters.append("tty*");
+    portList.clear();
+    if (!dir)
+        return 0;
 
-    portList = myDir.entryList (filters, QDir::System);	// filter tty
+    // filter tty
+    while ((entry = readdir(dir)) != 0)
+    {
+        if (!strncmp(entry->d_name, "tty", 3))
+            portList.append(entry->d_name);
+    }
+    closedir(dir);
 
     return portList.count();
 }
@@ -16,10 +16,10 @@
 #ifndef SERIALDEVICE_H
 #define SERIALDEVICE_H
 
-#include <QString>
-#include <QStringList>
+#include <string_view>
+#include "StringList.h"
 
-#ifdef  Q_OS_WIN
+#ifdef  _WIN32
 
 #include <windows.h>
 
@@ -30,7 +30,7 @@
 #define Parity_Even         EVENPARITY
 #define Parity_None         NOPARITY
 
-#elif defined( Q_OS_MAC )
+#elif defined(__APPLE__)
 
 #include <errno.h>
 #include <sys/time.h>
@@ -48,7 +48,7 @@
 #define Parity_Even         PARENB
 #define Parity_None         0
 
-#elif defined( Q_OS_LINUX )
+#elif defined(__linux__)
 
 #include <errno.h>
 #include <sys/time.h>
@@ -68,8 +68,50 @@
 
 #endif
 
+#include <stdio.h>
 #include "WMDefs.h"
 
+//------------------------------------------------------------------------------
+//
+// TX Profiling
+//
+//------------------------------------------------------------------------------
+
+// profiling modes
+#define SERIAL_TXPROF_OFF           0   // plain write
+#define SERIAL_TXPROF_WRITE         1   // time write() only, never blocks
+#define SERIAL_TXPROF_TCDRAIN       2   // block in tcdrain() until sent
+#define SERIAL_TXPROF_OUTQ          3   // spin on TIOCOUTQ until queue empty
+
+// number of distinct lengths tracked
+#define SERIAL_TXPROF_LENGTHS       32
+
+// drain histogram: 100us bins, last bin collects everything above
+#define SERIAL_TXPROF_BINS          64
+#define SERIAL_TXPROF_BIN_US        100
+
+typedef struct
+{
+    // length the samples are accounted to, -1: unused entry
+    int     Length;
+
+    // number of writes
+    UINT32  Count;
+
+    // time spent in write() [ns]
+    INT64   WriteSum;
+    INT64   WriteMax;
+
+    // write() start until output queue empty [ns], drain modes only
+    UINT32  Drains;
+    INT64   DrainMin;
+    INT64   DrainMax;
+    INT64   DrainSum;
+
+    // drain histogram
+    UINT32  Hist[SERIAL_TXPROF_BINS];
+}TSerialTxStats;
+
 //------------------------------------------------------------------------------
 //
 // TSerialDevice Class Declaration
@@ -82,25 +124,45 @@ public:
                 TSerialDevice();
                 ~TSerialDevice();
 
-    static int  GetComPorts(QStringList& portList);
+    static int  GetComPorts(TStringList& portList);
 
-    bool        Open(const QString& comPort, UINT32 baudRate, int bits = DataBits_8, UINT8 parity = Parity_None);
+    bool        Open(std::string_view comPort, UINT32 baudRate, int bits = DataBits_8, UINT8 parity = Parity_None);
     bool        Close();
 
-    bool        SendData(UINT8* data, int txLength);
+    // profLength: length used as profiling key, default txLength
+    bool        SendData(UINT8* data, int txLength, int profLength = -1);
     int         ReadData(UINT8* rxBuffer, int bufferSize);
 
+    // tx profiling, not available on Windows
+    void        SetTxProfiling(int mode);
+    int         GetTxProfiling() const { return TxProfMode; }
+    void        ResetTxStats();
+    const TSerialTxStats* GetTxStats(int length) const;
+    INT64       GetLastTxDrain() const { return TxLastDrain; }
+    void        WriteTxStatsCSV(FILE* out) const;
+
+#ifndef _WIN32
+    // file descriptor for poll/epoll based receivers
+    int         GetHandle() const { return ComHandle; }
+#endif
+
 private:
+    bool        ProfiledWrite(UINT8* data, int txLength, int profLength);
+    void        RecordTx(int length, INT64 write, INT64 drain);
+
+    int             TxProfMode;
+    INT64           TxLastDrain;
+    TSerialTxStats  TxStats[SERIAL_TXPROF_LENGTHS];
 
-#ifdef  Q_OS_WIN
+#ifdef  _WIN32
 
     HANDLE  ComHandle;
 
-#elif defined( Q_OS_MAC )
+#elif defined(__APPLE__)
 
     int     ComHandle;
 
-#elif defined( Q_OS_LINUX )
+#elif defined(__linux__)
 
     int     ComHandle;
 
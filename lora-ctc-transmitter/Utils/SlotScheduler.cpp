@@ -0,0 +1,300 @@
+//------------------------------------------------------------------------------
+//
+//	File:		SlotScheduler.cpp
+//
+//	Abstract:	Deadline Driven CTC Slot Scheduler Class Implementation
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//
+//  Include Files
+//
+//------------------------------------------------------------------------------
+
+#include "SlotScheduler.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+//------------------------------------------------------------------------------
+//
+//  Defines
+//
+//------------------------------------------------------------------------------
+
+#define NSEC_PER_USEC           1000LL
+#define NSEC_PER_SEC            1000000000LL
+
+static inline INT64
+TimespecToNs(const struct timespec& ts)
+{
+    return (INT64)ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+static inline void
+NsToTimespec(struct timespec& ts, INT64 ns)
+{
+    ts.tv_sec  = (time_t)(ns / NSEC_PER_SEC);
+    ts.tv_nsec = (long)(ns % NSEC_PER_SEC);
+}
+
+static inline INT64
+NowNs()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return TimespecToNs(ts);
+}
+
+//------------------------------------------------------------------------------
+//
+//  TSlotScheduler - Class Constructor
+//
+//------------------------------------------------------------------------------
+
+TSlotScheduler::TSlotScheduler()
+{
+    SlotLength = 0;
+    SlotNumber = 0;
+    memset(&SlotEpoch, 0, sizeof(SlotEpoch));
+    ResetStats();
+}
+
+//------------------------------------------------------------------------------
+//
+//  SetRealtime
+//
+//  @brief: switch calling thread to SCHED_FIFO and lock its memory
+//
+//------------------------------------------------------------------------------
+
+bool
+TSlotScheduler::SetRealtime(int priority)
+{
+    struct sched_param param;
+
+    if (priority <= 0)
+        return true;
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = priority;
+
+    if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) != 0)
+    {
+        printf("warning - SCHED_FIFO %d not permitted\n", priority);
+        return false;
+    }
+
+    // avoid page faults inside the slot loop
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        printf("warning - mlockall failed (%d)\n", errno);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//
+//  SetAffinity
+//
+//  @brief: pin calling thread to one cpu core, wraps at the number of
+//          online cores
+//
+//------------------------------------------------------------------------------
+
+bool
+TSlotScheduler::SetAffinity(int cpu)
+{
+    cpu_set_t set;
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+    if (cpu < 0)
+        return true;
+    if (cores > 0)
+        cpu %= cores;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+    {
+        printf("warning - cannot pin to cpu %d\n", cpu);
+        return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//
+//  Start
+//
+//  @brief: start slot 0 now
+//
+//------------------------------------------------------------------------------
+
+void
+TSlotScheduler::Start(UINT32 slotLength)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    Start(now, slotLength);
+}
+
+//------------------------------------------------------------------------------
+//
+//  Start
+//
+//  @brief: start slot 0 at a given epoch
+//
+//------------------------------------------------------------------------------
+
+void
+TSlotScheduler::Start(const struct timespec& epoch, UINT32 slotLength)
+{
+    SlotEpoch  = epoch;
+    SlotLength = slotLength;
+    SlotNumber = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+//  WaitUntil
+//
+//  @brief: sleep until the absolute deadline, then spin for the last
+//          SLOTSCHED_SPIN_US to hit it without scheduler latency
+//
+//------------------------------------------------------------------------------
+
+void
+TSlotScheduler::WaitUntil(UINT32 offset)
+{
+    struct timespec ts;
+    INT64 deadline, now;
+
+    Deadline(ts, offset);
+    deadline = TimespecToNs(ts);
+
+    now = NowNs();
+    if (now > deadline)
+    {
+        Record(now - deadline, true);
+        return;
+    }
+
+    // coarse part: absolute sleep, immune to drift and signals
+    if (deadline - now > SLOTSCHED_SPIN_US * NSEC_PER_USEC)
+    {
+        NsToTimespec(ts, deadline - SLOTSCHED_SPIN_US * NSEC_PER_USEC);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0) == EINTR);
+    }
+
+    // fine part
+    while ((now = NowNs()) < deadline);
+
+    Record(now - deadline, false);
+}
+
+//------------------------------------------------------------------------------
+//
+//  NextSlot
+//
+//  @brief: move the grid forward, the next deadline is relative to the
+//          new slot start so errors never accumulate
+//
+//------------------------------------------------------------------------------
+
+void
+TSlotScheduler::NextSlot(UINT32 count)
+{
+    SlotNumber += count;
+}
+
+//------------------------------------------------------------------------------
+//
+//  Deadline
+//
+//  @brief: absolute time of offset [us] in the current slot
+//
+//------------------------------------------------------------------------------
+
+void
+TSlotScheduler::Deadline(struct timespec& ts, UINT32 offset) const
+{
+    INT64 ns = TimespecToNs(SlotEpoch)
+             + ((INT64)SlotNumber * SlotLength + offset) * NSEC_PER_USEC;
+
+    NsToTimespec(ts, ns);
+}
+
+//------------------------------------------------------------------------------
+//
+//  Statistics
+//
+//------------------------------------------------------------------------------
+
+void
+TSlotScheduler::Record(INT64 lateness, bool overrun)
+{
+    INT64 bin = lateness / NSEC_PER_USEC;
+
+    if (JitterStats.Count == 0 || lateness < JitterStats.Min)
+        JitterStats.Min = lateness;
+    if (JitterStats.Count == 0 || lateness > JitterStats.Max)
+        JitterStats.Max = lateness;
+
+    JitterStats.Count++;
+    JitterStats.Sum += lateness;
+
+    if (overrun)
+        JitterStats.Overruns++;
+    if (bin >= SLOTSCHED_MISS_US)
+        JitterStats.Misses++;
+    if (bin >= SLOTSCHED_HIST_BINS)
+        bin = SLOTSCHED_HIST_BINS - 1;
+
+    JitterStats.Hist[bin]++;
+}
+
+void
+TSlotScheduler::ResetStats()
+{
+    memset(&JitterStats, 0, sizeof(JitterStats));
+}
+
+void
+TSlotScheduler::PrintStats(FILE* out, const char* name) const
+{
+    const TSlotJitterStats& st = JitterStats;
+    UINT32 acc = 0, p50 = 0, p99 = 0;
+    int ii;
+
+    if (!st.Count)
+    {
+        fprintf(out, "* %s: no deadlines\n", name);
+        return;
+    }
+
+    for (ii = 0; ii < SLOTSCHED_HIST_BINS; ii++)
+    {
+        acc += st.Hist[ii];
+        if (!p50 && acc * 2 >= st.Count) p50 = ii + 1;
+        if (!p99 && acc * 100 >= st.Count * 99) p99 = ii + 1;
+    }
+
+    fprintf(out, "* %s: n=%u min=%.1f avg=%.1f max=%.1f p50<%u p99<%u us, miss=%u overrun=%u\n",
+            name, st.Count,
+            st.Min / 1000.0, (double)st.Sum / st.Count / 1000.0, st.Max / 1000.0,
+            p50, p99, st.Misses, st.Overruns);
+}
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+//
+//	File:		SlotScheduler.h
+//
+//	Abstract:	Deadline Driven CTC Slot Scheduler Class Declaration
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+#ifndef SLOTSCHEDULER_H
+#define SLOTSCHEDULER_H
+
+//------------------------------------------------------------------------------
+//
+// Include Files
+//
+//------------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <time.h>
+#include "WMDefs.h"
+
+//------------------------------------------------------------------------------
+//
+// General Definitions
+//
+//------------------------------------------------------------------------------
+
+// final busy-wait window before a deadline [us]
+#define SLOTSCHED_SPIN_US           200
+
+// jitter histogram: 1us bins, last bin collects everything above
+#define SLOTSCHED_HIST_BINS         64
+
+// deadline error treated as a miss [us]
+#define SLOTSCHED_MISS_US           50
+
+//------------------------------------------------------------------------------
+//
+// Jitter Statistics
+//
+//------------------------------------------------------------------------------
+
+typedef struct
+{
+    // number of recorded deadlines
+    UINT32  Count;
+
+    // deadlines hit later than SLOTSCHED_MISS_US
+    UINT32  Misses;
+
+    // deadlines that had already passed when WaitUntil was called
+    UINT32  Overruns;
+
+    // lateness [ns]
+    INT64   Min;
+    INT64   Max;
+    INT64   Sum;
+
+    // lateness histogram [us]
+    UINT32  Hist[SLOTSCHED_HIST_BINS];
+}TSlotJitterStats;
+
+//------------------------------------------------------------------------------
+//
+// TSlotScheduler Class Declaration
+//
+//------------------------------------------------------------------------------
+
+class TSlotScheduler
+{
+public:
+                TSlotScheduler();
+
+    // optional real-time setup of the calling thread
+    static bool SetRealtime(int priority);
+    static bool SetAffinity(int cpu);
+
+    // start a slot grid now or at a given CLOCK_MONOTONIC epoch
+    void        Start(UINT32 slotLength);
+    void        Start(const struct timespec& epoch, UINT32 slotLength);
+
+    // sleep until offset [us] into the current slot
+    void        WaitUntil(UINT32 offset);
+
+    // advance the grid by a number of slots
+    void        NextSlot(UINT32 count = 1);
+
+    UINT64      Slot() const { return SlotNumber; }
+    const struct timespec& Epoch() const { return SlotEpoch; }
+
+    // jitter statistics
+    const TSlotJitterStats& Stats() const { return JitterStats; }
+    void        ResetStats();
+    void        PrintStats(FILE* out, const char* name) const;
+
+private:
+    void        Deadline(struct timespec& ts, UINT32 offset) const;
+    void        Record(INT64 lateness, bool overrun);
+
+private:
+    // start of slot 0
+    struct timespec     SlotEpoch;
+
+    // slot length [us]
+    UINT32              SlotLength;
+
+    // current slot
+    UINT64              SlotNumber;
+
+    TSlotJitterStats    JitterStats;
+};
+
+#endif // SLOTSCHEDULER_H
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
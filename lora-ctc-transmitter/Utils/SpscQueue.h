@@ -0,0 +1,87 @@
+//------------------------------------------------------------------------------
+//
+//	File:		SpscQueue.h
+//
+//	Abstract:	Lock-free Single Producer Single Consumer Queue
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+//------------------------------------------------------------------------------
+//
+// Include Files
+//
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <stddef.h>
+
+//------------------------------------------------------------------------------
+//
+// TSpscQueue Class Declaration
+//
+// Bounded ring of Size elements (power of two). Push() may only be called
+// from one thread and Pop() from one other thread; neither blocks.
+//
+//------------------------------------------------------------------------------
+
+template <typename T, size_t Size>
+class TSpscQueue
+{
+    static_assert((Size & (Size - 1)) == 0, "Size must be a power of two");
+
+public:
+                TSpscQueue() : Head(0), Tail(0) {}
+
+    // producer side, returns false if full
+    bool        Push(const T& item)
+    {
+        size_t tail = Tail.load(std::memory_order_relaxed);
+
+        if (tail - Head.load(std::memory_order_acquire) == Size)
+            return false;
+
+        Items[tail & (Size - 1)] = item;
+        Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // consumer side, returns false if empty
+    bool        Pop(T& item)
+    {
+        size_t head = Head.load(std::memory_order_relaxed);
+
+        if (head == Tail.load(std::memory_order_acquire))
+            return false;
+
+        item = Items[head & (Size - 1)];
+        Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool        IsEmpty() const
+    {
+        return Head.load(std::memory_order_acquire) == Tail.load(std::memory_order_acquire);
+    }
+
+private:
+    T                   Items[Size];
+
+    // consumer index
+    alignas(64) std::atomic<size_t> Head;
+
+    // producer index
+    alignas(64) std::atomic<size_t> Tail;
+};
+
+#endif // SPSCQUEUE_H
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
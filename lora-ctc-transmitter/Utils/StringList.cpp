@@ -0,0 +1,203 @@
+//------------------------------------------------------------------------------
+//
+//	File:		StringList.cpp
+//
+//	Abstract:	Fixed Buffer String and String List Class Implementation
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//
+//  Include Files
+//
+//------------------------------------------------------------------------------
+
+#include "StringList.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+
+//------------------------------------------------------------------------------
+//
+//  TStringBuffer - Class Constructor
+//
+//------------------------------------------------------------------------------
+
+TStringBuffer::TStringBuffer(char* data, size_t capacity)
+{
+    Data     = data;
+    Capacity = capacity;
+    Clear();
+}
+
+void
+TStringBuffer::Clear()
+{
+    Len = 0;
+    if (Capacity)
+        Data[0] = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+//  Append
+//
+//------------------------------------------------------------------------------
+
+bool
+TStringBuffer::Append(std::string_view text)
+{
+    size_t free = Capacity ? Capacity - 1 - Len : 0;
+    size_t n    = text.size() < free ? text.size() : free;
+
+    if (!Capacity)
+        return text.empty();
+
+    memcpy(Data + Len, text.data(), n);
+    Len += n;
+    Data[Len] = 0;
+
+    return n == text.size();
+}
+
+bool
+TStringBuffer::AppendFormat(const char* format, ...)
+{
+    va_list args;
+    int     n;
+
+    if (!Capacity)
+        return false;
+
+    va_start(args, format);
+    n = vsnprintf(Data + Len, Capacity - Len, format, args);
+    va_end(args);
+
+    if (n < 0)
+    {
+        Data[Len] = 0;
+        return false;
+    }
+    if ((size_t)n >= Capacity - Len)
+    {
+        Len = Capacity - 1;
+        return false;
+    }
+    Len += n;
+    return true;
+}
+
+void
+TStringBuffer::Chop(size_t n)
+{
+    Len = n < Len ? Len - n : 0;
+    if (Capacity)
+        Data[Len] = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+//  TStringList - Class Constructor
+//
+//------------------------------------------------------------------------------
+
+TStringList::TStringList()
+{
+    clear();
+}
+
+void
+TStringList::clear()
+{
+    Count     = 0;
+    Used      = 0;
+    Offset[0] = 0;
+}
+
+//------------------------------------------------------------------------------
+//
+//  append
+//
+//------------------------------------------------------------------------------
+
+bool
+TStringList::append(std::string_view item)
+{
+    TStringBuffer text(Buffer + Used, sizeof(Buffer) - Used);
+
+    if (Count >= STRINGLIST_MAX_ITEMS || Used >= sizeof(Buffer))
+        return false;
+
+    bool ok = text.Append(item);
+
+    // keep the terminator of every item
+    Used += text.Length() + 1;
+    Offset[++Count] = Used;
+    return ok;
+}
+
+bool
+TStringList::appendFormat(const char* format, ...)
+{
+    va_list args;
+    int     n;
+
+    if (Count >= STRINGLIST_MAX_ITEMS || Used >= sizeof(Buffer))
+        return false;
+
+    va_start(args, format);
+    n = vsnprintf(Buffer + Used, sizeof(Buffer) - Used, format, args);
+    va_end(args);
+
+    if (n < 0)
+        return false;
+
+    bool ok = (size_t)n < sizeof(Buffer) - Used;
+    if (!ok)
+        n = sizeof(Buffer) - Used - 1;
+
+    Used += n + 1;
+    Offset[++Count] = Used;
+    return ok;
+}
+
+//------------------------------------------------------------------------------
+//
+//  operator []
+//
+//------------------------------------------------------------------------------
+
+std::string_view
+TStringList::operator [] (int i) const
+{
+    if (i < 0 || i >= Count)
+        return std::string_view();
+
+    return std::string_view(Buffer + Offset[i], Offset[i + 1] - Offset[i] - 1);
+}
+
+//------------------------------------------------------------------------------
+//
+//  join
+//
+//------------------------------------------------------------------------------
+
+void
+TStringList::join(TStringBuffer& result, std::string_view separator) const
+{
+    result.Clear();
+    for(int i = 0; i < Count; i++)
+    {
+        if (i)
+            result.Append(separator);
+        result.Append((*this)[i]);
+    }
+}
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------
+//
+//	File:		StringList.h
+//
+//	Abstract:	Fixed Buffer String and String List Class Declaration
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+#ifndef STRINGLIST_H
+#define STRINGLIST_H
+
+//------------------------------------------------------------------------------
+//
+// Include Files
+//
+//------------------------------------------------------------------------------
+
+#include <stddef.h>
+#include <string_view>
+#include "WMDefs.h"
+
+//------------------------------------------------------------------------------
+//
+// General Definitions
+//
+//------------------------------------------------------------------------------
+
+// characters of all items of a list, including terminators
+#define STRINGLIST_BUFFER_SIZE      1024
+
+// max. number of items of a list
+#define STRINGLIST_MAX_ITEMS        32
+
+//------------------------------------------------------------------------------
+//
+// TStringBuffer - string in a caller provided buffer
+//
+// Text that does not fit is truncated, the buffer is always terminated.
+// Nothing is allocated.
+//
+//------------------------------------------------------------------------------
+
+class TStringBuffer
+{
+public:
+                TStringBuffer(char* data, size_t capacity);
+                TStringBuffer(const TStringBuffer&) = delete;
+    TStringBuffer& operator = (const TStringBuffer&) = delete;
+
+    void        Clear();
+
+    // false if the text was truncated
+    bool        Append(std::string_view text);
+    bool        AppendFormat(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    // remove n characters from the end
+    void        Chop(size_t n);
+
+    bool        IsEmpty() const { return Len == 0; }
+    size_t      Length() const { return Len; }
+    const char* c_str() const { return Data; }
+
+                operator std::string_view() const { return std::string_view(Data, Len); }
+
+private:
+    char*       Data;
+    size_t      Capacity;
+    size_t      Len;
+};
+
+//------------------------------------------------------------------------------
+//
+// TFixedString - string with inline storage of Size characters
+//
+//------------------------------------------------------------------------------
+
+template <size_t Size>
+class TFixedString : public TStringBuffer
+{
+public:
+                TFixedString() : TStringBuffer(Storage, Size) {}
+
+private:
+    char        Storage[Size];
+};
+
+//------------------------------------------------------------------------------
+//
+// TStringList - list of strings in one fixed buffer
+//
+//------------------------------------------------------------------------------
+
+class TStringList
+{
+public:
+                TStringList();
+
+    void        clear();
+
+    // false if the list is full, the item is dropped or truncated
+    bool        append(std::string_view item);
+    bool        appendFormat(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    int         count() const { return Count; }
+    std::string_view operator [] (int i) const;
+
+    // items separated by separator
+    void        join(TStringBuffer& result, std::string_view separator) const;
+
+private:
+    int         Count;
+    UINT16      Used;
+    UINT16      Offset[STRINGLIST_MAX_ITEMS + 1];
+    char        Buffer[STRINGLIST_BUFFER_SIZE];
+};
+
+#endif // STRINGLIST_H
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
@@ -16,7 +16,6 @@
 #ifndef WMDEFS_H
 #define WMDEFS_H
 
-#include <Qt>
 #include <inttypes.h>
 
 typedef uint8_t     UINT8;
@@ -27,6 +26,7 @@ typedef uint64_t    UINT64;
 typedef int8_t      INT8;
 typedef int16_t     INT16;
 typedef int32_t     INT32;
+typedef int64_t     INT64;
 
 
 #ifndef  MAKEWORD
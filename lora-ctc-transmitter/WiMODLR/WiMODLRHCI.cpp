@@ -21,8 +21,13 @@
 
 #include "WiMODLRHCI.h"
 #include "CRC16.h"
-#include <QTime>
 #include <iostream>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 
 //------------------------------------------------------------------------------
@@ -222,6 +227,23 @@ TWiMODLRHCI::TWiMODLRHCI()
 
     // 1000ms timeout for response
     Rx.Timeout = 1000;
+
+    // no pre-encoded frames yet
+    ClearFrameCache();
+
+    // no asynchronous requests
+    for(int i = 0; i < WIMODLR_HCI_MAX_PENDING; i++)
+        Pending[i].Active = false;
+    PendingSequence = 0;
+
+    // receiver thread decodes into its own buffer
+    RxThreadRunning = false;
+    EpollHandle     = -1;
+    StopEvent       = -1;
+    RxEvent         = -1;
+    RxQueueOverflow = 0;
+    RxComSlip.RegisterClient(this);
+    RxComSlip.SetRxBuffer(&RxThreadMessage.SapID, (UINT16)WIMODLR_HCI_RX_MESSAGE_SIZE);
 }
 
 //------------------------------------------------------------------------------
@@ -245,7 +267,7 @@ TWiMODLRHCI::~TWiMODLRHCI()
 //------------------------------------------------------------------------------
 
 bool
-TWiMODLRHCI::Open(const QString& comPort)
+TWiMODLRHCI::Open(std::string_view comPort)
 {
     // open serial device
     if (SerialDevice.Open(comPort, Baudrate_115200))
@@ -271,6 +293,9 @@ TWiMODLRHCI::Open(const QString& comPort)
 bool
 TWiMODLRHCI::Close()
 {
+    // receiver thread must not read a closed handle
+    StopReceiver();
+
     // close serial device
     if (SerialDevice.Close())
     {
@@ -292,6 +317,17 @@ TWiMODLRHCI::Close()
 void
 TWiMODLRHCI::Process()
 {
+    if (RxThreadRunning)
+    {
+        // dispatch messages decoded by the receiver thread, stop at an
+        // expected response so Rx.Message stays valid for the caller
+        while (!(Rx.Active && Rx.Done) && RxQueue.Pop(Rx.Message))
+            DispatchRxMessage(Rx.Message);
+
+        ExpirePendingRequests();
+        return;
+    }
+
     // read data from comport
     int numRxBytes = SerialDevice.ReadData(Rx.Buffer, sizeof(Rx.Buffer));
 
@@ -303,6 +339,120 @@ TWiMODLRHCI::Process()
         // callback function "ProcessRxMessage" (see Receiver section)
         ComSlip.DecodeData(Rx.Buffer, numRxBytes);
     }
+
+    ExpirePendingRequests();
+}
+
+//------------------------------------------------------------------------------
+//
+//  StartReceiver
+//
+//  @brief: move comport reading and SLIP decoding to a thread, decoded
+//          messages are handed over to Process() via RxQueue
+//
+//------------------------------------------------------------------------------
+
+bool
+TWiMODLRHCI::StartReceiver()
+{
+    struct epoll_event ev;
+
+    if (RxThreadRunning)
+        return true;
+
+    int fd = SerialDevice.GetHandle();
+    if (fd < 0)
+        return false;
+
+    EpollHandle = epoll_create1(EPOLL_CLOEXEC);
+    StopEvent   = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    RxEvent     = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if ((EpollHandle < 0) || (StopEvent < 0) || (RxEvent < 0))
+    {
+        StopReceiver();
+        return false;
+    }
+
+    memset(&ev, 0, sizeof(ev));
+    ev.events  = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(EpollHandle, EPOLL_CTL_ADD, fd, &ev);
+    ev.data.fd = StopEvent;
+    epoll_ctl(EpollHandle, EPOLL_CTL_ADD, StopEvent, &ev);
+
+    RxThreadRunning = true;
+    RxThread = std::thread(&TWiMODLRHCI::ReceiverLoop, this);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//
+//  StopReceiver
+//
+//  @brief: stop receiver thread, Process() reads the comport again
+//
+//------------------------------------------------------------------------------
+
+void
+TWiMODLRHCI::StopReceiver()
+{
+    if (RxThread.joinable())
+    {
+        UINT64 one = 1;
+        if (write(StopEvent, &one, sizeof(one)) < 0)
+            ShowMessage("StopReceiver: eventfd write failed");
+        RxThread.join();
+    }
+    RxThreadRunning = false;
+
+    if (EpollHandle >= 0) close(EpollHandle);
+    if (StopEvent >= 0)   close(StopEvent);
+    if (RxEvent >= 0)     close(RxEvent);
+
+    EpollHandle = StopEvent = RxEvent = -1;
+}
+
+//------------------------------------------------------------------------------
+//
+//  ReceiverLoop
+//
+//  @brief: receiver thread, sleeps in epoll until comport data arrives
+//
+//------------------------------------------------------------------------------
+
+void
+TWiMODLRHCI::ReceiverLoop()
+{
+    struct epoll_event events[2];
+
+    for(;;)
+    {
+        int n = epoll_wait(EpollHandle, events, 2, -1);
+
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        for(int i = 0; i < n; i++)
+        {
+            if (events[i].data.fd == StopEvent)
+                return;
+
+            // device gone
+            if (events[i].events & (EPOLLERR | EPOLLHUP))
+                return;
+
+            // drain comport, complete frames end up in QueueRxMessage
+            int numRxBytes;
+            while ((numRxBytes = SerialDevice.ReadData(RxThreadBuffer, sizeof(RxThreadBuffer))) > 0)
+                RxComSlip.DecodeData(RxThreadBuffer, numRxBytes);
+        }
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -330,6 +480,20 @@ TWiMODLRHCI::PingRequest()
     return SendHCIMessage(DEVMGMT_SAP_ID, DEVMGMT_MSG_PING_REQ, DEVMGMT_MSG_PING_RSP);
 }
 
+//------------------------------------------------------------------------------
+//
+//  PingRequestAsync
+//
+//  @brief: send ping, handler is called from Process()
+//
+//------------------------------------------------------------------------------
+
+TWiMODLRResult
+TWiMODLRHCI::PingRequestAsync(const TWiMODLRResponseHandler& handler)
+{
+    return SendHCIMessageAsync(DEVMGMT_SAP_ID, DEVMGMT_MSG_PING_REQ, DEVMGMT_MSG_PING_RSP, handler);
+}
+
 //------------------------------------------------------------------------------
 //
 //  FactoryReset
@@ -562,7 +726,7 @@ TWiMODLRHCI::ConvertRadioConfiguration(TKeyValueList& list, const TWiMODLR_Radio
 
     // Carrier Frequency
     UINT32 freq = GetFrequencyFromConfig(config.Frequency);
-    list.AddKeyValue("Frequency", QString("%1 Hz").arg(freq));
+    list.appendFormat("Frequency:%u Hz", (unsigned)freq);
 
     // Bandwidth
     list.AddKeyValue("Bandwidth", GetStringFromTable(WiMODLRHCI_RadioConfig_Bandwidths, config.Bandwidth));
@@ -583,13 +747,16 @@ TWiMODLRHCI::ConvertRadioConfiguration(TKeyValueList& list, const TWiMODLR_Radio
     list.AddKeyValue("RxControl", GetStringFromTable(WiMODLRHCI_RadioConfig_RxControl, config.RxControl));
 
     // Rx Window
-    list.AddKeyValue("RxWindowTime", QString("%1 ms").arg((UINT16)config.RxWindowTime));
+    list.appendFormat("RxWindowTime:%u ms", (UINT16)config.RxWindowTime);
 
     // LED Control
-    list.AddKeyValue("LEDControl", GetCombinedStringFromTable(WiMODLRHCI_RadioConfig_LEDControl, config.LEDControl, 4));
+    TFixedString<128> bits;
+    GetCombinedStringFromTable(bits, WiMODLRHCI_RadioConfig_LEDControl, config.LEDControl, 4);
+    list.AddKeyValue("LEDControl", bits);
 
     // Radio Options
-    list.AddKeyValue("RadioOptions", GetCombinedStringFromTable(WiMODLRHCI_RadioConfig_RadioOptions, config.RadioOptions, 5));
+    GetCombinedStringFromTable(bits, WiMODLRHCI_RadioConfig_RadioOptions, config.RadioOptions, 5);
+    list.AddKeyValue("RadioOptions", bits);
 
     // NEW
     // FSK Datarate
@@ -676,6 +843,34 @@ TWiMODLRHCI::SendURadioMessage2(UINT8* txMessage, UINT16 length, UINT8& status)
     //return result;
 }
 
+//------------------------------------------------------------------------------
+//
+//  CacheURadioMessage
+//
+//  @brief: pre-encode an unreliable radio message of given length
+//
+//------------------------------------------------------------------------------
+
+TWiMODLRResult
+TWiMODLRHCI::CacheURadioMessage(UINT8* txMessage, UINT16 length)
+{
+    return CacheHCIMessage(DATALINK_SAP_ID, DATALINK_MSG_SEND_URADIO_MSG_REQ, txMessage, length);
+}
+
+//------------------------------------------------------------------------------
+//
+//  SendCachedURadioMessage
+//
+//  @brief: send pre-encoded unreliable radio message without response
+//
+//------------------------------------------------------------------------------
+
+TWiMODLRResult
+TWiMODLRHCI::SendCachedURadioMessage(UINT16 length)
+{
+    return SendCachedHCIMessage(DATALINK_SAP_ID, DATALINK_MSG_SEND_URADIO_MSG_REQ, length);
+}
+
 //------------------------------------------------------------------------------
 //
 //  ConvertRadioMessage
@@ -730,11 +925,11 @@ TWiMODLRHCI::ConvertRadioRxMessage(TKeyValueList& list, const TWiMODLR_HCIMessag
         INT8   snr  = rxMsg.Payload[extOffset + 2];
         UINT32 time = NTOH32(&rxMsg.Payload[extOffset + 3]);
 
-        QString timeString;
+        TFixedString<32> timeString;
         U32TimeToString(timeString, time, true);
 
-        list.AddKeyValue("RSSI", QString("%1 dBm").arg((float)rssi,0,'f',2));
-        list.AddKeyValue("SNR", QString("SNR:%1 dB").arg((float)snr,0,'f',2));
+        list.appendFormat("RSSI:%.2f dBm", (float)rssi);
+        list.appendFormat("SNR:SNR:%.2f dB", (float)snr);
         list.AddKeyValue("RxTime", timeString);
     }
 }
@@ -831,42 +1026,11 @@ TWiMODLRHCI::PostMessage(UINT8 sapID, UINT8 msgID, UINT8* payload, UINT16 length
         return WiMODLR_RESULT_PAYLOAD_PTR_ERROR;
     }
 
-    // 2.  init TxMessage
+    // 2. init TxMessage, attach CRC16
     //
-    // 2.1 init SAP ID
-    //
-    TxMessage.SapID = sapID;
-
-    // 2.2 init Msg ID
-    //
-    TxMessage.MsgID = msgID;
-
-    // 2.3 copy payload, if present
-    //
-    if(payload && length)
-    {
-        UINT8*  dstPtr  = TxMessage.Payload;
-        int     n       = (int)length;
-
-        // copy bytes
-        while(n--)
-            *dstPtr++ = *payload++;
-    }
-
-    // 3. Calculate CRC16 over header and optional payload
-    //
-    UINT16 crc16 = CRC16_Calc(&TxMessage.SapID, length + WIMODLR_HCI_MSG_HEADER_SIZE, CRC16_INIT_VALUE);
-
-    // 3.1 get 1's complement
-    //
-    crc16 = ~crc16;
-
-    // 3.2 attach CRC16 and correct length, lobyte first
-    //
-    TxMessage.Payload[length++] = LOBYTE(crc16);
-    TxMessage.Payload[length++] = HIBYTE(crc16);
+    length = PrepareMessage(sapID, msgID, payload, length);
 
-    // 4. forward message to SLIP layer
+    // 3. forward message to SLIP layer
     //    - start transmission with SAP ID
     //    - correct length by header size
 
@@ -891,49 +1055,61 @@ TWiMODLRHCI::PostMessage2(UINT8 sapID, UINT8 msgID, UINT8* payload, UINT16 lengt
         return WiMODLR_RESULT_PAYLOAD_PTR_ERROR;
     }
 
-    // 2.  init TxMessage
+    // 2. init TxMessage, attach CRC16
     //
-    // 2.1 init SAP ID
+    length = PrepareMessage(sapID, msgID, payload, length);
+
+    // 3. forward message to SLIP layer
+    //    - start transmission with SAP ID
+    //    - correct length by header size
+
+    return SendPacket(&TxMessage.SapID, length + WIMODLR_HCI_MSG_HEADER_SIZE);
+}
+
+//------------------------------------------------------------------------------
+//
+//  PrepareMessage
+//
+//  @brief  fill TxMessage and attach CRC16, returns payload length incl. CRC
+//
+//------------------------------------------------------------------------------
+
+UINT16
+TWiMODLRHCI::PrepareMessage(UINT8 sapID, UINT8 msgID, UINT8* payload, UINT16 length)
+{
+    // 1.  init TxMessage
+    //
+    // 1.1 init SAP ID
     //
     TxMessage.SapID = sapID;
 
-    // 2.2 init Msg ID
+    // 1.2 init Msg ID
     //
     TxMessage.MsgID = msgID;
 
-    // 2.3 copy payload, if present
+    // 1.3 copy payload, if present
     //
     if(payload && length)
     {
-        UINT8*  dstPtr  = TxMessage.Payload;
-        int     n       = (int)length;
-
-        // copy bytes
-        while(n--)
-            *dstPtr++ = *payload++;
+        memcpy(TxMessage.Payload, payload, length);
     }
 
-    // 3. Calculate CRC16 over header and optional payload
+    // 2. Calculate CRC16 over header and optional payload
     //
     UINT16 crc16 = CRC16_Calc(&TxMessage.SapID, length + WIMODLR_HCI_MSG_HEADER_SIZE, CRC16_INIT_VALUE);
 
-    // 3.1 get 1's complement
+    // 2.1 get 1's complement
     //
     crc16 = ~crc16;
 
-    // 3.2 attach CRC16 and correct length, lobyte first
+    // 2.2 attach CRC16 and correct length, lobyte first
     //
     TxMessage.Payload[length++] = LOBYTE(crc16);
     TxMessage.Payload[length++] = HIBYTE(crc16);
 
-    // 4. forward message to SLIP layer
-    //    - start transmission with SAP ID
-    //    - correct length by header size
-
-    return SendPacket(&TxMessage.SapID, length + WIMODLR_HCI_MSG_HEADER_SIZE);
+    return length;
 }
 
-
 //------------------------------------------------------------------------------
 //
 //  SendPacket
@@ -951,8 +1127,8 @@ TWiMODLRHCI::SendPacket(UINT8* txData, UINT16 length)
     // stream ok ?
     if (txLength > 0)
     {
-        // send SLIP stream via serial device
-        if (SerialDevice.SendData(TxBuffer, txLength))
+        // send SLIP stream via serial device, profiled per HCI payload length
+        if (SerialDevice.SendData(TxBuffer, txLength, length - (WIMODLR_HCI_MSG_HEADER_SIZE + WIMODLR_HCI_MSG_FCS_SIZE)))
             return WiMODLR_RESULT_OK;
         else
             return WiMODLR_RESULT_TRANMIT_ERROR;
@@ -960,36 +1136,120 @@ TWiMODLRHCI::SendPacket(UINT8* txData, UINT16 length)
     return WiMODLR_RESULT_SLIP_ENCODER_ERROR;
 }
 
-static bool flag = false;
-static int record_length;
+//------------------------------------------------------------------------------
+//
+//  CacheHCIMessage
+//
+//  @brief: SLIP encode a HCI message once and keep the stream for
+//          SendCachedHCIMessage, an existing entry with the same key is
+//          replaced
+//
+//------------------------------------------------------------------------------
 
 TWiMODLRResult
-TWiMODLRHCI::SendPacket2(UINT8* txData, UINT16 length)
+TWiMODLRHCI::CacheHCIMessage(UINT8 sapID, UINT8 msgID, UINT8* payload, UINT16 length)
 {
-    if(flag == false){
-        // call SLIP encoder
-        flag = true;
-        int txLength = ComSlip.EncodeData(TxBuffer, sizeof(TxBuffer), txData, length);
-        record_length = txLength;
-
-        // stream ok ?
-        if (txLength > 0)
-        {
-            // send SLIP stream via serial device
-            if (SerialDevice.SendData(TxBuffer, txLength))
-                return WiMODLR_RESULT_OK;
-            else
-                return WiMODLR_RESULT_TRANMIT_ERROR;
-        }
-        return WiMODLR_RESULT_SLIP_ENCODER_ERROR;
+    if(length > WIMODLR_HCI_MSG_PAYLOAD_SIZE - WIMODLR_HCI_MSG_FCS_SIZE)
+    {
+        return WiMODLR_RESULT_PAYLOAD_LENGTH_ERROR;
     }
-    else {
-        SerialDevice.SendData(TxBuffer, record_length);
-        return WiMODLR_RESULT_OK;
+    if(length && !payload)
+    {
+        return WiMODLR_RESULT_PAYLOAD_PTR_ERROR;
+    }
+
+    TWiMODLR_CachedFrame* entry = FindCachedFrame(sapID, msgID, length);
+
+    // new key -> take first free entry
+    for(int i = 0; !entry && i < WIMODLR_FRAME_CACHE_SIZE; i++)
+    {
+        if (!FrameCache[i].Valid)
+            entry = &FrameCache[i];
+    }
+    if (!entry)
+    {
+        return WiMODLR_RESULT_FRAME_NOT_CACHED;
     }
 
+    UINT16 txLength = PrepareMessage(sapID, msgID, payload, length);
+
+    entry->TxLength = ComSlip.EncodeData(entry->Buffer, sizeof(entry->Buffer),
+                                         &TxMessage.SapID, txLength + WIMODLR_HCI_MSG_HEADER_SIZE);
+    entry->SapID    = sapID;
+    entry->MsgID    = msgID;
+    entry->Length   = length;
+    entry->Valid    = entry->TxLength > 0;
+
+    return entry->Valid ? WiMODLR_RESULT_OK : WiMODLR_RESULT_SLIP_ENCODER_ERROR;
 }
 
+//------------------------------------------------------------------------------
+//
+//  SendCachedHCIMessage
+//
+//  @brief: send a pre-encoded frame with a single write, no copy, CRC or
+//          SLIP work on this path
+//
+//------------------------------------------------------------------------------
+
+TWiMODLRResult
+TWiMODLRHCI::SendCachedHCIMessage(UINT8 sapID, UINT8 msgID, UINT16 length)
+{
+    TWiMODLR_CachedFrame* entry = FindCachedFrame(sapID, msgID, length);
+
+    if (!entry)
+        return WiMODLR_RESULT_FRAME_NOT_CACHED;
+
+    if (SerialDevice.SendData(entry->Buffer, entry->TxLength, entry->Length))
+        return WiMODLR_RESULT_OK;
+
+    return WiMODLR_RESULT_TRANMIT_ERROR;
+}
+
+//------------------------------------------------------------------------------
+//
+//  FindCachedFrame
+//
+//  @brief: lookup cache entry by (SapID, MsgID, Length)
+//
+//------------------------------------------------------------------------------
+
+TWiMODLR_CachedFrame*
+TWiMODLRHCI::FindCachedFrame(UINT8 sapID, UINT8 msgID, UINT16 length)
+{
+    TWiMODLR_CachedFrame* entry = &FrameCache[FrameCacheHit];
+
+    if (entry->Valid && entry->Length == length && entry->MsgID == msgID && entry->SapID == sapID)
+        return entry;
+
+    for(int i = 0; i < WIMODLR_FRAME_CACHE_SIZE; i++)
+    {
+        entry = &FrameCache[i];
+        if (entry->Valid && entry->Length == length && entry->MsgID == msgID && entry->SapID == sapID)
+        {
+            FrameCacheHit = i;
+            return entry;
+        }
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+//
+//  ClearFrameCache
+//
+//  @brief: drop all pre-encoded frames
+//
+//------------------------------------------------------------------------------
+
+void
+TWiMODLRHCI::ClearFrameCache()
+{
+    for(int i = 0; i < WIMODLR_FRAME_CACHE_SIZE; i++)
+        FrameCache[i].Valid = false;
+
+    FrameCacheHit = 0;
+}
 
 //------------------------------------------------------------------------------
 //
@@ -1007,11 +1267,12 @@ TWiMODLRHCI::WaitForResponse(UINT8 rxSapID, UINT8 rxMsgID)
     Rx.SapID  = rxSapID;
     Rx.MsgID  = rxMsgID;
 
-    QTime time;
-    time.start();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
     // wwit for response ~1000ms
-    while(time.elapsed() <= Rx.Timeout)
+    int remaining;
+    while((remaining = Rx.Timeout - (int)std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - start).count()) >= 0)
     {
         // call receiver path
         Process();
@@ -1025,6 +1286,9 @@ TWiMODLRHCI::WaitForResponse(UINT8 rxSapID, UINT8 rxMsgID)
             // ok
             return true;
         }
+
+        // sleep until more data is available
+        WaitForRxData(remaining);
     }
     // clear flag
     Rx.Active = false;
@@ -1033,6 +1297,191 @@ TWiMODLRHCI::WaitForResponse(UINT8 rxSapID, UINT8 rxMsgID)
     return false;
 }
 
+//------------------------------------------------------------------------------
+//
+//  WaitForRxData
+//
+//  @brief: block until received data is pending or timeout [ms] expired
+//
+//------------------------------------------------------------------------------
+bool
+TWiMODLRHCI::WaitForRxData(int timeout)
+{
+    struct pollfd pfd;
+
+    pfd.fd     = RxThreadRunning ? RxEvent : SerialDevice.GetHandle();
+    pfd.events = POLLIN;
+
+    if (pfd.fd < 0)
+        return false;
+
+    if (poll(&pfd, 1, timeout) <= 0)
+        return false;
+
+    if (RxThreadRunning)
+    {
+        // reset event counter, queued messages are drained by Process()
+        UINT64 count;
+        if (read(RxEvent, &count, sizeof(count)) < 0)
+            return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//
+//  SendHCIMessageAsync
+//
+//  @brief: send HCI message, response or timeout is reported to handler
+//          from Process()
+//
+//------------------------------------------------------------------------------
+
+TWiMODLRResult
+TWiMODLRHCI::SendHCIMessageAsync(UINT8 sapID, UINT8 msgID, UINT8 rxMsgID, const TWiMODLRResponseHandler& handler,
+                                 UINT8* payload, UINT16 length, int timeout)
+{
+    TPendingRequest* request = 0;
+
+    // 1. find free slot
+    for(int i = 0; i < WIMODLR_HCI_MAX_PENDING; i++)
+    {
+        if (!Pending[i].Active)
+        {
+            request = &Pending[i];
+            break;
+        }
+    }
+    if (!request)
+        return WiMODLR_RESULT_TOO_MANY_REQUESTS;
+
+    // 2. send, responses are only dispatched from Process() so
+    //    registering afterwards cannot miss one
+    TWiMODLRResult result = PostMessage(sapID, msgID, payload, length);
+    if (result != WiMODLR_RESULT_OK)
+        return result;
+
+    // 3. register
+    request->Active   = true;
+    request->SapID    = sapID;
+    request->MsgID    = rxMsgID;
+    request->Sequence = PendingSequence++;
+    request->Deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout);
+    request->Handler  = handler;
+
+    return WiMODLR_RESULT_OK;
+}
+
+//------------------------------------------------------------------------------
+//
+//  SendHCIMessageFuture
+//
+//  @brief: send HCI message, future becomes ready in Process()
+//
+//------------------------------------------------------------------------------
+
+std::future<TWiMODLR_HCIResponse>
+TWiMODLRHCI::SendHCIMessageFuture(UINT8 sapID, UINT8 msgID, UINT8 rxMsgID,
+                                  UINT8* payload, UINT16 length, int timeout)
+{
+    std::shared_ptr<std::promise<TWiMODLR_HCIResponse>> promise =
+            std::make_shared<std::promise<TWiMODLR_HCIResponse>>();
+
+    std::future<TWiMODLR_HCIResponse> future = promise->get_future();
+
+    TWiMODLRResult result = SendHCIMessageAsync(sapID, msgID, rxMsgID,
+                                                [promise](const TWiMODLR_HCIResponse& response)
+                                                {
+                                                    promise->set_value(response);
+                                                },
+                                                payload, length, timeout);
+    if (result != WiMODLR_RESULT_OK)
+    {
+        TWiMODLR_HCIResponse response;
+
+        response.Result         = result;
+        response.Message.Length = 0;
+        promise->set_value(response);
+    }
+    return future;
+}
+
+//------------------------------------------------------------------------------
+//
+//  DispatchPendingResponse
+//
+//  @brief: complete oldest pending request matching rxMsg
+//
+//------------------------------------------------------------------------------
+
+bool
+TWiMODLRHCI::DispatchPendingResponse(TWiMODLR_HCIMessage& rxMsg)
+{
+    TPendingRequest* request = 0;
+
+    for(int i = 0; i < WIMODLR_HCI_MAX_PENDING; i++)
+    {
+        TPendingRequest& p = Pending[i];
+
+        if (p.Active && (p.SapID == rxMsg.SapID) && (p.MsgID == rxMsg.MsgID))
+        {
+            if (!request || (INT32)(p.Sequence - request->Sequence) < 0)
+                request = &p;
+        }
+    }
+    if (!request)
+        return false;
+
+    // free slot first, handler may post a new request
+    TWiMODLRResponseHandler handler;
+    handler.swap(request->Handler);
+    request->Active = false;
+
+    TWiMODLR_HCIResponse response;
+    response.Result  = WiMODLR_RESULT_OK;
+    response.Message = rxMsg;
+
+    if (handler)
+        handler(response);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+//
+//  ExpirePendingRequests
+//
+//  @brief: report timeout for requests without response
+//
+//------------------------------------------------------------------------------
+
+void
+TWiMODLRHCI::ExpirePendingRequests()
+{
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    for(int i = 0; i < WIMODLR_HCI_MAX_PENDING; i++)
+    {
+        TPendingRequest& p = Pending[i];
+
+        if (!p.Active || (now < p.Deadline))
+            continue;
+
+        TWiMODLRResponseHandler handler;
+        handler.swap(p.Handler);
+        p.Active = false;
+
+        TWiMODLR_HCIResponse response;
+        response.Result         = WiMODLR_RESULT_NO_RESPONSE;
+        response.Message.SapID  = p.SapID;
+        response.Message.MsgID  = p.MsgID;
+        response.Message.Length = 0;
+
+        if (handler)
+            handler(response);
+    }
+}
+
 //------------------------------------------------------------------------------
 //------------------------------------------------------------------------------
 //
@@ -1054,6 +1503,10 @@ TWiMODLRHCI::WaitForResponse(UINT8 rxSapID, UINT8 rxMsgID)
 UINT8*
 TWiMODLRHCI::ProcessRxMessage(UINT8* rxBuffer, UINT16 length)
 {
+    // called from receiver thread ?
+    if (rxBuffer == &RxThreadMessage.SapID)
+        return QueueRxMessage(rxBuffer, length);
+
     // 1. check CRC
     if (CRC16_Check(rxBuffer, length, CRC16_INIT_VALUE))
     {
@@ -1083,6 +1536,47 @@ TWiMODLRHCI::ProcessRxMessage(UINT8* rxBuffer, UINT16 length)
     return &Rx.Message.SapID;
 }
 
+//------------------------------------------------------------------------------
+//
+//  QueueRxMessage
+//
+//  @brief: receiver thread part of ProcessRxMessage, check and hand over
+//          decoded message to Process()
+//
+//------------------------------------------------------------------------------
+
+UINT8*
+TWiMODLRHCI::QueueRxMessage(UINT8* rxBuffer, UINT16 length)
+{
+    if (CRC16_Check(rxBuffer, length, CRC16_INIT_VALUE))
+    {
+        if(length >= (WIMODLR_HCI_MSG_HEADER_SIZE + WIMODLR_HCI_MSG_FCS_SIZE))
+        {
+            RxThreadMessage.Length = length - (WIMODLR_HCI_MSG_HEADER_SIZE + WIMODLR_HCI_MSG_FCS_SIZE);
+
+            if (RxQueue.Push(RxThreadMessage))
+            {
+                // wake up WaitForRxData / external event loop
+                UINT64 one = 1;
+                if (write(RxEvent, &one, sizeof(one)) < 0)
+                    RxQueueOverflow++;
+            }
+            else
+            {
+                RxQueueOverflow++;
+            }
+        }
+    }
+    else
+    {
+        // counted only, no client callback from this thread
+        Rx.CRCError++;
+    }
+
+    // return same buffer again, keep receiver enabled
+    return &RxThreadMessage.SapID;
+}
+
 //------------------------------------------------------------------------------
 //
 //  DispatchRxMessage
@@ -1108,6 +1602,10 @@ TWiMODLRHCI::DispatchRxMessage(TWiMODLR_HCIMessage& rxMsg)
         }
     }
 
+    // 1b. response to an asynchronous request ?
+    if (DispatchPendingResponse(rxMsg))
+        return;
+
     // 2. forward async received messages to corresponding SAP
     switch(rxMsg.SapID)
     {
@@ -1198,21 +1696,21 @@ TWiMODLRHCI::DispatchRadioLinkMessage(TWiMODLR_HCIMessage& rxMsg)
 //------------------------------------------------------------------------------
 
 void
-TWiMODLRHCI::ShowMessage(const QString& string, const TWiMODLR_HCIMessage& msg)
+TWiMODLRHCI::ShowMessage(std::string_view string, const TWiMODLR_HCIMessage& msg)
 {
     if (!Client)
         return;
 
     Client->evRadio_ShowMessage("WiMODLRHCI", string);
 
-    QString sapID = QString("%1").arg(msg.SapID, 2, 16, QLatin1Char('0')).toUpper();
-    QString msgID = QString("%1").arg(msg.MsgID, 2, 16, QLatin1Char('0')).toUpper();
-    QString str   = QString("RxMsg:SapID:") + sapID + QString(";MsgID:") + msgID + QString(";Length:%3;Payload:").arg(msg.Length);
+    // header + "XX " per payload byte
+    TFixedString<64 + 3 * WIMODLR_HCI_MSG_PAYLOAD_SIZE> str;
+    str.AppendFormat("RxMsg:SapID:%02X;MsgID:%02X;Length:%u;Payload:", msg.SapID, msg.MsgID, msg.Length);
 
     int i = 0;
     int length = msg.Length;
     while(length--)
-        str.append(QString("%1 ").arg(msg.Payload[i++], 2, 16, QLatin1Char('0')).toUpper());
+        str.AppendFormat("%02X ", msg.Payload[i++]);
 
     Client->evRadio_ShowMessage("WiMODLRHCI", str);
 }
@@ -1226,7 +1724,7 @@ TWiMODLRHCI::ShowMessage(const QString& string, const TWiMODLR_HCIMessage& msg)
 //------------------------------------------------------------------------------
 
 void
-TWiMODLRHCI::ShowMessage(const QString& string)
+TWiMODLRHCI::ShowMessage(std::string_view string)
 {
     if (Client)
         Client->evRadio_ShowMessage("WiMODLRHCI", string);
@@ -1259,7 +1757,7 @@ TWiMODLRHCI::ShowMessage(const QString& string)
 #define RTC_GET_YEARS(t)   (((t >> 26) & 0x3F) + 2000)
 
 void
-TWiMODLRHCI::U32TimeToString(QString& timeString, UINT32 time, bool isoFormat)
+TWiMODLRHCI::U32TimeToString(TStringBuffer& timeString, UINT32 time, bool isoFormat)
 {
     UINT8   seconds =   RTC_GET_SECONDS(time);
     UINT8   minutes =   RTC_GET_MINUTES(time);
@@ -1268,20 +1766,11 @@ TWiMODLRHCI::U32TimeToString(QString& timeString, UINT32 time, bool isoFormat)
     UINT8   days    =   RTC_GET_DAYS(time);
     UINT16  years   =   RTC_GET_YEARS(time);
 
+    timeString.Clear();
     if (isoFormat)
-        timeString = QString("%1-%2-%3 %4:%5:%6").arg(years)
-                                                 .arg(months,   2, 10, QLatin1Char('0'))
-                                                 .arg(days,     2, 10, QLatin1Char('0'))
-                                                 .arg(hours,    2, 10, QLatin1Char('0'))
-                                                 .arg(minutes,  2, 10, QLatin1Char('0'))
-                                                 .arg(seconds,  2, 10, QLatin1Char('0'));
+        timeString.AppendFormat("%u-%02u-%02u %02u:%02u:%02u", years, months, days, hours, minutes, seconds);
     else
-        timeString = QString("%1.%2.%3 %4:%5:%6").arg(days,     2, 10, QLatin1Char('0'))
-                                                 .arg(months,   2, 10, QLatin1Char('0'))
-                                                 .arg(years)
-                                                 .arg(hours,    2, 10, QLatin1Char('0'))
-                                                 .arg(minutes,  2, 10, QLatin1Char('0'))
-                                                 .arg(seconds,  2, 10, QLatin1Char('0'));
+        timeString.AppendFormat("%02u.%02u.%u %02u:%02u:%02u", days, months, years, hours, minutes, seconds);
 }
 
 //------------------------------------------------------------------------------
@@ -1332,27 +1821,25 @@ TWiMODLRHCI::GetStringFromTable(const TWiMODLRHCI_IDString* table, UINT8 id)
 //
 //------------------------------------------------------------------------------
 
-QString
-TWiMODLRHCI::GetCombinedStringFromTable(const TWiMODLRHCI_IDString* table, UINT8 id, int numBits)
+void
+TWiMODLRHCI::GetCombinedStringFromTable(TStringBuffer& string, const TWiMODLRHCI_IDString* table, UINT8 id, int numBits)
 {
-    QString string;
+    string.Clear();
 
     UINT8 mask = 0x01;
     for(int i = 0; i < numBits; i++)
     {
         if (id & mask)
         {
-            string.append(GetStringFromTable(table, i));
-            string.append("/");
+            string.Append(GetStringFromTable(table, i));
+            string.Append("/");
         }
         mask <<= 1;
     }
 
-    string.chop(1);
-    if (string.isEmpty())
-        string = QString("off");
-
-    return string;
+    string.Chop(1);
+    if (string.IsEmpty())
+        string.Append("off");
 }
 
 //------------------------------------------------------------------------------
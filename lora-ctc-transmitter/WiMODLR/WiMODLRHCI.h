@@ -27,6 +27,12 @@
 #include "ComSlip.h"
 #include "SerialDevice.h"
 #include "KeyValueList.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <thread>
 //------------------------------------------------------------------------------
 //
 // General Declaration
@@ -95,6 +101,18 @@ typedef uint16_t        TWiMODLRResult;
                                          + WIMODLR_HCI_MSG_PAYLOAD_SIZE\
                                          + WIMODLR_HCI_MSG_FCS_SIZE)
 
+// worst case SLIP stream: every octet escaped + 2 frame delimiters
+#define WIMODLR_SLIP_FRAME_SIZE         (2 * WIMODLR_HCI_RX_MESSAGE_SIZE + 2)
+
+// number of pre-encoded frames held in the frame cache
+#define WIMODLR_FRAME_CACHE_SIZE        16
+
+// decoded messages buffered between receiver thread and Process()
+#define WIMODLR_HCI_RX_QUEUE_SIZE       16
+
+// max. number of outstanding asynchronous requests
+#define WIMODLR_HCI_MAX_PENDING         8
+
 //------------------------------------------------------------------------------
 //
 // HCI Message
@@ -133,9 +151,56 @@ typedef enum
     WiMODLR_RESULT_PAYLOAD_PTR_ERROR,
     WiMODLR_RESULT_TRANMIT_ERROR,
     WiMODLR_RESULT_SLIP_ENCODER_ERROR,
-    WiMODLR_RESULT_NO_RESPONSE
+    WiMODLR_RESULT_NO_RESPONSE,
+    WiMODLR_RESULT_FRAME_NOT_CACHED,
+    WiMODLR_RESULT_TOO_MANY_REQUESTS
 }TWiMDLRResultCodes;
 
+//------------------------------------------------------------------------------
+//
+// Asynchronous Response
+//
+//------------------------------------------------------------------------------
+
+typedef struct
+{
+    // WiMODLR_RESULT_OK or WiMODLR_RESULT_NO_RESPONSE on timeout
+    TWiMODLRResult      Result;
+
+    // response message, valid if Result == WiMODLR_RESULT_OK
+    TWiMODLR_HCIMessage Message;
+
+}TWiMODLR_HCIResponse;
+
+// response handler, called from Process()
+typedef std::function<void(const TWiMODLR_HCIResponse& response)> TWiMODLRResponseHandler;
+
+//------------------------------------------------------------------------------
+//
+// Frame Cache Entry
+//
+// fully encoded SLIP stream of one HCI message, keyed by (SapID, MsgID, Length)
+//
+//------------------------------------------------------------------------------
+
+typedef struct
+{
+    // entry in use
+    bool    Valid;
+
+    // key
+    UINT8   SapID;
+    UINT8   MsgID;
+    UINT16  Length;
+
+    // length of SLIP stream
+    int     TxLength;
+
+    // SLIP stream incl. CRC16 and frame delimiters
+    UINT8   Buffer[WIMODLR_SLIP_FRAME_SIZE];
+
+}TWiMODLR_CachedFrame;
+
 //------------------------------------------------------------------------------
 //
 // Radio Configuration
@@ -197,7 +262,7 @@ class TWiMODLRHCIClient
     virtual             ~TWiMODLRHCIClient() {}
 
     // define debug callback function
-    virtual void        evRadio_ShowMessage(const QString& /* prefix */, const QString& /* msg */) {}
+    virtual void        evRadio_ShowMessage(std::string_view /* prefix */, std::string_view /* msg */) {}
 
     // define handler for received unreliable messages
     virtual void        evRadioLink_RxUMessage(const TWiMODLR_HCIMessage& /* rxMsg */) {}
@@ -239,12 +304,29 @@ class TWiMODLRHCI : public TComSlipClient
     void                RegisterClient(TWiMODLRHCIClient* client) { Client = client; }
 
     // connection handling
-    bool                Open(const QString& comPort);
+    bool                Open(std::string_view comPort);
     bool                Close();
     void                Process();
 
+    // asynchronous receiver thread
+    bool                StartReceiver();
+    void                StopReceiver();
+    int                 GetRxEventHandle() const { return RxEvent; }
+    int                 GetRxQueueOverflow() const { return RxQueueOverflow; }
+
+    // serial device, e.g. for tx profiling
+    TSerialDevice&      GetSerialDevice() { return SerialDevice; }
+
+    // asynchronous requests, completed from Process()
+    TWiMODLRResult      SendHCIMessageAsync(UINT8 sapID, UINT8 msgID, UINT8 rxMsgID, const TWiMODLRResponseHandler& handler,
+                                            UINT8* payload = 0, UINT16 length = 0, int timeout = 1000);
+    std::future<TWiMODLR_HCIResponse>
+                        SendHCIMessageFuture(UINT8 sapID, UINT8 msgID, UINT8 rxMsgID,
+                                             UINT8* payload = 0, UINT16 length = 0, int timeout = 1000);
+
     // device management commands
     TWiMODLRResult      PingRequest();
+    TWiMODLRResult      PingRequestAsync(const TWiMODLRResponseHandler& handler);
     TWiMODLRResult      FactoryReset();
     TWiMODLRResult      GetRadioConfiguration(TWiMODLR_RadioConfig& config, UINT8& status);
     TWiMODLRResult      SetRadioConfiguration(TWiMODLR_RadioConfig& config, UINT8 destMemory, UINT8& status);
@@ -256,16 +338,23 @@ class TWiMODLRHCI : public TComSlipClient
     // radio link services
     TWiMODLRResult      SendURadioMessage(UINT8* txMessage, UINT16 length, UINT8& status);
     TWiMODLRResult      SendURadioMessage2(UINT8* txMessage, UINT16 length, UINT8& status);
+    TWiMODLRResult      CacheURadioMessage(UINT8* txMessage, UINT16 length);
+    TWiMODLRResult      SendCachedURadioMessage(UINT16 length);
     void                ConvertRadioRxMessage(TKeyValueList& list, const TWiMODLR_HCIMessage& rxMsg);
 
 
     const char*         GetRadioLinkStatusString(UINT8 status);
 
     // other helper functions
-    void                U32TimeToString(QString& timeString, UINT32 time, bool isoFormat = true);
+    void                U32TimeToString(TStringBuffer& timeString, UINT32 time, bool isoFormat = true);
     UINT32              GetFrequencyFromConfig(UINT32 regConfig);
     const char*         GetStringFromTable(const TWiMODLRHCI_IDString* table, UINT8 id);
-    QString             GetCombinedStringFromTable(const TWiMODLRHCI_IDString* table, UINT8 id, int numBits);
+    void                GetCombinedStringFromTable(TStringBuffer& string, const TWiMODLRHCI_IDString* table, UINT8 id, int numBits);
+
+    // frame cache for repeated transmissions
+    TWiMODLRResult      CacheHCIMessage(UINT8 sapID, UINT8 msgID, UINT8* payload = 0, UINT16 length = 0);
+    TWiMODLRResult      SendCachedHCIMessage(UINT8 sapID, UINT8 msgID, UINT16 length = 0);
+    void                ClearFrameCache();
 
 
     private:
@@ -276,11 +365,21 @@ class TWiMODLRHCI : public TComSlipClient
     TWiMODLRResult      PostMessage(UINT8 sapId, UINT8 msgID, UINT8* payload = 0, UINT16 length = 0);
     TWiMODLRResult      PostMessage2(UINT8 sapId, UINT8 msgID, UINT8* payload = 0, UINT16 length = 0);
     TWiMODLRResult      SendPacket(UINT8* txData, UINT16 length);
-    TWiMODLRResult      SendPacket2(UINT8* txData, UINT16 length);
+    UINT16              PrepareMessage(UINT8 sapID, UINT8 msgID, UINT8* payload, UINT16 length);
+
+    // frame cache lookup
+    TWiMODLR_CachedFrame* FindCachedFrame(UINT8 sapID, UINT8 msgID, UINT16 length);
 
     // receiver functions
     bool                WaitForResponse(UINT8 rxSapID, UINT8 rxMsgID);
+    bool                WaitForRxData(int timeout);
     UINT8*              ProcessRxMessage(UINT8* rxBuffer, UINT16 length);
+    UINT8*              QueueRxMessage(UINT8* rxBuffer, UINT16 length);
+    void                ReceiverLoop();
+
+    // asynchronous request handling
+    bool                DispatchPendingResponse(TWiMODLR_HCIMessage& rxMsg);
+    void                ExpirePendingRequests();
 
     // dispatcher functions
     void                DispatchRxMessage           (TWiMODLR_HCIMessage& rxMsg);
@@ -288,8 +387,8 @@ class TWiMODLRHCI : public TComSlipClient
     void                DispatchRadioLinkMessage    (TWiMODLR_HCIMessage& rxMsg);
 
     // debug support
-    void                ShowMessage(const QString& msg, const TWiMODLR_HCIMessage& rxMsg);
-    void                ShowMessage(const QString& msg);
+    void                ShowMessage(std::string_view msg, const TWiMODLR_HCIMessage& rxMsg);
+    void                ShowMessage(std::string_view msg);
 
 
     private:
@@ -310,7 +409,7 @@ class TWiMODLRHCI : public TComSlipClient
         // reserve one Rx-Message-Buffer
         TWiMODLR_HCIMessage Message;
         // CRC error counter
-        int         CRCError;
+        std::atomic<int> CRCError;
         // Timeout (~1000ms)
         int         Timeout;
         // reserve one rx-buffer for recepton of SLIP encoded octet sequence
@@ -322,6 +421,12 @@ class TWiMODLRHCI : public TComSlipClient
     // reserve one tx-buffer for transmission of SLIP encoded octet sequence
     UINT8               TxBuffer[512];
 
+    // pre-encoded frames, see CacheHCIMessage
+    TWiMODLR_CachedFrame FrameCache[WIMODLR_FRAME_CACHE_SIZE];
+
+    // index of last cache hit, checked first
+    int                 FrameCacheHit;
+
     // SLIP communication layer instance
     TComSlip            ComSlip;
 
@@ -330,6 +435,36 @@ class TWiMODLRHCI : public TComSlipClient
 
     TWiMODLRHCIClient*  Client;
 
+    // outstanding asynchronous request
+    typedef struct
+    {
+        bool        Active;
+        // SAP ID / Msg ID of expected response
+        UINT8       SapID;
+        UINT8       MsgID;
+        // order of submission, oldest request matches first
+        UINT32      Sequence;
+        std::chrono::steady_clock::time_point Deadline;
+        TWiMODLRResponseHandler Handler;
+    }TPendingRequest;
+
+    TPendingRequest     Pending[WIMODLR_HCI_MAX_PENDING];
+    UINT32              PendingSequence;
+
+    // receiver thread, owns RxComSlip and RxThreadMessage
+    std::thread         RxThread;
+    std::atomic<bool>   RxThreadRunning;
+    int                 EpollHandle;
+    int                 StopEvent;
+    int                 RxEvent;
+    TComSlip            RxComSlip;
+    TWiMODLR_HCIMessage RxThreadMessage;
+    UINT8               RxThreadBuffer[512];
+    std::atomic<int>    RxQueueOverflow;
+
+    // decoded messages, receiver thread -> Process()
+    TSpscQueue<TWiMODLR_HCIMessage, WIMODLR_HCI_RX_QUEUE_SIZE> RxQueue;
+
 
 
 
@@ -0,0 +1,351 @@
+//------------------------------------------------------------------------------
+//
+//	File:		SlipBench.cpp
+//
+//	Abstract:	SLIP Encoder/Decoder Throughput Benchmark
+//
+//	Version:	0.1
+//
+//	Date:		17.10.2026
+//
+//------------------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+//
+//  Include Files
+//
+//------------------------------------------------------------------------------
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ComSlip.h"
+
+//------------------------------------------------------------------------------
+//
+//  General Definitions
+//
+//------------------------------------------------------------------------------
+
+#define SLIP_END                    0xC0
+#define SLIP_ESC                    0xDB
+#define SLIP_ESC_END                0xDC
+#define SLIP_ESC_ESC                0xDD
+
+// encoded frames per stream
+#define BENCH_FRAMES                256
+
+// worst case: every byte escaped, plus END bytes
+#define BENCH_FRAME_SIZE            (2 * 1024 + 2)
+
+//------------------------------------------------------------------------------
+//
+//  TLegacySlip - byte by byte SLIP coder as used before the fast path
+//
+//------------------------------------------------------------------------------
+
+class TLegacySlip
+{
+public:
+    TLegacySlip()
+    {
+        RxState  = 0;
+        RxIndex  = 0;
+        RxBuffer = 0;
+        RxSize   = 0;
+        RxClient = 0;
+    }
+
+    void RegisterClient(TComSlipClient* client) { RxClient = client; }
+
+    bool SetRxBuffer(UINT8* rxBuffer, UINT16 rxBufferSize)
+    {
+        RxBuffer = rxBuffer;
+        RxSize   = rxBufferSize;
+        RxState  = 1;
+        return true;
+    }
+
+    int EncodeData(UINT8* dstBuffer, UINT16 dstBufferSize, UINT8* srcPtr, UINT16 msgLength)
+    {
+        TxBuffer = dstBuffer;
+        TxIndex  = 0;
+        TxSize   = dstBufferSize;
+
+        StoreTxByte(SLIP_END);
+        while(msgLength--)
+        {
+            switch (*srcPtr)
+            {
+                case SLIP_END:
+                    StoreTxByte(SLIP_ESC);
+                    StoreTxByte(SLIP_ESC_END);
+                    break;
+
+                case SLIP_ESC:
+                    StoreTxByte(SLIP_ESC);
+                    StoreTxByte(SLIP_ESC_ESC);
+                    break;
+
+                default:
+                    StoreTxByte(*srcPtr);
+                    break;
+            }
+            srcPtr++;
+        }
+        StoreTxByte(SLIP_END);
+        return TxIndex;
+    }
+
+    void DecodeData(UINT8* rxData, UINT16 length)
+    {
+        while(length--)
+        {
+            UINT8 rxByte = *rxData++;
+
+            switch(RxState)
+            {
+                case 1:
+                    if (rxByte == SLIP_END)
+                    {
+                        RxIndex = 0;
+                        RxState = 2;
+                    }
+                    break;
+
+                case 2:
+                    if (rxByte == SLIP_END)
+                    {
+                        if (RxIndex > 0)
+                        {
+                            RxBuffer = RxClient->ProcessRxMessage(RxBuffer, RxIndex);
+                            RxState  = RxBuffer ? 1 : 0;
+                        }
+                        RxIndex = 0;
+                    }
+                    else if (rxByte == SLIP_ESC)
+                        RxState = 3;
+                    else
+                        StoreRxByte(rxByte);
+                    break;
+
+                case 3:
+                    if (rxByte == SLIP_ESC_END || rxByte == SLIP_ESC_ESC)
+                    {
+                        StoreRxByte(rxByte == SLIP_ESC_END ? SLIP_END : SLIP_ESC);
+                        RxState = 2;
+                    }
+                    else
+                        RxState = 1;
+                    break;
+
+                default:
+                    break;
+            }
+        }
+    }
+
+private:
+    void StoreTxByte(UINT8 txByte)
+    {
+        if (TxIndex < TxSize)
+            TxBuffer[TxIndex++] = txByte;
+    }
+
+    void StoreRxByte(UINT8 rxByte)
+    {
+        if (RxIndex < RxSize)
+            RxBuffer[RxIndex++] = rxByte;
+    }
+
+    int             RxState;
+    UINT16          RxIndex;
+    UINT8*          RxBuffer;
+    UINT16          RxSize;
+    TComSlipClient* RxClient;
+    UINT8*          TxBuffer;
+    UINT16          TxSize;
+    UINT16          TxIndex;
+};
+
+//------------------------------------------------------------------------------
+//
+//  TBenchClient - counts decoded frames and bytes, keeps one rx-buffer
+//
+//------------------------------------------------------------------------------
+
+class TBenchClient : public TComSlipClient
+{
+public:
+    UINT8*  ProcessRxMessage(UINT8* rxBuffer, UINT16 rxLength) override
+    {
+        Frames++;
+        Bytes += rxLength;
+        Check ^= rxBuffer[rxLength - 1];
+        return rxBuffer;
+    }
+
+    UINT32  Frames = 0;
+    UINT64  Bytes  = 0;
+    UINT8   Check  = 0;
+};
+
+//------------------------------------------------------------------------------
+//
+//  Test Data
+//
+//------------------------------------------------------------------------------
+
+static UINT8    Payload[BENCH_FRAMES][1024];
+static UINT8    Stream[BENCH_FRAMES * BENCH_FRAME_SIZE];
+static UINT8    Frame[BENCH_FRAME_SIZE];
+static UINT8    RxBuffer[1024];
+
+// payload bytes are SLIP_END/SLIP_ESC with probability special / 256
+static void
+FillPayload(int special)
+{
+    srand(1);
+    for(int i = 0; i < BENCH_FRAMES; i++)
+    {
+        for(int j = 0; j < 1024; j++)
+        {
+            int r = rand();
+
+            if ((r & 0xFF) < special)
+                Payload[i][j] = (r & 0x100) ? SLIP_END : SLIP_ESC;
+            else
+                Payload[i][j] = (UINT8)(r >> 9) % 0xC0;
+        }
+    }
+}
+
+static double
+Seconds(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//------------------------------------------------------------------------------
+//
+//  Measure
+//
+//  @brief: encode and decode BENCH_FRAMES payloads of size bytes until
+//          minBytes payload bytes were processed, returns MB/s
+//
+//------------------------------------------------------------------------------
+
+template <class TSlip>
+static void
+Measure(int size, UINT64 minBytes, double& encMBs, double& decMBs, UINT8& check)
+{
+    TSlip           slip;
+    TBenchClient    client;
+    int             streamLength = 0;
+    UINT64          bytes = 0;
+
+    slip.RegisterClient(&client);
+    slip.SetRxBuffer(RxBuffer, sizeof(RxBuffer));
+
+    // encoder: one frame per call, as the HCI sends
+    auto start = std::chrono::steady_clock::now();
+    while(bytes < minBytes)
+    {
+        for(int i = 0; i < BENCH_FRAMES; i++)
+        {
+            int n = slip.EncodeData(Frame, sizeof(Frame), Payload[i], size);
+            check ^= Frame[n / 2];
+        }
+        bytes += (UINT64)BENCH_FRAMES * size;
+    }
+    encMBs = bytes / Seconds(start) / 1e6;
+
+    for(int i = 0; i < BENCH_FRAMES; i++)
+        streamLength += slip.EncodeData(Stream + streamLength, BENCH_FRAME_SIZE, Payload[i], size);
+
+    // decoder: serial reads of 256 bytes
+    bytes = 0;
+    start = std::chrono::steady_clock::now();
+    while(bytes < minBytes)
+    {
+        for(int pos = 0; pos < streamLength; pos += 256)
+        {
+            int n = streamLength - pos < 256 ? streamLength - pos : 256;
+            slip.DecodeData(Stream + pos, n);
+        }
+        bytes += (UINT64)BENCH_FRAMES * size;
+    }
+    decMBs = bytes / Seconds(start) / 1e6;
+
+    if (client.Bytes != bytes)
+    {
+        printf("error: %u frames / %llu bytes decoded, %llu expected\n",
+               client.Frames, (unsigned long long)client.Bytes, (unsigned long long)bytes);
+        exit(1);
+    }
+    check ^= client.Check;
+}
+
+static void
+RunCase(const char* name, int special, int size, UINT64 minBytes)
+{
+    double  legacyEnc, legacyDec, fastEnc, fastDec;
+    UINT8   check = 0;
+
+    FillPayload(special);
+
+    // both coders must produce the same frames
+    for(int i = 0; i < BENCH_FRAMES; i++)
+    {
+        static UINT8 legacyFrame[BENCH_FRAME_SIZE];
+        TLegacySlip  legacy;
+        TComSlip     fast;
+        int          n = legacy.EncodeData(legacyFrame, sizeof(legacyFrame), Payload[i], size);
+
+        if ((fast.EncodeData(Frame, sizeof(Frame), Payload[i], size) != n) || memcmp(Frame, legacyFrame, n))
+        {
+            printf("error: %s frame %d differs\n", name, i);
+            exit(1);
+        }
+    }
+
+    Measure<TLegacySlip>(size, minBytes, legacyEnc, legacyDec, check);
+    Measure<TComSlip>(size, minBytes, fastEnc, fastDec, check);
+
+    printf("%-8s %5d  encode %8.1f -> %8.1f MB/s (x%4.1f)  decode %8.1f -> %8.1f MB/s (x%4.1f)  [%02X]\n",
+           name, size,
+           legacyEnc, fastEnc, fastEnc / legacyEnc,
+           legacyDec, fastDec, fastDec / legacyDec, check);
+}
+
+//------------------------------------------------------------------------------
+//
+//  main
+//
+//  usage: slip_bench [MB per case]
+//
+//------------------------------------------------------------------------------
+
+int
+main(int argc, char* argv[])
+{
+    UINT64 minBytes = (UINT64)(argc > 1 ? atoi(argv[1]) : 64) * 1000000;
+    static const int sizes[] = { 16, 64, 255, 1024 };
+
+    printf("payload   size  legacy -> fast\n");
+    for(int size : sizes)
+    {
+        // random data: ~1 of 256 bytes escaped
+        RunCase("random", 1, size, minBytes);
+        // text / counters: nothing escaped
+        RunCase("clean", 0, size, minBytes);
+        // worst case: ~1 of 4 bytes escaped
+        RunCase("dense", 64, size, minBytes);
+    }
+    return 0;
+}
+
+//------------------------------------------------------------------------------
+// end of file
+//------------------------------------------------------------------------------
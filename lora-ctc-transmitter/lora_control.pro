@@ -1,7 +1,8 @@
-QT += core
-QT -= gui
+# plain C++, no Qt modules are linked
+QT -= core gui
+CONFIG -= qt
 
-CONFIG += c++11
+CONFIG += c++17
 
 TARGET = lora_control
 CONFIG += console
@@ -11,6 +12,8 @@ TEMPLATE = app
 
 INCLUDEPATH += WiMODLR
 INCLUDEPATH += Utils
+INCLUDEPATH += ../telosb-testbed/core/net/mac/tsch
+INCLUDEPATH += ../telosb-testbed/evaluation-tools
 
 SOURCES += main.cpp \
     Utils/ComSlip.cpp \
@@ -19,18 +22,12 @@ SOURCES += main.cpp \
     Utils/RegistryKey.cpp \
     Utils/SerialDevice.cpp \
     WiMODLR/WiMODLRHCI.cpp \
-    MainWindow2.cpp
-
-# The following define makes your compiler emit warnings if you use
-# any feature of Qt which as been marked deprecated (the exact warnings
-# depend on your compiler). Please consult the documentation of the
-# deprecated API in order to know how to port your code away from it.
-DEFINES += QT_DEPRECATED_WARNINGS
-
-# You can also make your code fail to compile if you use deprecated APIs.
-# In order to do so, uncomment the following line.
-# You can also select to disable deprecated APIs only up to a certain version of Qt.
-#DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
+    MainWindow2.cpp \
+    Utils/SlotScheduler.cpp \
+    Utils/CtcCalibration.cpp \
+    ../telosb-testbed/core/net/mac/tsch/ctc-codebook.c \
+    Utils/DownlinkQueue.cpp \
+    Utils/StringList.cpp
 
 HEADERS += \
     Utils/ComSlip.h \
@@ -41,4 +38,11 @@ HEADERS += \
     WiMODLR/WiMODLRHCI.h \
     WiMODLR/WiMODLRHCI_IDs.h \
     WiMODLR/WMDefs.h \
-    MainWindow2.h
+    MainWindow2.h \
+    Utils/SlotScheduler.h \
+    Utils/SpscQueue.h \
+    Utils/CtcCalibration.h \
+    ../telosb-testbed/core/net/mac/tsch/ctc-codebook.h \
+    ../telosb-testbed/evaluation-tools/evlog.h \
+    Utils/DownlinkQueue.h \
+    Utils/StringList.h
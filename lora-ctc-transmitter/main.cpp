@@ -1,102 +1,259 @@
 #include "MainWindow2.h"
+#include "SlotScheduler.h"
+#include "CtcCalibration.h"
+#include "ctc-codebook.h"
+#include "DownlinkQueue.h"
 #include <unistd.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <iostream>
+#include <thread>
 #include <time.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
 
 UINT8 txMessage[255];
-TMainWindow w;
+TCtcCodeTable ctc; //payload length and tx offset per code
+TCtcCalibration* cal; //set while the pulse calibration sequence is sent
+TDownlinkQueue dlq; //downlink messages of all transmitters
+const char* dl_path; //downlink command input, 0: fixed app_code
 
-#define ASN_ENCODING 0
-#define N_CODE sizeof(payloadlen)
+#define ASN_ENCODING 1 //ASN words in sync slots, 0: bell only (legacy codebook nodes)
+#define CODEBOOK ctc_cb_dense //must match CTC_CONF_CODEBOOK of the nodes
+#define MAX_TX 4 //transmitters driven by one process
+#define DEFAULT_PORT "ttyUSB1" //used if no port is given
+#define RT_PRIORITY 80 //SCHED_FIFO priority of the slot loops, 0: keep default policy
+#define RT_CPU 1 //core of transmitter 0, transmitter n runs on RT_CPU + n (wraps at the core count), -1: no pinning
+#define START_DELAY 2 //[s] from the end of init to slot 0 of the common grid
+#define MEASURE_SLOTS 4000 //jitter measurement before frame control, 0: off
+#define MEASURE_GAP 20 //[s] between measurement and frame control
+#define STATS_PERIOD 4000 //slots between jitter reports, 0: off
+#define PING_RTT 1 //non-blocking ping with every jitter report
+#define TX_CALIBRATION 0 //rounds of serial tx lead calibration at startup, 0: off
+#define TX_PROFILE "txprofile" //calibration histograms, <name>-<port>.csv, 0: no export
+#define DL_SOCKET "/tmp/lora_control.sock" //downlink commands "flow seqno cmd [prio [tx]]", "-": stdin, 0: off
+#define DL_REPEATS 2 //sends of a downlink message while nothing else is queued
+#define CODE_TABLE "ctc_codes.txt" //calibrated code table, replaces the defaults if present
+#define CAL_BLOCK 10 //APP frames per code during pulse calibration
+#define CAL_ROUNDS 3 //passes over all codes during pulse calibration
+#define CAL_CODES 11 //codes of the fitted table
+#define BIN0 2350 //upper bound of the shortest pulse, see ctc_decode() on the node
+#define N_CODE ((uint8_t)ctc.Codes)
 #define ABS(x) ((x) > 0 ? (x) : -1 * (x))
 
-const uint8_t payloadlen[] = {32,39,47,54,62,69,77,84,92,99,107}; //9,17,23
+const uint8_t payloadlen[] = {32,39,47,54,62,69,77,84,92,99,107}; //9,17,23; defaults without CODE_TABLE
 const uint8_t ctc_slot[] = {0, 0, 50};
 const uint8_t ctc_len[] = {1, 0, 1};
 const uint32_t HEADWAIT = 12795; //11150: rough constant for all codes; 12795: max
+const uint32_t CODE_STEP = 300; //pulse width step between codes
 const uint32_t SLOT_LEN = 15011; //was 15021
 const uint32_t fr_len[] = {397, 31, 101};
 const char* fr_name[] = {"SYNC", "RPL", "APP"};
-const uint8_t SYNC_CODES = 4, SYNC_PERIOD = 8;
+const int8_t app_code[MAX_TX] = {5, 5, 5, 5}; //fixed code per transmitter without downlink queue, -1: silent
 enum frame_type {FR_EB, FR_RPL, FR_APP, N_FR};
-enum timer_id {T_SLOT, N_TIMER};
 
-uint32_t stopwatch(uint8_t num, uint8_t cmd) {
-	static struct timespec ts[N_TIMER][2];
-	clock_gettime(CLOCK_MONOTONIC_RAW, &ts[num][cmd]);
-	return cmd ? (ts[num][1].tv_sec - ts[num][0].tv_sec) * 1000000
-		+ (ts[num][1].tv_nsec - ts[num][0].tv_nsec) / 1000 : 0;
+struct transmitter {
+	TMainWindow w;
+	TSlotScheduler sched; //all schedulers share one epoch, i.e. one ASN grid
+	const char* port;
+	double freq; //[Hz]
+	uint8_t id;
+	INT32 txlead[CTC_MAX_CODES]; //serial drain compensation per code [us], see calibrate()
+	int8_t word[CTC_CB_MAX_SYMBOLS]; //pending ASN sync word
+	TDownlinkStream dl{DL_REPEATS}; //downlink messages in APP slots
+	std::thread thread;
+};
+transmitter tx[MAX_TX];
+uint8_t n_tx;
+
+/* code sent by transmitter t in the active slot of frame type ff,
+ * -1: stay silent. All transmitters see the same ASN. */
+int8_t assign_code(transmitter& t, uint8_t ff, uint32_t fr_num) {
+	if (ff == FR_EB) { //sync is sent by all transmitters to cover the whole plant
+#if ASN_ENCODING
+		uint8_t period = ctc_cb_period(&CODEBOOK);
+		if (fr_num % period == 0) { //word index of the next bell, wraps at the capacity
+			ctc_cb_encode(&CODEBOOK, (fr_num / period + 1) % ctc_cb_capacity(&CODEBOOK), t.word);
+			return CODEBOOK.codes - 1; //bell
+		}
+		return t.word[fr_num % period - 1];
+#else
+		return N_CODE - 1;
+#endif
+	}
+	if (ff == FR_APP) {
+		if (cal) return cal->ExpectedCode(fr_num);
+		if (dl_path && app_code[t.id] >= 0) return t.dl.NextCode(dlq, t.id);
+		return app_code[t.id];
+		//return fr_num % ((N_CODE - EB_CODES) / 2) * 2;
+		//0,1,2,3 -> 0,2,4,6
+	}
+	return -1;
 }
 
-void wait_slot() {
-	stopwatch(T_SLOT, 0);
-	while (stopwatch(T_SLOT, 1) < SLOT_LEN);
+void wait_slot(transmitter& t) {
+	t.w.Poll(); //dispatch radio responses, never blocks
+	t.sched.NextSlot();
 }
 
-void encode(uint8_t code) {
-	stopwatch(T_SLOT, 0);
-	while (stopwatch(T_SLOT, 1) < HEADWAIT - code * 300);
-	w.cmdRadioLink_SendUMessage2(payloadlen[code]);
-	while (stopwatch(T_SLOT, 1) < SLOT_LEN);
+void encode(transmitter& t, uint8_t code) {
+	t.sched.WaitUntil(ctc.Offset[code] - t.txlead[code]);
+	t.w.cmdRadioLink_SendUMessage2(ctc.Length[code]);
+	t.w.Poll();
+	t.sched.NextSlot();
 }
 
-void num2pay(uint32_t num, uint8_t base, uint8_t len, uint8_t* payload) {
-	uint8_t ii;
-	for (ii = 1; ii <= len; ii++) {
-		payload[len - ii] = num % base;
-		num /= base;
-	}
+void report(transmitter& t, const char* what) {
+	char name[64];
+	snprintf(name, sizeof(name), "[%u %s] %s", t.id, t.port, what);
+	t.sched.PrintStats(stdout, name);
+	t.sched.ResetStats();
+	if (dl_path) printf("%s: %u downlink messages sent, %d queued\n", name, t.dl.Messages, dlq.Size());
+	if (PING_RTT) t.w.cmdDevice_PingAsync();
 }
 
-void framecontrol() {
+void framecontrol(transmitter& t, const struct timespec& epoch, uint32_t app_frames) { //0: run forever
 	uint32_t asn = 0, fr_num;
-	uint8_t ff, payload[SYNC_PERIOD - 1];
+	uint8_t ff;
+	int8_t code;
+	t.sched.Start(epoch, SLOT_LEN);
 	for (;;) for (ff = 0; ; ff++) {
+		if (ff == 0 && STATS_PERIOD && asn % STATS_PERIOD == 0 && asn) report(t, "slot jitter");
 		if (ff == N_FR) { //not an active slot
-			wait_slot(); asn += 1; break;
+			wait_slot(t); asn += 1; break;
 		}
 		if (asn % fr_len[ff] != ctc_slot[ff]) continue;
 		//printf("** %s slot, ASN = %d\n", fr_name[ff], asn);
-		if (!ctc_len[ff]) { //pass slot
-			wait_slot(); asn += 1; break;
-		}
 		fr_num = asn / fr_len[ff];
-		if (ff == FR_EB) {
-#if ASN_ENCODING
-			if (fr_num % SYNC_PERIOD == 0) {
-				encode(N_CODE - 1); //bell
-				num2pay(fr_num / SYNC_PERIOD + 1, SYNC_CODES - 1, SYNC_PERIOD - 1, payload); //new payload
-			}
-			else {
-				encode(N_CODE - SYNC_CODES + payload[fr_num % SYNC_PERIOD - 1]);
-			}
-#else
-			encode(N_CODE - 1);
-#endif
+		code = ctc_len[ff] ? assign_code(t, ff, fr_num) : -1;
+		if (code < 0) { //pass slot
+			wait_slot(t); asn += 1; break;
 		}
-		else if (ff == FR_APP) encode(5);
-			//encode(fr_num % ((N_CODE - EB_CODES) / 2) * 2);
-			//0,1,2,3 -> 0,2,4,6
+		encode(t, code);
+		if (ff == FR_APP && app_frames && fr_num + 1 >= app_frames) return;
 		asn += ctc_len[ff];
 		break;
 	}
 }
 
-void measure(uint16_t cnt) {
-	while (cnt--) encode(N_CODE - 1);
-	sleep(20);
+void measure(transmitter& t, const struct timespec& epoch, uint16_t cnt) {
+	t.sched.Start(epoch, SLOT_LEN);
+	while (cnt--) encode(t, N_CODE - 1);
+	report(t, "measure jitter");
+}
+
+void run(transmitter& t, struct timespec epoch) {
+	TSlotScheduler::SetAffinity(RT_CPU < 0 ? -1 : RT_CPU + t.id);
+	TSlotScheduler::SetRealtime(RT_PRIORITY);
+	if (MEASURE_SLOTS) {
+		measure(t, epoch, MEASURE_SLOTS);
+		epoch.tv_sec += (INT64)MEASURE_SLOTS * SLOT_LEN / 1000000 + 1 + MEASURE_GAP; //same for all threads
+	}
+	framecontrol(t, epoch, 0);
+}
+
+void calibrate(transmitter& t) {
+	char file[64];
+	const char* port;
+	if (!TX_CALIBRATION) return;
+	if (!t.w.cmdRadioLink_CalibrateTx(ctc.Length, N_CODE, TX_CALIBRATION, t.txlead))
+		memset(t.txlead, 0, sizeof(t.txlead)); //keep the uncompensated schedule
+	if (!TX_PROFILE) return;
+	port = strrchr(t.port, '/'); //"/dev/ttyUSB0" -> "ttyUSB0"
+	snprintf(file, sizeof(file), "%s-%s.csv", TX_PROFILE, port ? port + 1 : t.port);
+	t.w.cmdRadioLink_SaveTxProfile(file);
+}
+
+bool calibrate_codes(transmitter& t, const char* nodelog) {
+	TCtcCalibration c(N_CODE, CAL_BLOCK, fr_len[FR_APP]);
+	TCtcCodeTable fitted;
+	struct timespec now;
+	FILE* in = fopen(nodelog, "r"); //written by serialdump of the node
+	if (!in) {
+		printf("error - cannot read %s\n", nodelog);
+		return false;
+	}
+	fseek(in, 0, SEEK_END); //only lines logged from now on
+	printf("* pulse calibration on %s: %u APP frames, node log %s\n", t.port, c.Frames(CAL_ROUNDS), nodelog);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	cal = &c;
+	framecontrol(t, now, c.Frames(CAL_ROUNDS));
+	cal = 0;
+	sleep(2); //last lines on their way through serialdump
+	clearerr(in);
+	c.ParseLog(in);
+	fclose(in);
+	if (!c.Fit(ctc, fitted, CAL_CODES, BIN0, CODE_STEP)) return false;
+	fitted.Print(stdout);
+	if (!fitted.Save(CODE_TABLE)) {
+		printf("error - cannot write %s\n", CODE_TABLE);
+		return false;
+	}
+	printf("* saved %s\n", CODE_TABLE);
+	return true;
+}
+
+/* one "flow seqno cmd [prio [tx]]" line per message, answered with
+ * "ok <queued>" or "error" */
+void dl_serve(FILE* in, FILE* out) {
+	char line[128];
+	TDownlinkMessage msg;
+	while (fgets(line, sizeof(line), in)) {
+		bool ok = TDownlinkQueue::Parse(line, msg) && dlq.Push(msg);
+		if (ok) fprintf(out, "ok %d\n", dlq.Size());
+		else fprintf(out, "error\n");
+		fflush(out);
+	}
+}
+
+/* command thread: stdin or one client of a UNIX stream socket at a time */
+void dl_server(const char* path) {
+	struct sockaddr_un addr;
+	int fd, client;
+	if (!strcmp(path, "-")) {
+		dl_serve(stdin, stdout);
+		return;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+	signal(SIGPIPE, SIG_IGN); //clients may leave before the answer
+	unlink(path);
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 4) < 0) {
+		printf("error - downlink socket %s\n", path);
+		return;
+	}
+	printf("* downlink commands on %s\n", path);
+	while ((client = accept(fd, 0, 0)) >= 0) {
+		FILE* io = fdopen(client, "r+");
+		if (!io) {
+			close(client);
+			continue;
+		}
+		dl_serve(io, io);
+		fclose(io);
+	}
 }
 
-void init() {
-	w.cmdConnection_Open();         //open serial port
-	w.cmdDevice_Ping();             //ping device
-	w.cmdDevice_FactoryReset();
+void init(transmitter& t) {
+	t.w.cmdConnection_Open(t.port);   //open serial port
+	t.w.cmdDevice_Ping();             //ping device
+	t.w.cmdDevice_FactoryReset();
 	sleep(1);
 
-	w.cmdDevice_SetRadioConfiguration(15); //set radio configuration
-	w.cmdDevice_GetRadioConfiguration();    //get current radio configuration
+	t.w.SetFrequency(t.freq);
+	t.w.cmdDevice_SetRadioConfiguration(15); //set radio configuration
+	t.w.cmdDevice_GetRadioConfiguration();    //get current radio configuration
+
+	// SLIP encode one frame per code, sent with a single write later
+	t.w.cmdRadioLink_CacheUMessages(ctc.Length, N_CODE);
+	calibrate(t);
+}
 
+void init_payload() {
 	// take default groupaddress
 	UINT8 destGroupAddress = 0x10;
 
@@ -113,12 +270,59 @@ void init() {
 
 	// prepare example payload
 	memset(txMessage+3, 'A', sizeof(txMessage)-3);
+
+	ctc.SetLinear(sizeof(payloadlen), payloadlen, HEADWAIT, CODE_STEP);
+	if (ctc.Load(CODE_TABLE)) printf("* %s: %d codes\n", CODE_TABLE, ctc.Codes);
+	ctc.Print(stdout);
 }
 
-int main() {
-	init();
-	measure(4000);
-	framecontrol();
+/* lora_control [-c nodelog] [-d socket|-] [port[@MHz] ...] */
+int main(int argc, char** argv) {
+	const char* nodelog = 0;
+	struct timespec epoch;
+	int opt;
+	uint8_t ii;
+	dl_path = DL_SOCKET;
+	while ((opt = getopt(argc, argv, "c:d:")) != -1) {
+		if (opt == 'c') nodelog = optarg;
+		else if (opt == 'd') dl_path = optarg;
+		else {
+			fprintf(stderr, "usage: %s [-c nodelog] [-d socket|-] [port[@MHz] ...]\n", argv[0]);
+			return 1;
+		}
+	}
+	for (; optind < argc && n_tx < MAX_TX; optind++, n_tx++) {
+		char* at = strchr(argv[optind], '@');
+		tx[n_tx].port = argv[optind];
+		tx[n_tx].freq = at ? atof(at + 1) * 1e6 : 2480e6;
+		if (at) *at = 0;
+	}
+	if (!n_tx) {
+		tx[0].port = DEFAULT_PORT;
+		tx[0].freq = 2480e6;
+		n_tx = 1;
+	}
+
+	init_payload();
+	for (ii = 0; ii < n_tx; ii++) {
+		tx[ii].id = ii;
+		init(tx[ii]);
+	}
+	if (nodelog) {
+		TSlotScheduler::SetAffinity(RT_CPU);
+		TSlotScheduler::SetRealtime(RT_PRIORITY);
+		return calibrate_codes(tx[0], nodelog) ? 0 : 1;
+	}
+
+	if (dl_path) std::thread(dl_server, dl_path).detach();
+
+	// one epoch for all threads keeps the transmitters on one ASN grid
+	clock_gettime(CLOCK_MONOTONIC, &epoch);
+	epoch.tv_sec += START_DELAY;
+	for (ii = 0; ii < n_tx; ii++)
+		tx[ii].thread = std::thread(run, std::ref(tx[ii]), epoch);
+	for (ii = 0; ii < n_tx; ii++)
+		tx[ii].thread.join();
 }
 
 #if 0
@@ -127,20 +331,18 @@ void encode(uint32_t word, int8_t len, int32_t offset) {
 	uint32_t code, mod; //precode
 	int8_t ii;
 	if (len < 0) { //delay only
-		stopwatch(T_SLOT, 0);
-		while (stopwatch(T_SLOT, 1) < SLOT_LEN * (uint32_t)ABS(len));
+		sched.NextSlot(ABS(len));
 		return;
 	}
 	mod = 1;
 	for (ii=0; ii<len; ii+=1) mod *= N_CODE;
 	for (ii=0; ii<len; ii+=1) {
-		stopwatch(T_SLOT, 0);
 		code = (word % mod) / (mod / N_CODE); //precode
 		//code = (code & 1) ? N_CODE - 1 - precode : precode; //one-step payload length change
 		mod /= N_CODE;
-		while (stopwatch(T_SLOT, 1) < HEADWAIT + offset - code * 300);
+		sched.WaitUntil(HEADWAIT + offset - code * 300);
 		w.cmdRadioLink_SendUMessage2(payloadlen[code]);
-		while (stopwatch(T_SLOT, 1) < SLOT_LEN);
+		sched.NextSlot();
 		//printf("code sent: %d\n", code);
 	}
 }
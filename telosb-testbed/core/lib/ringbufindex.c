@@ -95,8 +95,9 @@ ringbufindex_get(struct ringbufindex *r)
      most platforms, but C does not guarantee this.
   */
   if(((r->put_ptr - r->get_ptr) & r->mask) > 0) {
-    get_ptr = r->get_ptr;
-    r->get_ptr = (r->get_ptr + 1) & r->mask;
+    /* The element is at the next index, as in ringbufindex_peek_get() */
+    get_ptr = (r->get_ptr + 1) & r->mask;
+    r->get_ptr = get_ptr;
     return get_ptr;
   } else {
     return -1;
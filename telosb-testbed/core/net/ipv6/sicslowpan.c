@@ -104,6 +104,31 @@ void uip_log(char *msg);
 #define SICSLOWPAN_MAX_MAC_TRANSMISSIONS 4
 #endif
 
+/** \brief Number of datagrams that can be reassembled at the same
+    time, each takes a buffer of UIP_BUFSIZE. Fragments are matched to
+    their datagram by link-layer sender, tag and size. */
+#ifdef SICSLOWPAN_CONF_REASS_CONTEXTS
+#define SICSLOWPAN_REASS_CONTEXTS SICSLOWPAN_CONF_REASS_CONTEXTS
+#else
+#define SICSLOWPAN_REASS_CONTEXTS 1
+#endif
+
+/** \brief On routers, relay the fragments of datagrams that are not
+    for us to the next hop as they arrive, instead of reassembling them
+    first. Needs no reassembly buffer, only one of
+    SICSLOWPAN_FRAG_FORWARD_NB small entries per datagram in flight. */
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARD
+#define SICSLOWPAN_FRAG_FORWARD (SICSLOWPAN_CONF_FRAG_FORWARD && UIP_CONF_ROUTER)
+#else
+#define SICSLOWPAN_FRAG_FORWARD 0
+#endif
+
+#ifdef SICSLOWPAN_CONF_FRAG_FORWARD_NB
+#define SICSLOWPAN_FRAG_FORWARD_NB SICSLOWPAN_CONF_FRAG_FORWARD_NB
+#else
+#define SICSLOWPAN_FRAG_FORWARD_NB 4
+#endif
+
 #ifndef SICSLOWPAN_COMPRESSION
 #ifdef SICSLOWPAN_CONF_COMPRESSION
 #define SICSLOWPAN_COMPRESSION SICSLOWPAN_CONF_COMPRESSION
@@ -221,36 +246,56 @@ static int last_tx_status;
  *  @{
  */
 
+/** The total length of the IPv6 packet in the sicslowpan_buf. */
 static uint16_t sicslowpan_len;
 
 /**
- * The buffer used for the 6lowpan reassembly.
- * This buffer contains only the IPv6 packet (no MAC header, 6lowpan, etc).
- * It has a fix size as we do not use dynamic memory allocation.
+ * The buffer the packet being received is uncompressed to: uip_buf for
+ * headers and unfragmented packets, the buffer of its reassembly
+ * context for fragments.
  */
-static uip_buf_t sicslowpan_aligned_buf;
-#define sicslowpan_buf (sicslowpan_aligned_buf.u8)
-
-/** The total length of the IPv6 packet in the sicslowpan_buf. */
+static uint8_t *sicslowpan_buf;
 
 /**
- * length of the ip packet already sent / received.
- * It includes IP and transport headers.
+ * A datagram being reassembled.
+ * The buffer contains only the IPv6 packet (no MAC header, 6lowpan, etc).
+ * It has a fix size as we do not use dynamic memory allocation.
  */
-static uint16_t processed_ip_in_len;
+struct sicslowpan_reass {
+  uip_buf_t buf;
+  /** Reassembly %timer, started by the first fragment. */
+  struct timer timer;
+  /** The source address of the fragments being merged */
+  linkaddr_t sender;
+  /** The tag in the fragments being merged. */
+  uint16_t tag;
+  /** The size of the datagram, 0 if the context is free. */
+  uint16_t size;
+  /**
+   * length of the ip packet already received.
+   * It includes IP and transport headers.
+   */
+  uint16_t processed;
+};
+static struct sicslowpan_reass reass_contexts[SICSLOWPAN_REASS_CONTEXTS];
+
+#if SICSLOWPAN_FRAG_FORWARD
+/** A datagram whose fragments are relayed to the next hop. */
+struct sicslowpan_frag_forward {
+  struct timer timer;
+  linkaddr_t sender;
+  linkaddr_t nexthop;
+  uint16_t tag;
+  uint16_t size; /* 0 if the entry is free */
+  uint16_t out_tag;
+  uint8_t proto; /* of the datagram, the MAC classifies its fragments by it */
+};
+static struct sicslowpan_frag_forward frag_forwards[SICSLOWPAN_FRAG_FORWARD_NB];
+#endif /* SICSLOWPAN_FRAG_FORWARD */
 
 /** Datagram tag to be put in the fragments I send. */
 static uint16_t my_tag;
 
-/** When reassembling, the tag in the fragments being merged. */
-static uint16_t reass_tag;
-
-/** When reassembling, the source address of the fragments being merged */
-linkaddr_t frag_sender;
-
-/** Reassembly %process %timer. */
-static struct timer reass_timer;
-
 /** @} */
 #else /* SICSLOWPAN_CONF_FRAG */
 /** The buffer used for the 6lowpan processing is uip_buf.
@@ -1363,6 +1408,203 @@ send_packet(linkaddr_t *dest)
   watchdog_periodic();
 }
 /*--------------------------------------------------------------------*/
+/**
+ * \brief Compress the headers of the IP packet in uip_buf into packetbuf
+ * \param dest the link layer destination address of the packet
+ */
+static void
+compress_hdr(linkaddr_t *dest)
+{
+  if(uip_len >= COMPRESSION_THRESHOLD) {
+    /* Try to compress the headers */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1
+    compress_hdr_hc1(dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1 */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
+    compress_hdr_ipv6(dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6 */
+#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
+    compress_hdr_hc06(dest);
+#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
+  } else {
+    compress_hdr_ipv6(dest);
+  }
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief The room for the 6lowpan headers and payload in a frame
+ * \param dest the link layer destination address of the frame
+ */
+static int
+mac_max_payload(linkaddr_t *dest)
+{
+  int framer_hdrlen;
+
+  /* Calculate NETSTACK_FRAMER's header length, that will be added in the NETSTACK_RDC.
+   * We calculate it here only to make a better decision of whether the outgoing packet
+   * needs to be fragmented or not. */
+#define USE_FRAMER_HDRLEN 1
+#if USE_FRAMER_HDRLEN
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, dest);
+  framer_hdrlen = NETSTACK_FRAMER.length();
+  if(framer_hdrlen < 0) {
+    /* Framing failed, we assume the maximum header length */
+    framer_hdrlen = 21;
+  }
+#else /* USE_FRAMER_HDRLEN */
+  framer_hdrlen = 21;
+#endif /* USE_FRAMER_HDRLEN */
+  return MAC_MAX_PAYLOAD - framer_hdrlen - NETSTACK_LLSEC.get_overhead();
+}
+#if SICSLOWPAN_CONF_FRAG
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Send bytes start to end of the IP packet in uip_buf as
+ * fragments of a datagram of size uip_len
+ * \param dest the link layer destination address of the fragments
+ * \param tag the datagram tag
+ * \param start 0 to start with the FRAG1 fragment, whose compressed
+ * headers are in packetbuf already and stand for the first
+ * uncomp_hdr_len bytes. Else a multiple of 8.
+ * \param end the end of the last fragment, uip_len or a multiple of 8
+ * \param max_payload room for the 6lowpan headers and payload in a frame
+ * \return 1 if all fragments were passed to the MAC, 0 otherwise
+ */
+static int
+send_fragments(linkaddr_t *dest, uint16_t tag, uint16_t start,
+               uint16_t end, int max_payload)
+{
+  struct queuebuf *q;
+
+  /* Number of bytes processed. */
+  uint16_t processed_ip_out_len = start;
+
+  /*
+   * The first fragment contains frag1 dispatch, then
+   * IPv6/HC1/HC06/HC_UDP dispatchs/headers.
+   * The following fragments contain only the fragn dispatch.
+   */
+  if(start == 0) {
+    /* Create 1st Fragment */
+    PRINTFO("sicslowpan output: 1rst fragment ");
+
+    /* move HC1/HC06/IPv6 header */
+    memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
+
+    /*
+     * FRAG1 dispatch + header
+     * Note that the length is in units of 8 bytes
+     */
+/*     PACKETBUF_FRAG_BUF->dispatch_size = */
+/*       uip_htons((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len); */
+    SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+          ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len));
+/*     PACKETBUF_FRAG_BUF->tag = uip_htons(my_tag); */
+    SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, tag);
+
+    /* Copy payload and send */
+    packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
+    packetbuf_payload_len = (max_payload - packetbuf_hdr_len) & 0xfffffff8;
+    if(end - uncomp_hdr_len < packetbuf_payload_len) {
+      packetbuf_payload_len = end - uncomp_hdr_len;
+    }
+    PRINTFO("(len %d, tag %d)\n", packetbuf_payload_len, tag);
+    memcpy(packetbuf_ptr + packetbuf_hdr_len,
+           (uint8_t *)UIP_IP_BUF + uncomp_hdr_len, packetbuf_payload_len);
+    packetbuf_set_datalen(packetbuf_payload_len + packetbuf_hdr_len);
+    q = queuebuf_new_from_packetbuf();
+    if(q == NULL) {
+      PRINTFO("could not allocate queuebuf for first fragment, dropping packet\n");
+      return 0;
+    }
+    send_packet(dest);
+    queuebuf_to_packetbuf(q);
+    queuebuf_free(q);
+    q = NULL;
+
+    /* Check tx result. */
+    if((last_tx_status == MAC_TX_COLLISION) ||
+       (last_tx_status == MAC_TX_ERR) ||
+       (last_tx_status == MAC_TX_ERR_FATAL)) {
+      PRINTFO("error in fragment tx, dropping subsequent fragments.\n");
+      return 0;
+    }
+
+    /* set processed_ip_out_len to what we already sent from the IP payload*/
+    processed_ip_out_len = packetbuf_payload_len + uncomp_hdr_len;
+  }
+
+  /*
+   * Create following fragments
+   * We need to set the FRAGN dispatch, the datagram tag and for each
+   * fragment, the offset
+   */
+  packetbuf_hdr_len = SICSLOWPAN_FRAGN_HDR_LEN;
+/*     PACKETBUF_FRAG_BUF->dispatch_size = */
+/*       uip_htons((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len); */
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
+        ((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len));
+  SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, tag);
+  packetbuf_payload_len = (max_payload - packetbuf_hdr_len) & 0xfffffff8;
+  while(processed_ip_out_len < end) {
+    PRINTFO("sicslowpan output: fragment ");
+    PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] = processed_ip_out_len >> 3;
+
+    /* Copy payload and send */
+    if(end - processed_ip_out_len < packetbuf_payload_len) {
+      /* last fragment */
+      packetbuf_payload_len = end - processed_ip_out_len;
+    }
+    PRINTFO("(offset %d, len %d, tag %d)\n",
+           processed_ip_out_len >> 3, packetbuf_payload_len, tag);
+    memcpy(packetbuf_ptr + packetbuf_hdr_len,
+           (uint8_t *)UIP_IP_BUF + processed_ip_out_len, packetbuf_payload_len);
+    packetbuf_set_datalen(packetbuf_payload_len + packetbuf_hdr_len);
+    q = queuebuf_new_from_packetbuf();
+    if(q == NULL) {
+      PRINTFO("could not allocate queuebuf, dropping fragment\n");
+      return 0;
+    }
+    send_packet(dest);
+    queuebuf_to_packetbuf(q);
+    queuebuf_free(q);
+    q = NULL;
+    processed_ip_out_len += packetbuf_payload_len;
+
+    /* Check tx result. */
+    if((last_tx_status == MAC_TX_COLLISION) ||
+       (last_tx_status == MAC_TX_ERR) ||
+       (last_tx_status == MAC_TX_ERR_FATAL)) {
+      PRINTFO("error in fragment tx, dropping subsequent fragments.\n");
+      return 0;
+    }
+  }
+  return 1;
+}
+#endif /* SICSLOWPAN_CONF_FRAG */
+/*--------------------------------------------------------------------*/
+#ifndef WITHOUT_6LOWPAN_ATTR
+/**
+ * \brief Flow of the datagram in uip_buf, for PACKETBUF_ATTR_APP_FLOW
+ * \return flow id + 1 if the datagram ends with the deployment app data,
+ * 0 otherwise
+ */
+static uint16_t
+datagram_flow(void)
+{
+#ifdef LOG_MAGIC
+  struct app_data data;
+  if(uip_len >= UIP_IPH_LEN + sizeof(data)) {
+    memcpy(&data, &uip_buf[UIP_LLH_LEN + uip_len - sizeof(data)], sizeof(data));
+    if(data.magic == UIP_HTONL(LOG_MAGIC)) {
+      return (UIP_HTONL(data.seqno) >> 16) + 1;
+    }
+  }
+#endif /* LOG_MAGIC */
+  return 0;
+}
+#endif /* WITHOUT_6LOWPAN_ATTR */
+/*--------------------------------------------------------------------*/
 /** \brief Take an IP packet and format it to be sent on an 802.15.4
  *  network using 6lowpan.
  *  \param localdest The MAC address of the destination
@@ -1375,15 +1617,11 @@ send_packet(linkaddr_t *dest)
 static uint8_t
 output(const uip_lladdr_t *localdest)
 {
-  int framer_hdrlen;
   int max_payload;
 
   /* The MAC address of the destination of the packet */
   linkaddr_t dest;
 
-  /* Number of bytes processed. */
-  uint16_t processed_ip_out_len;
-
   /* init */
   uncomp_hdr_len = 0;
   packetbuf_hdr_len = 0;
@@ -1397,6 +1635,13 @@ output(const uip_lladdr_t *localdest)
                      SICSLOWPAN_MAX_MAC_TRANSMISSIONS);
 #endif /* WITHOUT_MAC_TX_ATTR */
 
+#ifndef WITHOUT_6LOWPAN_ATTR
+  /* the MAC classifies frames by protocol and flow (TSCH traffic classes).
+     Set once per datagram, so that all its fragments share one class. */
+  packetbuf_set_attr(PACKETBUF_ATTR_NETWORK_ID, UIP_IP_BUF->proto);
+  packetbuf_set_attr(PACKETBUF_ATTR_APP_FLOW, datagram_flow());
+#endif /* WITHOUT_6LOWPAN_ATTR */
+
   if(callback) {
     /* call the attribution when the callback comes, but set attributes
        here ! */
@@ -1434,47 +1679,16 @@ output(const uip_lladdr_t *localdest)
   
   PRINTFO("sicslowpan output: sending packet len %d\n", uip_len);
 
-  if(uip_len >= COMPRESSION_THRESHOLD) {
-    /* Try to compress the headers */
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1
-    compress_hdr_hc1(&dest);
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC1 */
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6
-    compress_hdr_ipv6(&dest);
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_IPV6 */
-#if SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06
-    compress_hdr_hc06(&dest);
-#endif /* SICSLOWPAN_COMPRESSION == SICSLOWPAN_COMPRESSION_HC06 */
-  } else {
-    compress_hdr_ipv6(&dest);
-  }
+  compress_hdr(&dest);
   PRINTFO("sicslowpan output: header of len %d\n", packetbuf_hdr_len);
 
-  /* Calculate NETSTACK_FRAMER's header length, that will be added in the NETSTACK_RDC.
-   * We calculate it here only to make a better decision of whether the outgoing packet
-   * needs to be fragmented or not. */
-#define USE_FRAMER_HDRLEN 1
-#if USE_FRAMER_HDRLEN
-  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &dest);
-  framer_hdrlen = NETSTACK_FRAMER.length();
-  if(framer_hdrlen < 0) {
-    /* Framing failed, we assume the maximum header length */
-    framer_hdrlen = 21;
-  }
-#else /* USE_FRAMER_HDRLEN */
-  framer_hdrlen = 21;
-#endif /* USE_FRAMER_HDRLEN */
-  max_payload = MAC_MAX_PAYLOAD - framer_hdrlen - NETSTACK_LLSEC.get_overhead();
+  max_payload = mac_max_payload(&dest);
 
   if((int)uip_len - (int)uncomp_hdr_len > max_payload - (int)packetbuf_hdr_len) {
 #if SICSLOWPAN_CONF_FRAG
-    struct queuebuf *q;
     /*
      * The outbound IPv6 packet is too large to fit into a single 15.4
      * packet, so we fragment it into multiple packets and send them.
-     * The first fragment contains frag1 dispatch, then
-     * IPv6/HC1/HC06/HC_UDP dispatchs/headers.
-     * The following fragments contain only the fragn dispatch.
      */
     int estimated_fragments = ((int)uip_len) / ((int)MAC_MAX_PAYLOAD - SICSLOWPAN_FRAGN_HDR_LEN) + 1;
     int freebuf = queuebuf_numfree() - 1;
@@ -1485,97 +1699,9 @@ output(const uip_lladdr_t *localdest)
     }
 
     PRINTFO("Fragmentation sending packet len %d\n", uip_len);
-
-    /* Create 1st Fragment */
-    PRINTFO("sicslowpan output: 1rst fragment ");
-
-    /* move HC1/HC06/IPv6 header */
-    memmove(packetbuf_ptr + SICSLOWPAN_FRAG1_HDR_LEN, packetbuf_ptr, packetbuf_hdr_len);
-
-    /*
-     * FRAG1 dispatch + header
-     * Note that the length is in units of 8 bytes
-     */
-/*     PACKETBUF_FRAG_BUF->dispatch_size = */
-/*       uip_htons((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len); */
-    SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
-          ((SICSLOWPAN_DISPATCH_FRAG1 << 8) | uip_len));
-/*     PACKETBUF_FRAG_BUF->tag = uip_htons(my_tag); */
-    SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_TAG, my_tag);
-    my_tag++;
-
-    /* Copy payload and send */
-    packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
-    packetbuf_payload_len = (max_payload - packetbuf_hdr_len) & 0xfffffff8;
-    PRINTFO("(len %d, tag %d)\n", packetbuf_payload_len, my_tag);
-    memcpy(packetbuf_ptr + packetbuf_hdr_len,
-           (uint8_t *)UIP_IP_BUF + uncomp_hdr_len, packetbuf_payload_len);
-    packetbuf_set_datalen(packetbuf_payload_len + packetbuf_hdr_len);
-    q = queuebuf_new_from_packetbuf();
-    if(q == NULL) {
-      PRINTFO("could not allocate queuebuf for first fragment, dropping packet\n");
+    if(!send_fragments(&dest, my_tag++, 0, uip_len, max_payload)) {
       return 0;
     }
-    send_packet(&dest);
-    queuebuf_to_packetbuf(q);
-    queuebuf_free(q);
-    q = NULL;
-
-    /* Check tx result. */
-    if((last_tx_status == MAC_TX_COLLISION) ||
-       (last_tx_status == MAC_TX_ERR) ||
-       (last_tx_status == MAC_TX_ERR_FATAL)) {
-      PRINTFO("error in fragment tx, dropping subsequent fragments.\n");
-      return 0;
-    }
-
-    /* set processed_ip_out_len to what we already sent from the IP payload*/
-    processed_ip_out_len = packetbuf_payload_len + uncomp_hdr_len;
-    
-    /*
-     * Create following fragments
-     * Datagram tag is already in the buffer, we need to set the
-     * FRAGN dispatch and for each fragment, the offset
-     */
-    packetbuf_hdr_len = SICSLOWPAN_FRAGN_HDR_LEN;
-/*     PACKETBUF_FRAG_BUF->dispatch_size = */
-/*       uip_htons((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len); */
-    SET16(PACKETBUF_FRAG_PTR, PACKETBUF_FRAG_DISPATCH_SIZE,
-          ((SICSLOWPAN_DISPATCH_FRAGN << 8) | uip_len));
-    packetbuf_payload_len = (max_payload - packetbuf_hdr_len) & 0xfffffff8;
-    while(processed_ip_out_len < uip_len) {
-      PRINTFO("sicslowpan output: fragment ");
-      PACKETBUF_FRAG_PTR[PACKETBUF_FRAG_OFFSET] = processed_ip_out_len >> 3;
-      
-      /* Copy payload and send */
-      if(uip_len - processed_ip_out_len < packetbuf_payload_len) {
-        /* last fragment */
-        packetbuf_payload_len = uip_len - processed_ip_out_len;
-      }
-      PRINTFO("(offset %d, len %d, tag %d)\n",
-             processed_ip_out_len >> 3, packetbuf_payload_len, my_tag);
-      memcpy(packetbuf_ptr + packetbuf_hdr_len,
-             (uint8_t *)UIP_IP_BUF + processed_ip_out_len, packetbuf_payload_len);
-      packetbuf_set_datalen(packetbuf_payload_len + packetbuf_hdr_len);
-      q = queuebuf_new_from_packetbuf();
-      if(q == NULL) {
-        PRINTFO("could not allocate queuebuf, dropping fragment\n");
-        return 0;
-      }
-      send_packet(&dest);
-      queuebuf_to_packetbuf(q);
-      queuebuf_free(q);
-      q = NULL;
-      processed_ip_out_len += packetbuf_payload_len;
-
-      /* Check tx result. */
-      if((last_tx_status == MAC_TX_COLLISION) ||
-         (last_tx_status == MAC_TX_ERR) ||
-         (last_tx_status == MAC_TX_ERR_FATAL)) {
-        PRINTFO("error in fragment tx, dropping subsequent fragments.\n");
-        return 0;
-      }
-    }
 #else /* SICSLOWPAN_CONF_FRAG */
     PRINTFO("sicslowpan output: Packet too large to be sent without fragmentation support; dropping packet\n");
     return 0;
@@ -1594,6 +1720,223 @@ output(const uip_lladdr_t *localdest)
   return 1;
 }
 
+#if SICSLOWPAN_CONF_FRAG
+/*--------------------------------------------------------------------*/
+/**
+ * \brief The context reassembling the datagram of size from sender
+ * with tag, NULL if none. Contexts that timed out are freed.
+ */
+static struct sicslowpan_reass *
+reass_lookup(const linkaddr_t *sender, uint16_t tag, uint16_t size)
+{
+  struct sicslowpan_reass *r;
+  for(r = reass_contexts; r < reass_contexts + SICSLOWPAN_REASS_CONTEXTS; r++) {
+    if(r->size != 0 && timer_expired(&r->timer)) {
+      PRINTFI("sicslowpan input: reassembly of tag %d timed out\n", r->tag);
+      r->size = 0;
+    }
+    if(r->size != 0 && r->size == size && r->tag == tag &&
+       linkaddr_cmp(&r->sender, sender)) {
+      return r;
+    }
+  }
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief A context for a new datagram: a free one, else the oldest.
+ *
+ * We can either ignore a new datagram and hope to receive the rest of
+ * the ones under reassembly, or we can discard the oldest one and start
+ * reassembling the new one. We discard the oldest, this lessens the
+ * negative impacts of too high SICSLOWPAN_REASS_MAXAGE.
+ */
+static struct sicslowpan_reass *
+reass_alloc(void)
+{
+  struct sicslowpan_reass *r, *oldest = reass_contexts;
+  clock_time_t now = clock_time();
+  for(r = reass_contexts; r < reass_contexts + SICSLOWPAN_REASS_CONTEXTS; r++) {
+    if(r->size == 0) {
+      return r;
+    }
+    if(now - r->timer.start > now - oldest->timer.start) {
+      oldest = r;
+    }
+  }
+  PRINTFI("sicslowpan input: Dropping datagram of tag %d being reassembled\n",
+          oldest->tag);
+  return oldest;
+}
+#if SICSLOWPAN_FRAG_FORWARD
+/*--------------------------------------------------------------------*/
+/**
+ * \brief The link-layer next hop to destipaddr, as in
+ * tcpip_ipv6_output(), NULL if there is no neighbor cache entry for it
+ */
+static const uip_lladdr_t *
+frag_forward_nexthop(uip_ipaddr_t *destipaddr)
+{
+  uip_ipaddr_t *nexthop;
+  uip_ds6_route_t *route;
+
+  if(uip_ds6_is_addr_onlink(destipaddr)) {
+    nexthop = destipaddr;
+  } else {
+    route = uip_ds6_route_lookup(destipaddr);
+    if(route == NULL) {
+      nexthop = uip_ds6_defrt_choose();
+    } else {
+      nexthop = uip_ds6_route_nexthop(route);
+    }
+  }
+  return nexthop == NULL ? NULL : uip_ds6_nbr_lladdr_from_ipaddr(nexthop);
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief The entry relaying the datagram of size from sender with tag,
+ * NULL if none. Entries that timed out are freed.
+ */
+static struct sicslowpan_frag_forward *
+frag_forward_lookup(const linkaddr_t *sender, uint16_t tag, uint16_t size)
+{
+  struct sicslowpan_frag_forward *f;
+  for(f = frag_forwards; f < frag_forwards + SICSLOWPAN_FRAG_FORWARD_NB; f++) {
+    if(f->size != 0 && timer_expired(&f->timer)) {
+      f->size = 0;
+    }
+    if(f->size != 0 && f->size == size && f->tag == tag &&
+       linkaddr_cmp(&f->sender, sender)) {
+      return f;
+    }
+  }
+  return NULL;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Send the bytes start to end of the datagram of entry f, in
+ * uip_buf, on to its next hop
+ *
+ * With start 0 the uncompressed headers of the datagram are in uip_buf
+ * and are compressed anew for the next hop. Addresses elided against the
+ * previous link may need to be carried inline now, so the FRAG1 we send
+ * may be followed by one more FRAGN than we received.
+ */
+static void
+frag_forward_send(struct sicslowpan_frag_forward *f, uint16_t start, uint16_t end)
+{
+  uip_len = f->size;
+  uncomp_hdr_len = 0;
+  packetbuf_hdr_len = 0;
+  packetbuf_clear();
+  packetbuf_ptr = packetbuf_dataptr();
+#ifndef WITHOUT_MAC_TX_ATTR
+  packetbuf_set_attr(PACKETBUF_ATTR_MAX_MAC_TRANSMISSIONS,
+                     SICSLOWPAN_MAX_MAC_TRANSMISSIONS);
+#endif /* WITHOUT_MAC_TX_ATTR */
+#ifndef WITHOUT_6LOWPAN_ATTR
+  /* The flow tag is at the tail of the datagram, which we never hold when
+     relaying: all fragments of a relayed datagram go untagged, so that
+     they still share one class. */
+  packetbuf_set_attr(PACKETBUF_ATTR_NETWORK_ID, f->proto);
+#endif /* WITHOUT_6LOWPAN_ATTR */
+  if(start == 0) {
+    compress_hdr(&f->nexthop);
+  }
+  send_fragments(&f->nexthop, f->out_tag, start, end, mac_max_payload(&f->nexthop));
+  uip_len = 0;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Relay a FRAG1 whose headers are uncompressed in uip_buf if the
+ * datagram is not for us and we know the next hop
+ * \return 1 if the fragment was relayed, 0 if it is to be reassembled
+ *
+ * Only datagrams without extension headers are relayed. The others are
+ * reassembled, as a routing header or the RPL hop-by-hop option has to be
+ * processed (rpl_verify_header(), rpl_update_header_empty()) on every hop.
+ */
+static int
+frag_forward_first(const linkaddr_t *sender, uint16_t tag, uint16_t size)
+{
+  struct sicslowpan_frag_forward *f;
+  const uip_lladdr_t *nexthop;
+  int payload_len = packetbuf_datalen() - packetbuf_hdr_len;
+  uint16_t end = uncomp_hdr_len + payload_len;
+
+  if(payload_len <= 0 || end >= size ||
+     UIP_IP_BUF->ttl <= 1 ||
+     (UIP_IP_BUF->proto != UIP_PROTO_UDP &&
+      UIP_IP_BUF->proto != UIP_PROTO_TCP &&
+      UIP_IP_BUF->proto != UIP_PROTO_ICMP6) ||
+     uip_is_addr_mcast(&UIP_IP_BUF->destipaddr) ||
+     uip_ds6_is_my_addr(&UIP_IP_BUF->destipaddr)) {
+    return 0;
+  }
+  nexthop = frag_forward_nexthop(&UIP_IP_BUF->destipaddr);
+  if(nexthop == NULL) {
+    return 0;
+  }
+  f = frag_forward_lookup(sender, tag, size);
+  if(f == NULL) {
+    /* Not a repeated FRAG1: take a free entry */
+    for(f = frag_forwards; f < frag_forwards + SICSLOWPAN_FRAG_FORWARD_NB &&
+          f->size != 0; f++);
+    if(f == frag_forwards + SICSLOWPAN_FRAG_FORWARD_NB) {
+      return 0;
+    }
+    linkaddr_copy(&f->sender, sender);
+    f->tag = tag;
+    f->size = size;
+    f->out_tag = my_tag++;
+    f->proto = UIP_IP_BUF->proto;
+    timer_set(&f->timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND);
+  }
+  linkaddr_copy(&f->nexthop, (const linkaddr_t *)nexthop);
+  PRINTFI("sicslowpan input: relaying FRAG1 (size %d, tag %d) as tag %d\n",
+          size, tag, f->out_tag);
+
+  memcpy((uint8_t *)UIP_IP_BUF + uncomp_hdr_len, packetbuf_ptr + packetbuf_hdr_len,
+         payload_len);
+  UIP_IP_BUF->ttl--;
+  frag_forward_send(f, 0, end);
+  return 1;
+}
+/*--------------------------------------------------------------------*/
+/**
+ * \brief Relay a FRAGN of a datagram whose FRAG1 we relayed
+ * \return 1 if the fragment was relayed or dropped, 0 if the datagram
+ * is not relayed
+ */
+static int
+frag_forward_next(const linkaddr_t *sender, uint16_t tag, uint16_t size,
+                  uint8_t offset)
+{
+  struct sicslowpan_frag_forward *f;
+  int payload_len = packetbuf_datalen() - packetbuf_hdr_len;
+  uint16_t start = (uint16_t)offset << 3;
+
+  f = frag_forward_lookup(sender, tag, size);
+  if(f == NULL) {
+    return 0;
+  }
+  if(payload_len <= 0 || start + payload_len > size) {
+    PRINTFI("sicslowpan input: Dropping relayed fragment out of its datagram\n");
+    return 1;
+  }
+  PRINTFI("sicslowpan input: relaying FRAGN (size %d, tag %d, offset %d) as tag %d\n",
+          size, tag, offset, f->out_tag);
+  memcpy((uint8_t *)UIP_IP_BUF + start, packetbuf_ptr + packetbuf_hdr_len,
+         payload_len);
+  frag_forward_send(f, start, start + payload_len);
+  if(start + payload_len >= size) {
+    /* last fragment */
+    f->size = 0;
+  }
+  return 1;
+}
+#endif /* SICSLOWPAN_FRAG_FORWARD */
+#endif /* SICSLOWPAN_CONF_FRAG */
 /*--------------------------------------------------------------------*/
 /** \brief Process a received 6lowpan packet.
  *  \param r The MAC layer
@@ -1614,11 +1957,14 @@ input(void)
   uint16_t frag_size = 0;
   /* offset of the fragment in the IP packet */
   uint8_t frag_offset = 0;
-  uint8_t is_fragment = 0;
 #if SICSLOWPAN_CONF_FRAG
   /* tag of the fragment */
   uint16_t frag_tag = 0;
-  uint8_t first_fragment = 0, last_fragment = 0;
+  uint8_t is_fragment = 0, first_fragment = 0, last_fragment = 0;
+  /* link-layer sender of the fragment */
+  linkaddr_t sender;
+  /* the reassembly context of the fragment, NULL if not a fragment */
+  struct sicslowpan_reass *reass = NULL;
 #endif /*SICSLOWPAN_CONF_FRAG*/
 
   /* init */
@@ -1640,11 +1986,9 @@ input(void)
      want to query us for it later. */
   last_rssi = (signed short)packetbuf_attr(PACKETBUF_ATTR_RSSI);
 #if SICSLOWPAN_CONF_FRAG
-  /* if reassembly timed out, cancel it */
-  if(timer_expired(&reass_timer)) {
-    sicslowpan_len = 0;
-    processed_ip_in_len = 0;
-  }
+  /* Headers and unfragmented packets are uncompressed in uip_buf */
+  sicslowpan_buf = uip_buf;
+  linkaddr_copy(&sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
   /*
    * Since we don't support the mesh and broadcast header, the first header
    * we look for is the fragmentation header
@@ -1660,7 +2004,6 @@ input(void)
       PRINTFI("size %d, tag %d, offset %d)\n",
              frag_size, frag_tag, frag_offset);
       packetbuf_hdr_len += SICSLOWPAN_FRAG1_HDR_LEN;
-      /*      printf("frag1 %d %d\n", reass_tag, frag_tag);*/
       first_fragment = 1;
       is_fragment = 1;
       break;
@@ -1676,80 +2019,40 @@ input(void)
       PRINTFI("size %d, tag %d, offset %d)\n",
              frag_size, frag_tag, frag_offset);
       packetbuf_hdr_len += SICSLOWPAN_FRAGN_HDR_LEN;
-
-      /* If this is the last fragment, we may shave off any extrenous
-         bytes at the end. We must be liberal in what we accept. */
-      PRINTFI("last_fragment?: processed_ip_in_len %d packetbuf_payload_len %d frag_size %d\n",
-              processed_ip_in_len, packetbuf_datalen() - packetbuf_hdr_len, frag_size);
-
-      if(processed_ip_in_len + packetbuf_datalen() - packetbuf_hdr_len >= frag_size) {
-        last_fragment = 1;
-      }
       is_fragment = 1;
       break;
     default:
       break;
   }
 
-  /* We are currently reassembling a packet, but have just received the first
-   * fragment of another packet. We can either ignore it and hope to receive
-   * the rest of the under-reassembly packet fragments, or we can discard the
-   * previous packet altogether, and start reassembling the new packet.
-   *
-   * We discard the previous packet, and start reassembling the new packet.
-   * This lessens the negative impacts of too high SICSLOWPAN_REASS_MAXAGE.
-   */
-#define PRIORITIZE_NEW_PACKETS 1
-#if PRIORITIZE_NEW_PACKETS
-
-  if(!is_fragment) {
-    /* Prioritize non-fragment packets too. */
-    sicslowpan_len = 0;
-    processed_ip_in_len = 0;
-  } else if(processed_ip_in_len > 0 && first_fragment
-      && !linkaddr_cmp(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))) {
-    sicslowpan_len = 0;
-    processed_ip_in_len = 0;
+  if(is_fragment && (frag_size == 0 || frag_size > UIP_BUFSIZE - UIP_LLH_LEN)) {
+    PRINTFI("sicslowpan input: Dropping fragment of a datagram of size %d\n", frag_size);
+    return;
   }
-#endif /* PRIORITIZE_NEW_PACKETS */
-
-  if(processed_ip_in_len > 0) {
-    /* reassembly is ongoing */
-    /*    printf("frag %d %d\n", reass_tag, frag_tag);*/
-    if((frag_size > 0 &&
-        (frag_size != sicslowpan_len ||
-         reass_tag  != frag_tag ||
-         !linkaddr_cmp(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER))))  ||
-       frag_size == 0) {
-      /*
-       * the packet is a fragment that does not belong to the packet
-       * being reassembled or the packet is not a fragment.
-       */
-      PRINTFI("sicslowpan input: Dropping 6lowpan packet that is not a fragment of the packet currently being reassembled\n");
-      return;
-    }
-  } else {
-    /*
-     * reassembly is off
-     * start it if we received a fragment
-     */
-    if((frag_size > 0) && (frag_size <= UIP_BUFSIZE)) {
-      /* We are currently not reassembling a packet, but have received a packet fragment
-       * that is not the first one. */
-      if(is_fragment && !first_fragment) {
+
+  if(is_fragment && !first_fragment) {
+    /* A FRAGN belongs to a datagram whose FRAG1 we have seen */
+    reass = reass_lookup(&sender, frag_tag, frag_size);
+    if(reass == NULL) {
+#if SICSLOWPAN_FRAG_FORWARD
+      if(frag_forward_next(&sender, frag_tag, frag_size, frag_offset)) {
         return;
       }
+#endif /* SICSLOWPAN_FRAG_FORWARD */
+      PRINTFI("sicslowpan input: Dropping 6lowpan fragment of no datagram being reassembled\n");
+      return;
+    }
+    sicslowpan_buf = reass->buf.u8;
+
+    /* If this is the last fragment, we may shave off any extrenous
+       bytes at the end. We must be liberal in what we accept. */
+    PRINTFI("last_fragment?: processed_ip_in_len %d packetbuf_payload_len %d frag_size %d\n",
+            reass->processed, packetbuf_datalen() - packetbuf_hdr_len, frag_size);
 
-      sicslowpan_len = frag_size;
-      reass_tag = frag_tag;
-      timer_set(&reass_timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND);
-      PRINTFI("sicslowpan input: INIT FRAGMENTATION (len %d, tag %d)\n",
-             sicslowpan_len, reass_tag);
-      linkaddr_copy(&frag_sender, packetbuf_addr(PACKETBUF_ADDR_SENDER));
+    if(reass->processed + packetbuf_datalen() - packetbuf_hdr_len >= frag_size) {
+      last_fragment = 1;
     }
-  }
 
-  if(packetbuf_hdr_len == SICSLOWPAN_FRAGN_HDR_LEN) {
     /* this is a FRAGN, skip the header compression dispatch section */
     goto copypayload;
   }
@@ -1786,9 +2089,31 @@ input(void)
              PACKETBUF_HC1_PTR[PACKETBUF_HC1_DISPATCH]);
       return;
   }
-   
-    
+
 #if SICSLOWPAN_CONF_FRAG
+  if(first_fragment) {
+#if SICSLOWPAN_FRAG_FORWARD
+    if(frag_forward_first(&sender, frag_tag, frag_size)) {
+      return;
+    }
+#endif /* SICSLOWPAN_FRAG_FORWARD */
+    /* Start reassembly, or restart it on a repeated FRAG1, and move the
+       uncompressed headers to the reassembly buffer */
+    reass = reass_lookup(&sender, frag_tag, frag_size);
+    if(reass == NULL) {
+      reass = reass_alloc();
+    }
+    linkaddr_copy(&reass->sender, &sender);
+    reass->tag = frag_tag;
+    reass->size = frag_size;
+    reass->processed = 0;
+    timer_set(&reass->timer, SICSLOWPAN_REASS_MAXAGE * CLOCK_SECOND);
+    PRINTFI("sicslowpan input: INIT FRAGMENTATION (len %d, tag %d)\n",
+           reass->size, reass->tag);
+    memcpy(reass->buf.u8 + UIP_LLH_LEN, (uint8_t *)UIP_IP_BUF, uncomp_hdr_len);
+    sicslowpan_buf = reass->buf.u8;
+  }
+
  copypayload:
 #endif /*SICSLOWPAN_CONF_FRAG*/
   /*
@@ -1808,79 +2133,77 @@ input(void)
   {
     int req_size = UIP_LLH_LEN + uncomp_hdr_len + (uint16_t)(frag_offset << 3)
         + packetbuf_payload_len;
-    if(req_size > sizeof(sicslowpan_buf)) {
+    if(req_size > UIP_BUFSIZE) {
       PRINTF(
           "SICSLOWPAN: packet dropped, minimum required SICSLOWPAN_IP_BUF size: %d+%d+%d+%d=%d (current size: %d)\n",
           UIP_LLH_LEN, uncomp_hdr_len, (uint16_t)(frag_offset << 3),
-          packetbuf_payload_len, req_size, sizeof(sicslowpan_buf));
+          packetbuf_payload_len, req_size, UIP_BUFSIZE);
       return;
     }
   }
 
   memcpy((uint8_t *)SICSLOWPAN_IP_BUF + uncomp_hdr_len + (uint16_t)(frag_offset << 3), packetbuf_ptr + packetbuf_hdr_len, packetbuf_payload_len);
   
-  /* update processed_ip_in_len if fragment, sicslowpan_len otherwise */
+  /* update the reassembly context if fragment, sicslowpan_len otherwise */
 
 #if SICSLOWPAN_CONF_FRAG
-  if(frag_size > 0) {
+  if(reass != NULL) {
     /* Add the size of the header only for the first fragment. */
     if(first_fragment != 0) {
-      processed_ip_in_len += uncomp_hdr_len;
+      reass->processed += uncomp_hdr_len;
     }
     /* For the last fragment, we are OK if there is extrenous bytes at
        the end of the packet. */
     if(last_fragment != 0) {
-      processed_ip_in_len = frag_size;
+      reass->processed = frag_size;
     } else {
-      processed_ip_in_len += packetbuf_payload_len;
+      reass->processed += packetbuf_payload_len;
     }
-    PRINTF("processed_ip_in_len %d, packetbuf_payload_len %d\n", processed_ip_in_len, packetbuf_payload_len);
+    PRINTF("processed_ip_in_len %d, packetbuf_payload_len %d\n", reass->processed, packetbuf_payload_len);
 
-  } else {
+    if(reass->processed < reass->size) {
+      return;
+    }
+
+    /*
+     * We have a full IP packet in the reassembly buffer, deliver it to
+     * the IP stack
+     */
+    sicslowpan_len = reass->size;
+    reass->size = 0;
+    memcpy((uint8_t *)UIP_IP_BUF, (uint8_t *)SICSLOWPAN_IP_BUF, sicslowpan_len);
+  } else
 #endif /* SICSLOWPAN_CONF_FRAG */
+  {
     sicslowpan_len = packetbuf_payload_len + uncomp_hdr_len;
-#if SICSLOWPAN_CONF_FRAG
   }
-
-  /*
-   * If we have a full IP packet in sicslowpan_buf, deliver it to
-   * the IP stack
-   */
-  PRINTF("sicslowpan_init processed_ip_in_len %d, sicslowpan_len %d\n",
-         processed_ip_in_len, sicslowpan_len);
-  if(processed_ip_in_len == 0 || (processed_ip_in_len == sicslowpan_len)) {
-    PRINTFI("sicslowpan input: IP packet ready (length %d)\n",
-           sicslowpan_len);
-    memcpy((uint8_t *)UIP_IP_BUF, (uint8_t *)SICSLOWPAN_IP_BUF, sicslowpan_len);
-    uip_len = sicslowpan_len;
-    sicslowpan_len = 0;
-    processed_ip_in_len = 0;
+#if SICSLOWPAN_CONF_FRAG
+  PRINTFI("sicslowpan input: IP packet ready (length %d)\n",
+         sicslowpan_len);
+  uip_len = sicslowpan_len;
 #endif /* SICSLOWPAN_CONF_FRAG */
 
 #if DEBUG
-    {
-      uint16_t ndx;
-      PRINTF("after decompression %u:", SICSLOWPAN_IP_BUF->len[1]);
-      for (ndx = 0; ndx < SICSLOWPAN_IP_BUF->len[1] + 40; ndx++) {
-        uint8_t data = ((uint8_t *) (SICSLOWPAN_IP_BUF))[ndx];
-        PRINTF("%02x", data);
-      }
-      PRINTF("\n");
+  {
+    uint16_t ndx;
+    PRINTF("after decompression %u:", SICSLOWPAN_IP_BUF->len[1]);
+    for (ndx = 0; ndx < SICSLOWPAN_IP_BUF->len[1] + 40; ndx++) {
+      uint8_t data = ((uint8_t *) (SICSLOWPAN_IP_BUF))[ndx];
+      PRINTF("%02x", data);
     }
+    PRINTF("\n");
+  }
 #endif
 
-    /* if callback is set then set attributes and call */
-    if(callback) {
-      set_packet_attrs();
-      packetbuf_set_attr(PACKETBUF_ATTR_PROTO,
-            UIP_IP_BUF->proto);
-      callback->input_callback();
-    }
-
-    tcpip_input();
-#if SICSLOWPAN_CONF_FRAG
+  /* if callback is set then set attributes and call */
+  if(callback) {
+    set_packet_attrs();
+    packetbuf_set_attr(PACKETBUF_ATTR_PROTO,
+          UIP_IP_BUF->proto);
+    callback->input_callback();
   }
-#endif /* SICSLOWPAN_CONF_FRAG */
+
+  tcpip_input();
 }
 /** @} */
 
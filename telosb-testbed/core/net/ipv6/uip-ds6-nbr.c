@@ -153,10 +153,42 @@ uip_ds6_nbr_num(void)
   return num;
 }
 /*---------------------------------------------------------------------------*/
+/* Link-layer address the interface identifier of ipaddr was built from
+ * by uip_ds6_set_addr_iid(), 0 if it has no such form */
+static int
+lladdr_from_iid(const uip_ipaddr_t *ipaddr, uip_lladdr_t *lladdr)
+{
+#if (UIP_LLADDR_LEN == 8)
+  memcpy(lladdr, ipaddr->u8 + 8, UIP_LLADDR_LEN);
+  ((uint8_t *)lladdr)[0] ^= 0x02;
+  return 1;
+#elif (UIP_LLADDR_LEN == 6)
+  if(ipaddr->u8[11] != 0xff || ipaddr->u8[12] != 0xfe) {
+    return 0;
+  }
+  memcpy(lladdr, ipaddr->u8 + 8, 3);
+  memcpy((uint8_t *)lladdr + 3, ipaddr->u8 + 13, 3);
+  ((uint8_t *)lladdr)[0] ^= 0x02;
+  return 1;
+#else
+  return 0;
+#endif
+}
+/*---------------------------------------------------------------------------*/
 uip_ds6_nbr_t *
 uip_ds6_nbr_lookup(const uip_ipaddr_t *ipaddr)
 {
-  uip_ds6_nbr_t *nbr = nbr_table_head(ds6_neighbors);
+  uip_ds6_nbr_t *nbr;
+  uip_lladdr_t lladdr;
+  /* Neighbors normally use addresses derived from their link-layer
+   * address: try the indexed lookup first */
+  if(ipaddr != NULL && lladdr_from_iid(ipaddr, &lladdr)) {
+    nbr = uip_ds6_nbr_ll_lookup(&lladdr);
+    if(nbr != NULL && uip_ipaddr_cmp(&nbr->ipaddr, ipaddr)) {
+      return nbr;
+    }
+  }
+  nbr = nbr_table_head(ds6_neighbors);
   if(ipaddr != NULL) {
     while(nbr != NULL) {
       if(uip_ipaddr_cmp(&nbr->ipaddr, ipaddr)) {
@@ -54,6 +54,33 @@ MEMB(neighborroutememb, struct uip_ds6_route_neighbor_route, UIP_DS6_ROUTE_NB);
 LIST(routelist);
 MEMB(routememb, uip_ds6_route_t, UIP_DS6_ROUTE_NB);
 
+#if UIP_DS6_ROUTE_INDEX
+/* Open-addressing index of the /128 routes in routememb, as in
+   net/linkaddr-index.c: linear probing at a load factor of at most 1/2,
+   a slot holds 0 when empty, otherwise the route position + 1. Routes
+   with a shorter prefix are counted, so that a lookup that misses the
+   index only walks the route list when there are any.
+   Moving a route to the front of the list would walk it again, so with
+   the index the routes carry a use stamp instead, and the least recently
+   used route is searched for when one has to be dropped. */
+#define ROUTE_INDEX_SLOTS \
+  (UIP_DS6_ROUTE_NB <= 8 ? 16 : UIP_DS6_ROUTE_NB <= 16 ? 32 : \
+   UIP_DS6_ROUTE_NB <= 32 ? 64 : UIP_DS6_ROUTE_NB <= 64 ? 128 : \
+   UIP_DS6_ROUTE_NB <= 128 ? 256 : UIP_DS6_ROUTE_NB <= 256 ? 512 : \
+   UIP_DS6_ROUTE_NB <= 512 ? 1024 : UIP_DS6_ROUTE_NB <= 1024 ? 2048 : 4096)
+#if UIP_DS6_ROUTE_NB < 128
+typedef uint8_t route_slot_t;
+#else
+typedef uint16_t route_slot_t;
+#endif
+static route_slot_t route_index[ROUTE_INDEX_SLOTS];
+static int num_prefix_routes;
+static uint32_t route_used[UIP_DS6_ROUTE_NB];
+static uint32_t route_clock;
+#define ROUTE_POS(r) ((r) - (uip_ds6_route_t *)routememb.mem)
+#define ROUTE_AT(s) ((uip_ds6_route_t *)routememb.mem + (s) - 1)
+#endif /* UIP_DS6_ROUTE_INDEX */
+
 #endif /* UIP_DS6_ROUTE_NB > 0 */
 
 /* Default routes are held on the defaultrouterlist and their
@@ -105,6 +132,94 @@ assert_nbr_routes_list_sane(void)
 }
 #endif /* DEBUG != DEBUG_NONE */
 /*---------------------------------------------------------------------------*/
+#if UIP_DS6_ROUTE_NB > 0 && UIP_DS6_ROUTE_INDEX
+/* Rotate and xor the interface identifier, routes of a RPL root mostly
+   share their prefix */
+static uint16_t
+route_index_hash(const uip_ipaddr_t *addr)
+{
+  uint16_t h = 0;
+  uint8_t i;
+  for(i = 8; i < sizeof(uip_ipaddr_t); i++) {
+    h = (uint16_t)((h << 5) | (h >> 11)) ^ addr->u8[i];
+  }
+  return h & (ROUTE_INDEX_SLOTS - 1);
+}
+/*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+route_index_get(const uip_ipaddr_t *addr)
+{
+  uint16_t i = route_index_hash(addr);
+  route_slot_t s;
+  while((s = route_index[i]) != 0) {
+    if(uip_ipaddr_cmp(&ROUTE_AT(s)->ipaddr, addr)) {
+      return ROUTE_AT(s);
+    }
+    i = (i + 1) & (ROUTE_INDEX_SLOTS - 1);
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+route_index_add(uip_ds6_route_t *r)
+{
+  uint16_t i;
+  route_used[ROUTE_POS(r)] = ++route_clock;
+  if(r->length != 128) {
+    num_prefix_routes++;
+    return;
+  }
+  i = route_index_hash(&r->ipaddr);
+  while(route_index[i] != 0) {
+    i = (i + 1) & (ROUTE_INDEX_SLOTS - 1);
+  }
+  route_index[i] = ROUTE_POS(r) + 1;
+}
+/*---------------------------------------------------------------------------*/
+static void
+route_index_remove(uip_ds6_route_t *r)
+{
+  uint16_t i, j, k;
+  if(r->length != 128) {
+    num_prefix_routes--;
+    return;
+  }
+  i = route_index_hash(&r->ipaddr);
+  while(route_index[i] != ROUTE_POS(r) + 1) {
+    if(route_index[i] == 0) {
+      return; /* not indexed */
+    }
+    i = (i + 1) & (ROUTE_INDEX_SLOTS - 1);
+  }
+  route_index[i] = 0;
+  /* Move back the following routes of the run that would not be found
+     past the new gap: those whose home slot is not in (i, j] */
+  for(j = (i + 1) & (ROUTE_INDEX_SLOTS - 1); route_index[j] != 0;
+      j = (j + 1) & (ROUTE_INDEX_SLOTS - 1)) {
+    k = route_index_hash(&ROUTE_AT(route_index[j])->ipaddr);
+    if(i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+      continue;
+    }
+    route_index[i] = route_index[j];
+    route_index[j] = 0;
+    i = j;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uip_ds6_route_t *
+route_index_lru(void)
+{
+  uip_ds6_route_t *r, *oldest = NULL;
+  for(r = list_head(routelist); r != NULL; r = list_item_next(r)) {
+    if(oldest == NULL ||
+       route_clock - route_used[ROUTE_POS(r)] > route_clock - route_used[ROUTE_POS(oldest)]) {
+      oldest = r;
+    }
+  }
+  return oldest;
+}
+#endif /* UIP_DS6_ROUTE_NB > 0 && UIP_DS6_ROUTE_INDEX */
+/*---------------------------------------------------------------------------*/
 #if UIP_DS6_NOTIFICATIONS
 static void
 call_route_callback(int event, uip_ipaddr_t *route,
@@ -148,6 +263,11 @@ uip_ds6_route_init(void)
 #if UIP_DS6_ROUTE_NB > 0
   memb_init(&routememb);
   list_init(routelist);
+#if UIP_DS6_ROUTE_INDEX
+  memset(route_index, 0, sizeof(route_index));
+  num_prefix_routes = 0;
+  route_clock = 0;
+#endif /* UIP_DS6_ROUTE_INDEX */
   nbr_table_register(nbr_routes,
                      (nbr_table_callback *)rm_routelist_callback);
 #endif /* UIP_DS6_ROUTE_NB > 0 */
@@ -218,6 +338,27 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
 
   found_route = NULL;
   longestmatch = 0;
+#if UIP_DS6_ROUTE_INDEX
+  /* A host route is the longest match there is. Otherwise walk the
+     route list for the routes with a shorter prefix, if any */
+  found_route = route_index_get(addr);
+  if(found_route == NULL && num_prefix_routes > 0) {
+    int prefix_routes = num_prefix_routes;
+    for(r = uip_ds6_route_head();
+        r != NULL && prefix_routes > 0;
+        r = uip_ds6_route_next(r)) {
+      if(r->length == 128) {
+        continue;
+      }
+      prefix_routes--;
+      if(r->length >= longestmatch &&
+         uip_ipaddr_prefixcmp(addr, &r->ipaddr, r->length)) {
+        longestmatch = r->length;
+        found_route = r;
+      }
+    }
+  }
+#else /* UIP_DS6_ROUTE_INDEX */
   for(r = uip_ds6_route_head();
       r != NULL;
       r = uip_ds6_route_next(r)) {
@@ -231,6 +372,7 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
       }
     }
   }
+#endif /* UIP_DS6_ROUTE_INDEX */
 
   if(found_route != NULL) {
     PRINTF("uip-ds6-route: Found route: ");
@@ -242,6 +384,11 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
     PRINTF("uip-ds6-route: No route found\n");
   }
 
+#if UIP_DS6_ROUTE_INDEX
+  if(found_route != NULL) {
+    route_used[ROUTE_POS(found_route)] = ++route_clock;
+  }
+#else /* UIP_DS6_ROUTE_INDEX */
   if(found_route != NULL && found_route != list_head(routelist)) {
     /* If we found a route, we put it at the start of the routeslist
        list. The list is ordered by how recently we looked them up:
@@ -251,6 +398,7 @@ uip_ds6_route_lookup(uip_ipaddr_t *addr)
     list_remove(routelist, found_route);
     list_push(routelist, found_route);
   }
+#endif /* UIP_DS6_ROUTE_INDEX */
 
   return found_route;
 }
@@ -296,7 +444,11 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
          least recently used route is the first route on the list. */
       uip_ds6_route_t *oldest;
 
+#if UIP_DS6_ROUTE_INDEX
+      oldest = route_index_lru();
+#else /* UIP_DS6_ROUTE_INDEX */
       oldest = list_tail(routelist); /* uip_ds6_route_head(); */
+#endif /* UIP_DS6_ROUTE_INDEX */
       PRINTF("uip_ds6_route_add: dropping route to ");
       PRINT6ADDR(&oldest->ipaddr);
       PRINTF("\n");
@@ -366,6 +518,9 @@ uip_ds6_route_add(uip_ipaddr_t *ipaddr, uint8_t length,
 
   uip_ipaddr_copy(&(r->ipaddr), ipaddr);
   r->length = length;
+#if UIP_DS6_ROUTE_INDEX
+  route_index_add(r);
+#endif /* UIP_DS6_ROUTE_INDEX */
 
 #ifdef UIP_DS6_ROUTE_STATE_TYPE
   memset(&r->state, 0, sizeof(UIP_DS6_ROUTE_STATE_TYPE));
@@ -404,6 +559,9 @@ uip_ds6_route_rm(uip_ds6_route_t *route)
 
     /* Remove the route from the route list */
     list_remove(routelist, route);
+#if UIP_DS6_ROUTE_INDEX
+    route_index_remove(route);
+#endif /* UIP_DS6_ROUTE_INDEX */
 
     /* Find the corresponding neighbor_route and remove it. */
     for(neighbor_route = list_head(route->neighbor_routes->route_list);
@@ -81,6 +81,17 @@ void uip_ds6_notification_rm(struct uip_ds6_notification *n);
 #define UIP_DS6_ROUTE_NB UIP_CONF_MAX_ROUTES
 #endif /* UIP_CONF_MAX_ROUTES */
 
+/* Hash index of the /128 host routes: lookups of host routes hash instead
+   of walking the route list, only shorter prefixes are still matched by a
+   walk. Costs 2 * UIP_DS6_ROUTE_NB slots of one byte (two bytes above 127
+   routes) and a 4-byte use stamp per route, which replaces the move to
+   the front of the route list for LRU eviction. */
+#ifdef UIP_DS6_ROUTE_CONF_INDEX
+#define UIP_DS6_ROUTE_INDEX UIP_DS6_ROUTE_CONF_INDEX
+#else /* UIP_DS6_ROUTE_CONF_INDEX */
+#define UIP_DS6_ROUTE_INDEX 0
+#endif /* UIP_DS6_ROUTE_CONF_INDEX */
+
 /** \brief define some additional RPL related route state and
  *  neighbor callback for RPL - if not a DS6_ROUTE_STATE is already set */
 #ifndef UIP_DS6_ROUTE_STATE_TYPE
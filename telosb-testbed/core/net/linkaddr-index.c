@@ -0,0 +1,84 @@
+/**
+ * \file
+ *         Open-addressing index of link-layer addresses
+ */
+
+#include "net/linkaddr-index.h"
+#include <string.h>
+
+#define ENTRY_ADDR(idx, pos) \
+  ((const linkaddr_t *)((idx)->entries + (pos) * (idx)->entry_size + (idx)->addr_offset))
+
+/*---------------------------------------------------------------------------*/
+/* Rotate and xor all bytes: the last bytes, which differ most between
+ * nodes of a deployment, end up in the low bits */
+static uint8_t
+hash(const linkaddr_t *addr)
+{
+  uint8_t h = 0;
+  uint8_t i;
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    h = (uint8_t)((h << 3) | (h >> 5)) ^ addr->u8[i];
+  }
+  return h;
+}
+/*---------------------------------------------------------------------------*/
+void
+linkaddr_index_init(struct linkaddr_index *idx, const void *entries,
+                    uint16_t entry_size, uint8_t addr_offset)
+{
+  idx->entries = entries;
+  idx->entry_size = entry_size;
+  idx->addr_offset = addr_offset;
+  memset(idx->slots, 0, idx->mask + 1);
+}
+/*---------------------------------------------------------------------------*/
+int
+linkaddr_index_get(const struct linkaddr_index *idx, const linkaddr_t *addr)
+{
+  uint8_t i = hash(addr) & idx->mask;
+  uint8_t s;
+  while((s = idx->slots[i]) != 0) {
+    if(linkaddr_cmp(ENTRY_ADDR(idx, s - 1), addr)) {
+      return s - 1;
+    }
+    i = (i + 1) & idx->mask;
+  }
+  return -1;
+}
+/*---------------------------------------------------------------------------*/
+void
+linkaddr_index_add(struct linkaddr_index *idx, int pos)
+{
+  uint8_t i = hash(ENTRY_ADDR(idx, pos)) & idx->mask;
+  while(idx->slots[i] != 0) {
+    i = (i + 1) & idx->mask;
+  }
+  idx->slots[i] = pos + 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+linkaddr_index_remove(struct linkaddr_index *idx, int pos)
+{
+  uint8_t i = hash(ENTRY_ADDR(idx, pos)) & idx->mask;
+  uint8_t j, k;
+  while(idx->slots[i] != pos + 1) {
+    if(idx->slots[i] == 0) {
+      return; /* not indexed */
+    }
+    i = (i + 1) & idx->mask;
+  }
+  idx->slots[i] = 0;
+  /* Move back the following entries of the run that would not be found
+   * past the new gap: those whose home slot is not in (i, j] */
+  for(j = (i + 1) & idx->mask; idx->slots[j] != 0; j = (j + 1) & idx->mask) {
+    k = hash(ENTRY_ADDR(idx, idx->slots[j] - 1)) & idx->mask;
+    if(i <= j ? (i < k && k <= j) : (i < k || k <= j)) {
+      continue;
+    }
+    idx->slots[i] = idx->slots[j];
+    idx->slots[j] = 0;
+    i = j;
+  }
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,51 @@
+/**
+ * \file
+ *         Open-addressing index of link-layer addresses. Maps an address
+ *         to the position of its entry in a static array (a MEMB pool or
+ *         the key array of nbr-table), so that lookups hash instead of
+ *         walking a list with linkaddr_cmp. The index only keeps one byte
+ *         per slot, the addresses stay in the entries.
+ *
+ *         Linear probing at a load factor of at most 1/2, removal shifts
+ *         the following slots back, so there are no tombstones.
+ */
+
+#ifndef __LINKADDR_INDEX_H__
+#define __LINKADDR_INDEX_H__
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+#include <stddef.h>
+
+/* Number of slots for n entries: a power of two, at least 2n */
+#define LINKADDR_INDEX_SLOTS(n) \
+  ((n) <= 2 ? 4 : (n) <= 4 ? 8 : (n) <= 8 ? 16 : (n) <= 16 ? 32 : \
+   (n) <= 32 ? 64 : (n) <= 64 ? 128 : 256)
+
+struct linkaddr_index {
+  uint8_t *slots; /* 0: empty, else entry position + 1 */
+  uint8_t mask; /* number of slots - 1 */
+  const char *entries; /* base of the entry array */
+  uint16_t entry_size;
+  uint8_t addr_offset; /* of the linkaddr_t in an entry */
+};
+
+/** \brief A static index for up to n (at most 128) entries, to be set up
+ * through linkaddr_index_init() */
+#define LINKADDR_INDEX(name, n) \
+  static uint8_t name##_slots[LINKADDR_INDEX_SLOTS(n)]; \
+  static struct linkaddr_index name = { name##_slots, LINKADDR_INDEX_SLOTS(n) - 1, NULL, 0, 0 }
+
+/* Attach the index to an entry array, e.g.
+ * linkaddr_index_init(&idx, memb.mem, sizeof(struct x), offsetof(struct x, addr)),
+ * and empty it */
+void linkaddr_index_init(struct linkaddr_index *idx, const void *entries,
+                         uint16_t entry_size, uint8_t addr_offset);
+/* Position of the entry with address addr, -1 if none */
+int linkaddr_index_get(const struct linkaddr_index *idx, const linkaddr_t *addr);
+/* Add the entry at pos, its address must be set and not be in the index yet */
+void linkaddr_index_add(struct linkaddr_index *idx, int pos);
+/* Remove the entry at pos, before its address is changed */
+void linkaddr_index_remove(struct linkaddr_index *idx, int pos);
+
+#endif /* __LINKADDR_INDEX_H__ */
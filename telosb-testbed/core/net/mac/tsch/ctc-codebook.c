@@ -0,0 +1,171 @@
+/**
+ * \file
+ *         Codebook for CTC pulse-width symbols, see ctc-codebook.h
+ */
+
+#include "ctc-codebook.h"
+
+const struct ctc_codebook ctc_cb_legacy = { 11, 7, 7, 0 };
+const struct ctc_codebook ctc_cb_dense = { 11, 0, 5, 1 };
+const struct ctc_codebook ctc_cb_downlink = { 11, 0, 3, 1 };
+
+/*---------------------------------------------------------------------------*/
+static uint8_t
+gcd(uint8_t a, uint8_t b)
+{
+  while(b) {
+    uint8_t t = a % b;
+    a = b;
+    b = t;
+  }
+  return a;
+}
+/*---------------------------------------------------------------------------*/
+/* Weight of data symbol i: the numbers coprime to base, cyclic.
+ * For base 10 this is 1,3,7,9 - every single substitution changes the
+ * weighted sum, and every weight has an inverse to restore an erasure */
+static uint8_t
+weight(uint8_t base, uint8_t i)
+{
+  uint8_t k, n = 0;
+  for(k = 1; k < base; k++) {
+    n += gcd(k, base) == 1;
+  }
+  i %= n;
+  for(k = 1; ; k++) {
+    if(gcd(k, base) == 1 && i-- == 0) {
+      return k;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+inverse(uint8_t w, uint8_t base)
+{
+  uint8_t x;
+  for(x = 1; x < base; x++) {
+    if((uint16_t)w * x % base == 1) {
+      return x;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+ctc_cb_base(const struct ctc_codebook *cb)
+{
+  return cb->codes - 1 - cb->min_code;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+ctc_cb_period(const struct ctc_codebook *cb)
+{
+  return 1 + cb->data_len + cb->check;
+}
+/*---------------------------------------------------------------------------*/
+uint32_t
+ctc_cb_capacity(const struct ctc_codebook *cb)
+{
+  uint32_t cap = 1;
+  uint8_t i;
+  for(i = 0; i < cb->data_len; i++) {
+    cap *= ctc_cb_base(cb);
+  }
+  return cap;
+}
+/*---------------------------------------------------------------------------*/
+int
+ctc_cb_encode(const struct ctc_codebook *cb, uint32_t value, int8_t *codes)
+{
+  uint8_t base = ctc_cb_base(cb);
+  uint8_t i, sum = 0;
+
+  if(value >= ctc_cb_capacity(cb)) {
+    return -1;
+  }
+  for(i = cb->data_len; i-- > 0;) {
+    uint8_t d = value % base;
+    value /= base;
+    codes[i] = cb->min_code + d;
+    sum = (sum + (uint16_t)weight(base, i) * d) % base;
+  }
+  if(cb->check) {
+    codes[cb->data_len] = cb->min_code + sum;
+  }
+  return cb->data_len + cb->check;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctc_cb_rx_init(struct ctc_cb_rx *rx, const struct ctc_codebook *cb)
+{
+  rx->cb = cb;
+  rx->n = 0xff;
+  rx->erasures = 0;
+}
+/*---------------------------------------------------------------------------*/
+/* Complete word in rx->sym, returns CTC_CB_WORD or CTC_CB_ERROR */
+static int
+decode_word(struct ctc_cb_rx *rx, uint32_t *value)
+{
+  const struct ctc_codebook *cb = rx->cb;
+  uint8_t base = ctc_cb_base(cb);
+  uint8_t i, sum = 0, erased = 0xff;
+
+  if(rx->erasures > (cb->check ? 1 : 0)) {
+    return CTC_CB_ERROR;
+  }
+  for(i = 0; i < cb->data_len; i++) {
+    if(rx->sym[i] < 0) {
+      erased = i;
+    } else {
+      sum = (sum + (uint16_t)weight(base, i) * rx->sym[i]) % base;
+    }
+  }
+  if(cb->check && rx->sym[cb->data_len] >= 0) {
+    uint8_t check = rx->sym[cb->data_len];
+    if(erased != 0xff) {
+      /* w * d = check - sum (mod base) */
+      uint8_t rest = (check + base - sum) % base;
+      rx->sym[erased] = (uint16_t)rest * inverse(weight(base, erased), base) % base;
+    } else if(sum != check) {
+      return CTC_CB_ERROR;
+    }
+  }
+  *value = 0;
+  for(i = 0; i < cb->data_len; i++) {
+    *value = *value * base + rx->sym[i];
+  }
+  return CTC_CB_WORD;
+}
+/*---------------------------------------------------------------------------*/
+int
+ctc_cb_rx_push(struct ctc_cb_rx *rx, int8_t code, uint32_t *value)
+{
+  const struct ctc_codebook *cb = rx->cb;
+  uint8_t len = cb->data_len + cb->check;
+  int ret;
+
+  if(code == cb->codes - 1) {
+    ret = rx->n == len ? decode_word(rx, value) : CTC_CB_BELL;
+    rx->n = 0;
+    rx->erasures = 0;
+    return ret;
+  }
+  if(rx->n == 0xff) {
+    return CTC_CB_PENDING;
+  }
+  if(rx->n == len) {
+    /* no bell where one was due */
+    rx->n = 0xff;
+    return CTC_CB_ERROR;
+  }
+  if(code < cb->min_code || code >= cb->codes) {
+    /* no pulse, too short/long, or outside the alphabet */
+    rx->sym[rx->n++] = -1;
+    rx->erasures++;
+  } else {
+    rx->sym[rx->n++] = code - cb->min_code;
+  }
+  return CTC_CB_PENDING;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,86 @@
+/**
+ * \file
+ *         Codebook for CTC pulse-width symbols. Maps multi-slot words to
+ *         per-slot codes and back, with an optional check symbol that
+ *         detects single symbol errors and restores one erased symbol.
+ *         Plain C without Contiki dependencies, also compiled into the
+ *         LoRa transmitter (lora_control).
+ *
+ *         A word is sent as the bell code (highest code) followed by
+ *         data_len data symbols, most significant first, and the check
+ *         symbol. Data symbols are sent as code = min_code + symbol.
+ */
+
+#ifndef __CTC_CODEBOOK_H__
+#define __CTC_CODEBOOK_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Max. symbols of a word after the bell */
+#define CTC_CB_MAX_SYMBOLS 12
+
+/* ctc_cb_rx_push() results */
+#define CTC_CB_PENDING   0  /* symbol stored, word incomplete */
+#define CTC_CB_WORD      1  /* bell after a complete word, value valid */
+#define CTC_CB_BELL      2  /* bell, no complete word before it */
+#define CTC_CB_ERROR    -1  /* word lost: erasures or check failed */
+
+struct ctc_codebook {
+  uint8_t codes;    /* decodable codes, the highest one is the bell */
+  uint8_t min_code; /* code of data symbol 0 */
+  uint8_t data_len; /* data symbols per word */
+  uint8_t check;    /* 1: append a weighted check symbol */
+};
+
+/* Legacy ASN sync: codes 7..9 as base-3 digits, 7 digits, no check */
+extern const struct ctc_codebook ctc_cb_legacy;
+/* Full alphabet: codes 0..9 as base-10 digits, 5 digits + check */
+extern const struct ctc_codebook ctc_cb_dense;
+/* Downlink messages: codes 0..9, 3 digits + check */
+extern const struct ctc_codebook ctc_cb_downlink;
+
+/* Downlink message: header word with flow and seqno, then the command
+ * word. Header words are >= CTC_DL_HEADER, so a message whose header was
+ * lost is dropped instead of taking the command as a header */
+#define CTC_DL_HEADER      500
+#define CTC_DL_MAX_FLOWS   50
+#define CTC_DL_SEQ_MOD     10
+#define CTC_DL_MAX_CMD     (CTC_DL_HEADER - 1)
+#define CTC_DL_WORDS_MSG   2
+#define CTC_DL_HEADER_WORD(flow, seq) \
+  (CTC_DL_HEADER + (flow) * CTC_DL_SEQ_MOD + (seq) % CTC_DL_SEQ_MOD)
+#define CTC_DL_FLOW(word)  (((word) - CTC_DL_HEADER) / CTC_DL_SEQ_MOD)
+#define CTC_DL_SEQ(word)   (((word) - CTC_DL_HEADER) % CTC_DL_SEQ_MOD)
+
+/* Receiver state of one word stream */
+struct ctc_cb_rx {
+  const struct ctc_codebook *cb;
+  int8_t sym[CTC_CB_MAX_SYMBOLS];
+  uint8_t n;        /* symbols since the bell, 0xff: waiting for a bell */
+  uint8_t erasures; /* erased symbols of the current word */
+};
+
+/* Alphabet size of a data symbol */
+uint8_t ctc_cb_base(const struct ctc_codebook *cb);
+/* Slots per word, including bell and check */
+uint8_t ctc_cb_period(const struct ctc_codebook *cb);
+/* Number of distinct word values */
+uint32_t ctc_cb_capacity(const struct ctc_codebook *cb);
+/* Codes of value after the bell, returns number of codes or -1 if value
+ * does not fit */
+int ctc_cb_encode(const struct ctc_codebook *cb, uint32_t value, int8_t *codes);
+
+void ctc_cb_rx_init(struct ctc_cb_rx *rx, const struct ctc_codebook *cb);
+/* Feed one decoded code, negative codes (no/short/long pulse) are
+ * erasures. Returns CTC_CB_xxx, *value is set on CTC_CB_WORD */
+int ctc_cb_rx_push(struct ctc_cb_rx *rx, int8_t code, uint32_t *value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __CTC_CODEBOOK_H__ */
@@ -50,13 +50,13 @@
 #include "net/mac/tsch/tsch-schedule.h"
 #include "lib/ringbufindex.h"
 
-#if WITH_TSCH_LOG
-
 PROCESS_NAME(tsch_pending_events_process);
 
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
 
+#if WITH_TSCH_LOG
+
 #define TSCH_MAX_LOGS 16
 #if (TSCH_MAX_LOGS & (TSCH_MAX_LOGS-1)) != 0
 #error TSCH_MAX_LOGS must be power of two
@@ -66,8 +66,8 @@ static struct tsch_log_t log_array[TSCH_MAX_LOGS];
 static int log_dropped = 0;
 
 /* Process pending log messages */
-void
-tsch_log_process_pending()
+static void
+log_process_pending()
 {
   static int last_log_dropped = 0;
   int16_t log_index;
@@ -141,11 +141,223 @@ tsch_log_commit()
   process_poll(&tsch_pending_events_process);
 }
 
+#endif /* WITH_TSCH_LOG */
+
+#ifdef TSCH_CONF_EVLOG_LEN
+#define TSCH_EVLOG_LEN TSCH_CONF_EVLOG_LEN
+#else
+#define TSCH_EVLOG_LEN 16
+#endif
+#if (TSCH_EVLOG_LEN & (TSCH_EVLOG_LEN-1)) != 0
+#error TSCH_EVLOG_LEN must be power of two
+#endif
+
+#ifdef TSCH_CONF_EVLOG_PROCESS_LEN
+#define TSCH_EVLOG_PROCESS_LEN TSCH_CONF_EVLOG_PROCESS_LEN
+#else
+#define TSCH_EVLOG_PROCESS_LEN 8
+#endif
+#if (TSCH_EVLOG_PROCESS_LEN & (TSCH_EVLOG_PROCESS_LEN-1)) != 0
+#error TSCH_EVLOG_PROCESS_LEN must be power of two
+#endif
+
+struct tsch_evlog_t {
+  uint8_t type;
+  uint8_t flow;
+  uint16_t seq;
+  uint32_t asn;
+  uint32_t arg;
+};
+
+#if TSCH_EVLOG
+
+/* A ringbufindex has one producer only: the slot operation, which
+ * preempts process context, and process context log to rings of their own */
+static struct ringbufindex evlog_ringbuf;
+static struct tsch_evlog_t evlog_array[TSCH_EVLOG_LEN];
+static uint32_t evlog_dropped = 0;
+static struct ringbufindex evlog_process_ringbuf;
+static struct tsch_evlog_t evlog_process_array[TSCH_EVLOG_PROCESS_LEN];
+static uint32_t evlog_process_dropped = 0;
+
+static const char base64[] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/* Print a record as "@" + base64 of its 12 bytes, big endian */
+static void
+evlog_print(const struct tsch_evlog_t *ev)
+{
+  uint8_t raw[12];
+  char line[18];
+  uint8_t i, j;
+  raw[0] = ev->type;
+  raw[1] = ev->flow;
+  raw[2] = ev->seq >> 8;
+  raw[3] = ev->seq;
+  for(i = 0; i < 4; i++) {
+    raw[4 + i] = ev->asn >> (24 - 8 * i);
+    raw[8 + i] = ev->arg >> (24 - 8 * i);
+  }
+  line[0] = '@';
+  for(i = 0, j = 1; i < sizeof(raw); i += 3) {
+    line[j++] = base64[raw[i] >> 2];
+    line[j++] = base64[((raw[i] & 0x03) << 4) | (raw[i + 1] >> 4)];
+    line[j++] = base64[((raw[i + 1] & 0x0f) << 2) | (raw[i + 2] >> 6)];
+    line[j++] = base64[raw[i + 2] & 0x3f];
+  }
+  line[j] = '\0';
+  printf("%s\n", line);
+}
+
+static void
+evlog_add(struct ringbufindex *r, struct tsch_evlog_t *array, uint32_t *dropped,
+          uint8_t type, uint8_t flow, uint16_t seq, uint32_t arg)
+{
+  int16_t index = ringbufindex_peek_put(r);
+  struct tsch_evlog_t *ev;
+  if(index == -1) {
+    (*dropped)++;
+    return;
+  }
+  ev = &array[index];
+  ev->type = type;
+  ev->flow = flow;
+  ev->seq = seq;
+  ev->asn = current_asn.ls4b;
+  ev->arg = arg;
+  ringbufindex_put(r);
+  process_poll(&tsch_pending_events_process);
+}
+
+void
+tsch_evlog_add(uint8_t type, uint8_t flow, uint16_t seq, uint32_t arg)
+{
+  evlog_add(&evlog_ringbuf, evlog_array, &evlog_dropped, type, flow, seq, arg);
+}
+
+void
+tsch_evlog_add_process(uint8_t type, uint8_t flow, uint16_t seq, uint32_t arg)
+{
+  evlog_add(&evlog_process_ringbuf, evlog_process_array, &evlog_process_dropped,
+            type, flow, seq, arg);
+}
+
+static void
+evlog_process_pending()
+{
+  static uint32_t last_dropped = 0;
+  struct tsch_evlog_t drop;
+  int16_t index;
+  uint32_t dropped;
+  while((index = ringbufindex_peek_get(&evlog_ringbuf)) != -1) {
+    evlog_print(&evlog_array[index]);
+    ringbufindex_get(&evlog_ringbuf);
+  }
+  while((index = ringbufindex_peek_get(&evlog_process_ringbuf)) != -1) {
+    evlog_print(&evlog_process_array[index]);
+    ringbufindex_get(&evlog_process_ringbuf);
+  }
+  dropped = evlog_dropped + evlog_process_dropped;
+  if(dropped != last_dropped) {
+    last_dropped = dropped;
+    drop.type = TSCH_EV_DROPPED;
+    drop.flow = 0;
+    drop.seq = 0;
+    drop.asn = current_asn.ls4b;
+    drop.arg = last_dropped;
+    evlog_print(&drop);
+  }
+}
+
+#else /* TSCH_EVLOG */
+
+/* Print the record as text, as evlog-decode.c does */
+void
+tsch_evlog_add(uint8_t type, uint8_t flow, uint16_t seq, uint32_t arg)
+{
+  unsigned long asn = current_asn.ls4b;
+  switch(type) {
+    case TSCH_EV_UL_TX:
+    case TSCH_EV_UL_RX:
+      printf("[ASN=%lu]\tUL-%cX (%u %u): [%u %u->%u]\n", asn, type == TSCH_EV_UL_TX ? 'T' : 'R',
+          flow, seq, (unsigned)(arg >> 16) & 0xff, (unsigned)(arg >> 8) & 0xff, (unsigned)arg & 0xff);
+      break;
+    case TSCH_EV_DL_RX:
+      printf("[ASN=%lu]\tDL-RX: [%u %u]\n", asn, flow, seq);
+      break;
+    case TSCH_EV_DL_TX:
+      printf("[ASN=%lu]\tDL-TX: [%u %u]\t%s\n", asn, flow, seq, arg ? "OK" : "FAIL");
+      break;
+    case TSCH_EV_DL_CTC:
+      printf("[ASN=%lu]\tDL-CTC: flow %u seq %u cmd %lu\n", asn, flow, seq, (unsigned long)arg);
+      break;
+    case TSCH_EV_DL_CTC_LOST:
+      printf("[ASN=%lu]\tDL-CTC: flow %u lost\n", asn, flow);
+      break;
+    case TSCH_EV_DL_CTC_OK:
+      printf("[ASN=%lu]\tDL-CTC: OK\n", asn);
+      break;
+    case TSCH_EV_CTC_CAL:
+      printf("[ASN=%lu]\tCTC-CAL: %d %u %lu\n", asn, (int8_t)flow, seq, (unsigned long)arg);
+      break;
+    case TSCH_EV_CTC_DRIFT:
+      printf("* %s Drift = %ld us\n", (int32_t)arg > 2500 || (int32_t)arg < -2500 ? "Large" : "Est.", (long)arg);
+      break;
+    case TSCH_EV_CTC_DUTY:
+      printf("* Duty Cycle = %lu / %lu\n", (unsigned long)arg, asn);
+      break;
+    case TSCH_EV_CTC_MISS:
+      printf("* CTC-Sync missed (%d)\n* Last-Sync ASN = %lu\n", (int8_t)flow, (unsigned long)arg);
+      break;
+    case TSCH_EV_CTC_LOST:
+      printf("* CTC-Sync lost, EB fallback\n");
+      break;
+    case TSCH_EV_CTC_WINDOW:
+      printf("* CTC-Sync window = %lu us\n", (unsigned long)arg);
+      break;
+    case TSCH_EV_CTC_RESYNC:
+      printf("* CTC-Resync %ld frames\n", (long)arg);
+      break;
+    case TSCH_EV_CTC_REACQUIRED:
+      printf("* CTC-Sync reacquired after %lu misses\n", (unsigned long)arg);
+      break;
+    case TSCH_EV_CTC_ASN_UPDATE:
+      printf("* ASN update = %lu\n", (unsigned long)arg);
+      break;
+  }
+}
+
+void
+tsch_evlog_add_process(uint8_t type, uint8_t flow, uint16_t seq, uint32_t arg)
+{
+  tsch_evlog_add(type, flow, seq, arg);
+}
+
+#endif /* TSCH_EVLOG */
+
+#if WITH_TSCH_LOG || TSCH_EVLOG
+/* Process pending log messages */
+void
+tsch_log_process_pending()
+{
+#if WITH_TSCH_LOG
+  log_process_pending();
+#endif
+#if TSCH_EVLOG
+  evlog_process_pending();
+#endif
+}
+
 /* Initialize log module */
 void
 tsch_log_init()
 {
+#if WITH_TSCH_LOG
   ringbufindex_init(&log_ringbuf, TSCH_MAX_LOGS);
+#endif
+#if TSCH_EVLOG
+  ringbufindex_init(&evlog_ringbuf, TSCH_EVLOG_LEN);
+  ringbufindex_init(&evlog_process_ringbuf, TSCH_EVLOG_PROCESS_LEN);
+#endif
 }
-
-#endif /* WITH_TSCH_LOG */
+#endif /* WITH_TSCH_LOG || TSCH_EVLOG */
@@ -84,10 +84,6 @@ struct tsch_log_t {
 struct tsch_log_t *tsch_log_prepare_add();
 /* Actually add the previously prepared log */
 void tsch_log_commit();
-/* Initialize log module */
-void tsch_log_init();
-/* Process pending log messages */
-void tsch_log_process_pending();
 
 #define TSCH_LOG_ADD(log_type, init_code) do { \
     struct tsch_log_t *log = tsch_log_prepare_add(); \
@@ -100,8 +96,55 @@ void tsch_log_process_pending();
 
 #else /* WITH_TSCH_LOG */
 
-#define tsch_log_init()
-#define tsch_log_process_pending()
 #define TSCH_LOG_ADD(log_type, init_code)
 
 #endif /* WITH_TSCH_LOG */
+
+/* Event log: fixed-size binary records of the testbed events of the link
+ * operation (uplink/downlink packets, CTC sync and downlink). With
+ * TSCH_EVLOG set they are queued and printed later from
+ * tsch_pending_events_process, one "@" + 16 base64 characters line each,
+ * decoded on the host by evaluation-tools/evlog-decode.c. Otherwise they
+ * are printed as text right away */
+#ifdef TSCH_CONF_EVLOG
+#define TSCH_EVLOG TSCH_CONF_EVLOG
+#else
+#define TSCH_EVLOG 1
+#endif
+
+/* Record types, keep in sync with enum EvType in evaluation-tools/evlog.h */
+enum tsch_evlog_type {
+  TSCH_EV_UL_TX,          /* flow, seq, arg: hop << 16 | src << 8 | dest */
+  TSCH_EV_UL_RX,          /* as TSCH_EV_UL_TX */
+  TSCH_EV_DL_RX,          /* flow, seq */
+  TSCH_EV_DL_TX,          /* flow, seq, arg: acked */
+  TSCH_EV_DL_CTC,         /* flow, seq, arg: command word */
+  TSCH_EV_DL_CTC_LOST,    /* flow */
+  TSCH_EV_DL_CTC_OK,
+  TSCH_EV_CTC_CAL,        /* flow: code, seq: width [us], arg: start [us] */
+  TSCH_EV_CTC_DRIFT,      /* arg: drift [us] */
+  TSCH_EV_CTC_DUTY,       /* arg: active slots */
+  TSCH_EV_CTC_MISS,       /* flow: sync state, arg: ASN of the last sync */
+  TSCH_EV_CTC_LOST,
+  TSCH_EV_CTC_WINDOW,     /* arg: sync window [us] */
+  TSCH_EV_CTC_RESYNC,     /* arg: frames */
+  TSCH_EV_CTC_REACQUIRED, /* arg: misses */
+  TSCH_EV_CTC_ASN_UPDATE, /* arg: ASN update */
+  TSCH_EV_DROPPED,        /* arg: records dropped since boot */
+};
+
+/* Add an event record, stamped with the current ASN, from the slot
+ * operation (rtimer interrupt) */
+void tsch_evlog_add(uint8_t type, uint8_t flow, uint16_t seq, uint32_t arg);
+/* As tsch_evlog_add(), from process context */
+void tsch_evlog_add_process(uint8_t type, uint8_t flow, uint16_t seq, uint32_t arg);
+
+#if WITH_TSCH_LOG || TSCH_EVLOG
+/* Initialize log module */
+void tsch_log_init();
+/* Process pending log messages */
+void tsch_log_process_pending();
+#else
+#define tsch_log_init()
+#define tsch_log_process_pending()
+#endif
@@ -56,6 +56,19 @@
 /* Fixed offset of the sync IE in EBs. Needed for quick update of the fields from interrupt.
  * FCF + seqno + pan ID + source MAC + MLME outer ID */
 #define EB_IE_SYNC_OFFSET (2+1+2+8+2)
+/* Length of our EBs: header, sync, timeslot and hop sequence template IEs */
+#define EB_LEN (EB_IE_SYNC_OFFSET+8+3+3)
+/* Offsets of the destination address and the sync IE in enhanced ACKs */
+#define ACK_ADDR_OFFSET (TSCH_BASE_ACK_LEN+2)
+#define ACK_IE_SYNC_OFFSET (TSCH_BASE_ACK_LEN+TSCH_PACKET_DEST_ADDR_IN_ACK*TSCH_EACK_DEST_LEN)
+
+/* EB and enhanced ACK, serialized once by tsch_packet_update_templates().
+ * Frames are copies of these, with only seqno, ASN, join priority,
+ * destination and time correction patched in */
+static uint8_t eb_template[EB_LEN];
+static uint8_t eb_template_len;
+static uint8_t ack_template[TSCH_ACK_LEN];
+static uint8_t ack_template_len;
 
 /* Parse 802.15.4e time correction IE */
 static int
@@ -152,6 +165,21 @@ append_addr(uint8_t* const buf, int buf_size, linkaddr_t *addr)
   }
 }
 
+/* Write drift and nack into an 802.15.4e time correction IE */
+static void
+patch_ie_time_correction(uint8_t* const buf, int32_t drift, int nack)
+{
+  int16_t drift_us;
+  uint16_t time_sync_field;
+  drift_us = (int16_t)RTIMERTICKS_TO_US(drift);
+  time_sync_field = drift_us & 0x0fff;
+  if(nack) {
+    time_sync_field |= 0x8000;
+  }
+  buf[2] = time_sync_field & 0xff;
+  buf[3] = (time_sync_field >> 8) & 0xff;
+}
+
 /* Update packet with 802.15.4e time correction IE */
 static int
 append_ie_time_correction(uint8_t* const buf, int buf_size,
@@ -160,17 +188,9 @@ append_ie_time_correction(uint8_t* const buf, int buf_size,
   if(buf_size < TSCH_SYNC_IE_LEN) {
     return 0;
   } else {
-    int16_t drift_us;
-    uint16_t time_sync_field;
-    drift_us = (int16_t)RTIMERTICKS_TO_US(drift);
-    time_sync_field = drift_us & 0x0fff;
-    if(nack) {
-      time_sync_field |= 0x8000;
-    }
     buf[0] = 0x02;
     buf[1] = 0x1e;
-    buf[2] = time_sync_field & 0xff;
-    buf[3] = (time_sync_field >> 8) & 0xff;
+    patch_ie_time_correction(buf, drift, nack);
     return TSCH_SYNC_IE_LEN;
   }
 }
@@ -220,9 +240,9 @@ int tsch_packet_parse_sync_ack(int32_t *drift, int *nack,
   }
   return 0;
 }
-/* Construct enhanced ACK packet and return ACK length */
-int
-tsch_packet_make_sync_ack(int32_t drift, int nack,
+/* Serialize an enhanced ACK packet and return ACK length */
+static int
+build_sync_ack(int32_t drift, int nack,
     uint8_t *ackbuf, int ackbuf_len, linkaddr_t *dest_addr, uint8_t seqno)
 {
   if(ackbuf_len < TSCH_ACK_LEN) {
@@ -249,6 +269,27 @@ tsch_packet_make_sync_ack(int32_t drift, int nack,
     return curr_len;
   }
 }
+/* Construct enhanced ACK packet and return ACK length */
+int
+tsch_packet_make_sync_ack(int32_t drift, int nack,
+    uint8_t *ackbuf, int ackbuf_len, linkaddr_t *dest_addr, uint8_t seqno)
+{
+  if(ack_template_len == 0) {
+    tsch_packet_update_templates();
+  }
+  if(ackbuf_len < ack_template_len) {
+    return 0;
+  }
+  memcpy(ackbuf, ack_template, ack_template_len);
+  ackbuf[2] = seqno;
+#if TSCH_PACKET_DEST_ADDR_IN_ACK
+  append_addr(&ackbuf[ACK_ADDR_OFFSET], LINKADDR_SIZE, dest_addr);
+#endif
+#if TSCH_PACKET_WITH_SYNC_IE
+  patch_ie_time_correction(&ackbuf[ACK_IE_SYNC_OFFSET], drift, nack);
+#endif
+  return ack_template_len;
+}
 
 /* Extract 802.15.4 frame type from FCF least-significant byte */
 uint8_t
@@ -438,7 +479,7 @@ append_ie_sync(uint8_t* const buf, int buf_size,
       buf[5] = asn->ls4b >> 24;
       buf[6] = asn->ms1b;
     } else {
-      memset(buf, 0, 5);
+      memset(&buf[2], 0, 5);
     }
     buf[7] = join_priority;
 
@@ -496,9 +537,9 @@ append_ie_mlme_outer(uint8_t* const buf, int buf_size,
   }
 }
 
-/* Create an EB packet */
-int
-tsch_packet_make_eb(uint8_t* const buf, uint8_t buf_size, uint8_t seqno)
+/* Serialize an EB packet */
+static int
+build_eb(uint8_t* const buf, uint8_t buf_size, uint8_t seqno)
 {
   uint8_t curr_len = 0;
   uint8_t ie_mlme_offset;
@@ -537,12 +578,36 @@ tsch_packet_make_eb(uint8_t* const buf, uint8_t buf_size, uint8_t seqno)
 
   /* TODO append TSCH slotframe & link IE */
 
-  /* MLME IE */
-  curr_len += append_ie_mlme_outer(&buf[ie_mlme_offset], 2, curr_len-ie_mlme_offset-2);
+  /* MLME IE, in the 2 bytes left for it */
+  append_ie_mlme_outer(&buf[ie_mlme_offset], 2, curr_len-ie_mlme_offset-2);
 
   return curr_len;
 }
 
+/* Serialize the EB and enhanced ACK templates */
+void
+tsch_packet_update_templates(void)
+{
+  eb_template_len = build_eb(eb_template, sizeof(eb_template), 0);
+  ack_template_len = build_sync_ack(0, 0, ack_template, sizeof(ack_template),
+                                    (linkaddr_t *)&linkaddr_null, 0);
+}
+
+/* Create an EB packet */
+int
+tsch_packet_make_eb(uint8_t* const buf, uint8_t buf_size, uint8_t seqno)
+{
+  if(eb_template_len == 0) {
+    tsch_packet_update_templates();
+  }
+  if(buf_size < eb_template_len) {
+    return 0;
+  }
+  memcpy(buf, eb_template, eb_template_len);
+  buf[2] = seqno;
+  return eb_template_len;
+}
+
 /* Update ASN in EB packet */
 int
 tsch_packet_update_eb(uint8_t *buf, uint8_t buf_size)
@@ -550,10 +615,17 @@ tsch_packet_update_eb(uint8_t *buf, uint8_t buf_size)
   if(/* is beacon? */
      (FRAME802154_BEACONFRAME == (buf[0] & 7))
      /* IE FCF as expected? */
-     && ((buf[1] & 0xe2) == 0xe2)) {
-    /* Update ASN and join priority */
-    return append_ie_sync(
-        &buf[EB_IE_SYNC_OFFSET], buf_size-EB_IE_SYNC_OFFSET, &current_asn, tsch_join_priority);
+     && ((buf[1] & 0xe2) == 0xe2)
+     && buf_size >= EB_IE_SYNC_OFFSET + 8) {
+    /* Update ASN and join priority, the IE header comes from the template */
+    uint8_t *ie = &buf[EB_IE_SYNC_OFFSET];
+    ie[2] = current_asn.ls4b;
+    ie[3] = current_asn.ls4b >> 8;
+    ie[4] = current_asn.ls4b >> 16;
+    ie[5] = current_asn.ls4b >> 24;
+    ie[6] = current_asn.ms1b;
+    ie[7] = tsch_join_priority;
+    return 8;
   }
   return 0;
 }
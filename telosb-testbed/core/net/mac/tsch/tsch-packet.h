@@ -62,6 +62,11 @@ int tsch_packet_make_sync_ack(int32_t drift, int nack,
 int tsch_packet_parse_sync_ack(int32_t *drift, int *nack,
     uint8_t *ackbuf, int ackbuf_len, uint8_t seqno, int extract_sync_ie);
 
+/* Serialize the cached EB and enhanced ACK templates again. Call when
+ * the node address or the contents of the IEs (schedule, hopping
+ * sequence) change; EBs and ACKs are copies of the templates */
+void tsch_packet_update_templates(void);
+
 /* Create an EB packet */
 int tsch_packet_make_eb(uint8_t* const buf, uint8_t buf_size, uint8_t seqno);
 
@@ -146,6 +146,13 @@ struct asn_divisor_t {
   uint16_t asn_ms1b_remainder; /* Remainder of the operation 0x100000000 / val */
 };
 
+/* ASN modulo a divisor, kept for the ASN it was last computed for so that
+ * the next one is reached by addition, see tsch_asn_offset() */
+struct asn_offset_t {
+  struct asn_t asn; /* ASN of val */
+  uint16_t val; /* asn % divisor */
+};
+
 /* Initialize ASN */
 #define ASN_INIT(asn, ms1b_, ls4b_) do { \
   (asn).ms1b = (ms1b_); \
@@ -205,6 +212,8 @@ void tsch_release_lock();
 
 /* Returns a 802.15.4 channel from an ASN and channel offset */
 uint8_t tsch_calculate_channel(struct asn_t *asn, uint8_t channel_offset);
+/* Returns asn % div, advancing off from the ASN it was last computed for */
+uint16_t tsch_asn_offset(struct asn_offset_t *off, const struct asn_t *asn, const struct asn_divisor_t *div);
 /* The the period at which EBs are sent */
 void tsch_set_eb_period(uint32_t period);
 /* Brief dump of the TSCH state */
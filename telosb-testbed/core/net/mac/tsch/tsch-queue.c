@@ -45,6 +45,7 @@
 #include "lib/list.h"
 #include "lib/memb.h"
 #include "net/queuebuf.h"
+#include "net/linkaddr-index.h"
 #include "net/mac/rdc.h"
 #include "net/mac/tsch/tsch.h"
 #include "net/mac/tsch/tsch-private.h"
@@ -65,10 +66,19 @@ void TSCH_CALLBACK_NEW_TIME_SOURCE(struct tsch_neighbor *old, struct tsch_neighb
 MEMB(packet_memb, struct tsch_packet, QUEUEBUF_NUM);
 MEMB(neighbor_memb, struct tsch_neighbor, TSCH_QUEUE_MAX_NEIGHBOR_QUEUES);
 LIST(neighbor_list);
+/* Hash index of the neighbors, by address */
+LINKADDR_INDEX(neighbor_index, TSCH_QUEUE_MAX_NEIGHBOR_QUEUES);
+#define NBR_POS(n) ((n) - (struct tsch_neighbor *)neighbor_memb.mem)
 
 /* Broadcast and EB virtual neighbors */
 struct tsch_neighbor *n_broadcast;
 struct tsch_neighbor *n_eb;
+/* Control queues of the broadcast and EB neighbors, which carry all
+ * broadcast control traffic */
+static struct tsch_packet *broadcast_control_array[TSCH_QUEUE_NUM_CONTROL_BROADCAST];
+static struct tsch_packet *eb_control_array[TSCH_QUEUE_NUM_CONTROL_BROADCAST];
+
+struct tsch_queue_stats tsch_queue_stats[TSCH_QUEUE_NUM_CLASSES];
 
 /**
  *  A pseudo-random generator with better properties than msp430-libc's default
@@ -101,13 +111,22 @@ tsch_queue_add_nbr(const linkaddr_t *addr)
       if(n != NULL) {
         /* Initialize neighbor entry */
         memset(n, 0, sizeof(struct tsch_neighbor));
-        ringbufindex_init(&n->tx_ringbuf, TSCH_QUEUE_NUM_PER_NEIGHBOR);
         linkaddr_copy(&n->addr, addr);
         n->is_broadcast = linkaddr_cmp(addr, &tsch_eb_address)
                     || linkaddr_cmp(addr, &tsch_broadcast_address);
+        if(n->is_broadcast) {
+          n->control_array = linkaddr_cmp(addr, &tsch_eb_address)
+                    ? eb_control_array : broadcast_control_array;
+          ringbufindex_init(&n->control_ringbuf, TSCH_QUEUE_NUM_CONTROL_BROADCAST);
+        } else {
+          n->control_array = n->control_storage;
+          ringbufindex_init(&n->control_ringbuf, TSCH_QUEUE_NUM_CONTROL_PER_NEIGHBOR);
+        }
+        ringbufindex_init(&n->tx_ringbuf, TSCH_QUEUE_NUM_PER_NEIGHBOR);
         tsch_queue_backoff_reset(n);
-        /* Add neighbor to the list */
+        /* Add neighbor to the list and index */
         list_add(neighbor_list, n);
+        linkaddr_index_add(&neighbor_index, NBR_POS(n));
       }
       tsch_release_lock();
     }
@@ -128,12 +147,9 @@ struct tsch_neighbor *
 tsch_queue_get_nbr(const linkaddr_t *addr)
 {
   if(!tsch_is_locked()) {
-    struct tsch_neighbor *n = list_head(neighbor_list);
-    while(n != NULL) {
-      if(linkaddr_cmp(&n->addr, addr)) {
-        return n;
-      }
-      n = list_item_next(n);
+    int pos = linkaddr_index_get(&neighbor_index, addr);
+    if(pos >= 0) {
+      return (struct tsch_neighbor *)neighbor_memb.mem + pos;
     }
   }
   return NULL;
@@ -196,6 +212,7 @@ tsch_queue_flush_nbr_queue(struct tsch_neighbor *n)
     if(p != NULL) {
       /* Set return status for packet_sent callback */
       p->ret = MAC_TX_ERR;
+      tsch_queue_stats[p->tx_class].tx_drops++;
       /* Call packet_sent callback */
       mac_call_sent_callback(p->sent, p->ptr, p->ret, p->transmissions);
       /* Free packet queuebuf */
@@ -210,8 +227,9 @@ tsch_queue_remove_nbr(struct tsch_neighbor *n)
   if(n != NULL) {
     if(tsch_get_lock()) {
 
-      /* Remove neighbor from list */
+      /* Remove neighbor from list and index */
       list_remove(neighbor_list, n);
+      linkaddr_index_remove(&neighbor_index, NBR_POS(n));
 
       tsch_release_lock();
 
@@ -229,15 +247,18 @@ tsch_queue_remove_nbr(struct tsch_neighbor *n)
 }
 /* Add packet to neighbor queue. Use same lockfree implementation as ringbuf.c (put is atomic) */
 int
-tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
+tsch_queue_add_packet(const linkaddr_t *addr, uint8_t tx_class, uint16_t deadline,
+                      mac_callback_t sent, void *ptr)
 {
   struct tsch_neighbor *n = NULL;
+  struct ringbufindex *r;
   int16_t put_index = -1;
   struct tsch_packet *p = NULL;
   if(!tsch_is_locked()) {
     n = tsch_queue_add_nbr(addr);
     if(n != NULL) {
-      put_index = ringbufindex_peek_put(&n->tx_ringbuf);
+      r = tx_class == TSCH_QUEUE_CLASS_CONTROL ? &n->control_ringbuf : &n->tx_ringbuf;
+      put_index = ringbufindex_peek_put(r);
       if(put_index != -1) {
         p = memb_alloc(&packet_memb);
         if(p != NULL) {
@@ -248,9 +269,16 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
             p->ptr = ptr;
             p->ret = MAC_TX_DEFERRED;
             p->transmissions = 0;
+            p->tx_class = tx_class;
+            p->deadline = (uint16_t)current_asn.ls4b + deadline;
             /* Add to ringbuf (actual add committed through atomic operation) */
-            n->tx_array[put_index] = p;
-            ringbufindex_put(&n->tx_ringbuf);
+            if(tx_class == TSCH_QUEUE_CLASS_CONTROL) {
+              n->control_array[put_index] = p;
+            } else {
+              n->tx_array[put_index] = p;
+            }
+            ringbufindex_put(r);
+            tsch_queue_stats[tx_class].enqueued++;
             return 1;
           } else {
             memb_free(&packet_memb, p);
@@ -260,6 +288,7 @@ tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr)
     }
   }
   PRINTF("TSCH-queue:! add packet failed: %u %p %d %p %p", tsch_is_locked(), n, put_index, p, p ? p->qb : NULL);
+  tsch_queue_stats[tx_class].overflows++;
   return 0;
 }
 /* Returns the number of packets currently in the queue */
@@ -270,7 +299,7 @@ tsch_queue_packet_count(const linkaddr_t *addr)
   if(!tsch_is_locked()) {
     n = tsch_queue_add_nbr(addr);
     if(n != NULL) {
-      return ringbufindex_elements(&n->tx_ringbuf);
+      return ringbufindex_elements(&n->control_ringbuf) + ringbufindex_elements(&n->tx_ringbuf);
     }
   }
   return -1;
@@ -281,8 +310,17 @@ tsch_queue_remove_packet_from_queue(struct tsch_neighbor *n)
 {
   if(!tsch_is_locked()) {
     if(n != NULL) {
-      /* Get and remove packet from ringbuf (remove committed through an atomic operation */
-      int16_t get_index = ringbufindex_get(&n->tx_ringbuf);
+      /* Get and remove packet from ringbuf (remove committed through an atomic operation.
+       * A control packet enqueued since the last get must not be taken instead of
+       * the data packet that was returned */
+      int16_t get_index;
+      if(n->head_is_control || ringbufindex_empty(&n->tx_ringbuf)) {
+        get_index = ringbufindex_get(&n->control_ringbuf);
+        if(get_index != -1) {
+          return n->control_array[get_index];
+        }
+      }
+      get_index = ringbufindex_get(&n->tx_ringbuf);
       if(get_index != -1) {
         return n->tx_array[get_index];
       } else {
@@ -338,18 +376,51 @@ tsch_queue_free_unused_neighbors()
 int
 tsch_queue_is_empty(const struct tsch_neighbor *n)
 {
-  return !tsch_is_locked() && n != NULL && ringbufindex_empty(&n->tx_ringbuf);
+  return !tsch_is_locked() && n != NULL && ringbufindex_empty(&n->control_ringbuf)
+      && ringbufindex_empty(&n->tx_ringbuf);
+}
+/* Move the data packet with the earliest deadline to the head of the data
+ * queue, the packets before it move back by one (ties stay in FIFO order).
+ * Only touches the entries between the get and put indices, which the
+ * producer leaves alone, so put stays lockfree */
+static void
+tsch_queue_edf_to_head(struct tsch_neighbor *n, int16_t head)
+{
+  int count = ringbufindex_elements(&n->tx_ringbuf);
+  int16_t i = head, best = head;
+  struct tsch_packet *p;
+  while(--count > 0) {
+    i = (i + 1) & (TSCH_QUEUE_NUM_PER_NEIGHBOR - 1);
+    if((int16_t)(n->tx_array[i]->deadline - n->tx_array[best]->deadline) < 0) {
+      best = i;
+    }
+  }
+  if(best != head) {
+    p = n->tx_array[best];
+    for(i = best; i != head; i = (i - 1) & (TSCH_QUEUE_NUM_PER_NEIGHBOR - 1)) {
+      n->tx_array[i] = n->tx_array[(i - 1) & (TSCH_QUEUE_NUM_PER_NEIGHBOR - 1)];
+    }
+    n->tx_array[head] = p;
+  }
 }
 /* Returns the first packet from a neighbor queue */
 struct tsch_packet *
-tsch_queue_get_packet_for_nbr(const struct tsch_neighbor *n, int is_shared_link)
+tsch_queue_get_packet_for_nbr(struct tsch_neighbor *n, int is_shared_link)
 {
   if(!tsch_is_locked()) {
-    if(n != NULL) {
-      int16_t get_index = ringbufindex_peek_get(&n->tx_ringbuf);
-      if(get_index != -1 &&
-          !(is_shared_link && !tsch_queue_backoff_expired(n))) {    /* If this is a shared link,
+    if(n != NULL
+        && !(is_shared_link && !tsch_queue_backoff_expired(n))) {    /* If this is a shared link,
                                                                     make sure the backoff has expired */
+      /* Strict priority for control */
+      int16_t get_index = ringbufindex_peek_get(&n->control_ringbuf);
+      if(get_index != -1) {
+        n->head_is_control = 1;
+        return n->control_array[get_index];
+      }
+      get_index = ringbufindex_peek_get(&n->tx_ringbuf);
+      if(get_index != -1) {
+        n->head_is_control = 0;
+        tsch_queue_edf_to_head(n, get_index);
         return n->tx_array[get_index];
       }
     }
@@ -441,6 +512,8 @@ tsch_queue_init(void)
       *((uint32_t *)&linkaddr_node_addr + 1));
   memb_init(&neighbor_memb);
   memb_init(&packet_memb);
+  linkaddr_index_init(&neighbor_index, neighbor_memb.mem, sizeof(struct tsch_neighbor),
+                      offsetof(struct tsch_neighbor, addr));
   /* Add virtual EB and the broadcast neighbors */
   n_eb = tsch_queue_add_nbr(&tsch_eb_address);
   n_broadcast = tsch_queue_add_nbr(&tsch_broadcast_address);
@@ -491,7 +564,7 @@ tsch_queue_test(int num_nbr)
       packetbuf_set_datalen(len);
 
       /* Enqueue packet */
-      if(!tsch_queue_add_packet(&node_addr[b], NULL, NULL)) {
+      if(!tsch_queue_add_packet(&node_addr[b], TSCH_QUEUE_CLASS_BEST_EFFORT, 0, NULL, NULL)) {
         printf("TSCH-queue test: Add packet %d FAILED\n", q + 1 );
         break;
       }
@@ -551,6 +624,7 @@ tsch_queue_dump_nbrs()
 {
   if(!tsch_is_locked()) {
     struct tsch_neighbor *curr_nbr = list_head(neighbor_list);
+    int i;
     printf("TSCH Queue dump-nbrs: Begin: ---->\n");
     while(curr_nbr != NULL) {
       void uip_debug_lladdr_print(const uip_lladdr_t *addr);
@@ -560,6 +634,11 @@ tsch_queue_dump_nbrs()
       /* Get next in list */
       curr_nbr = list_item_next(curr_nbr);
     }
+    for(i = 0; i < TSCH_QUEUE_NUM_CLASSES; i++) {
+      printf("TSCH Queue class %d: enqueued %u overflows %u tx drops %u late %u\n", i,
+          tsch_queue_stats[i].enqueued, tsch_queue_stats[i].overflows,
+          tsch_queue_stats[i].tx_drops, tsch_queue_stats[i].late);
+    }
     printf("TSCH Queue dump-nbrs: Done. <----\n");
   } else {
     printf("TSCH Queue dump-nbrs: LOCKED\n");
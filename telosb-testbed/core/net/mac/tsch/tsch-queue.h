@@ -34,6 +34,8 @@
  * \file
  *         Per-neighbor packet queues for TSCH MAC.
  *         The list of neighbor uses a lock, but per-neighbor packet array are lockfree.
+ *         Each neighbor has a control queue, served first, and a data queue,
+ *         served earliest deadline first.
  *				 Read-only operation on neighbor and packets are allowed from interrupts and outside of them.
  *				 *Other operations are allowed outside of interrupt only.*
  * \author
@@ -59,20 +61,77 @@
 #error TSCH_QUEUE_NUM_PER_NEIGHBOR must be power of two
 #endif
 
+/* The size of the per-neighbor control queue (EBs, ICMPv6 i.e. RPL and ND,
+ * keepalives): must be power of two */
+#ifdef TSCH_CONF_QUEUE_NUM_CONTROL_PER_NEIGHBOR
+#define TSCH_QUEUE_NUM_CONTROL_PER_NEIGHBOR TSCH_CONF_QUEUE_NUM_CONTROL_PER_NEIGHBOR
+#else
+#define TSCH_QUEUE_NUM_CONTROL_PER_NEIGHBOR 4
+#endif
+
+#if (TSCH_QUEUE_NUM_CONTROL_PER_NEIGHBOR & (TSCH_QUEUE_NUM_CONTROL_PER_NEIGHBOR-1)) != 0
+#error TSCH_QUEUE_NUM_CONTROL_PER_NEIGHBOR must be power of two
+#endif
+
+/* The size of the control queue of the broadcast and EB neighbors, which
+ * carry all broadcast DIO, DIS and ND traffic: must be power of two */
+#ifdef TSCH_CONF_QUEUE_NUM_CONTROL_BROADCAST
+#define TSCH_QUEUE_NUM_CONTROL_BROADCAST TSCH_CONF_QUEUE_NUM_CONTROL_BROADCAST
+#else
+#define TSCH_QUEUE_NUM_CONTROL_BROADCAST TSCH_QUEUE_NUM_PER_NEIGHBOR
+#endif
+
+#if (TSCH_QUEUE_NUM_CONTROL_BROADCAST & (TSCH_QUEUE_NUM_CONTROL_BROADCAST-1)) != 0
+#error TSCH_QUEUE_NUM_CONTROL_BROADCAST must be power of two
+#endif
+
+/* Relative deadline, in slots, of the packets of tagged application flows
+ * (those that carry a struct app_data), by flow id */
+#ifdef TSCH_CONF_QUEUE_FLOW_DEADLINE
+#define TSCH_QUEUE_FLOW_DEADLINE(flow) TSCH_CONF_QUEUE_FLOW_DEADLINE(flow)
+#else
+#define TSCH_QUEUE_FLOW_DEADLINE(flow) 101
+#endif
+
+/* Relative deadline, in slots, of other data packets. Finite, so that they
+ * are not starved by the flows */
+#ifdef TSCH_CONF_QUEUE_BEST_EFFORT_DEADLINE
+#define TSCH_QUEUE_BEST_EFFORT_DEADLINE TSCH_CONF_QUEUE_BEST_EFFORT_DEADLINE
+#else
+#define TSCH_QUEUE_BEST_EFFORT_DEADLINE 1010
+#endif
+
 #ifdef TSCH_CONF_QUEUE_MAX_NEIGHBOR_QUEUES
 #define TSCH_QUEUE_MAX_NEIGHBOR_QUEUES TSCH_CONF_QUEUE_MAX_NEIGHBOR_QUEUES
 #else
 #define TSCH_QUEUE_MAX_NEIGHBOR_QUEUES 8
 #endif
 
+/* Traffic classes */
+#define TSCH_QUEUE_CLASS_CONTROL     0 /* control queue, strict priority */
+#define TSCH_QUEUE_CLASS_FLOW        1 /* data queue, deadline of the flow */
+#define TSCH_QUEUE_CLASS_BEST_EFFORT 2 /* data queue, TSCH_QUEUE_BEST_EFFORT_DEADLINE */
+#define TSCH_QUEUE_NUM_CLASSES       3
+
 /* TSCH packet information */
 struct tsch_packet {
   struct queuebuf *qb;  /* pointer to the queuebuf to be sent */
   mac_callback_t sent; /* callback for this packet */
   void *ptr; /* MAC callback parameter */
+  uint16_t deadline; /* ASN (16 LSBs) by which the packet should be sent */
   uint8_t transmissions; /* #transmissions performed for this packet */
   uint8_t ret; /* status -- MAC return code */
+  uint8_t tx_class; /* TSCH_QUEUE_CLASS_* */
+};
+
+/* Per-class statistics */
+struct tsch_queue_stats {
+  uint16_t enqueued;
+  uint16_t overflows; /* not enqueued: queue full or no queuebuf left */
+  uint16_t tx_drops; /* dequeued without success: retries exhausted or flushed */
+  uint16_t late; /* dequeued after their deadline (data classes) */
 };
+extern struct tsch_queue_stats tsch_queue_stats[TSCH_QUEUE_NUM_CLASSES];
 
 /* TSCH neighbor information */
 struct tsch_neighbor {
@@ -86,10 +145,16 @@ struct tsch_neighbor {
   uint8_t last_backoff_window; /* Last CSMA backoff window */
   uint8_t tx_links_count; /* How many links do we have to this neighbor? */
   uint8_t dedicated_tx_links_count; /* How many dedicated links do we have to this neighbor? */
-  /* Array for the ringbuf. Contains pointers to packets.
-   * Its size must be a power of two to allow for atomic put */
+  uint8_t head_is_control; /* Was the last packet returned by tsch_queue_get_packet_for_nbr a control packet? */
+  /* Arrays for the ringbufs. Contain pointers to packets.
+   * Their size must be a power of two to allow for atomic put.
+   * control_array points to control_storage, or for the broadcast and EB
+   * neighbors to a static array of TSCH_QUEUE_NUM_CONTROL_BROADCAST */
+  struct tsch_packet **control_array;
+  struct tsch_packet *control_storage[TSCH_QUEUE_NUM_CONTROL_PER_NEIGHBOR];
   struct tsch_packet *tx_array[TSCH_QUEUE_NUM_PER_NEIGHBOR];
-  /* Circular buffer of pointers to packet. */
+  /* Circular buffers of pointers to packet: control and data */
+  struct ringbufindex control_ringbuf;
   struct ringbufindex tx_ringbuf;
 };
 
@@ -105,12 +170,15 @@ struct tsch_neighbor *tsch_queue_get_nbr(const linkaddr_t *addr);
 struct tsch_neighbor *tsch_queue_get_time_source();
 /* Update TSCH time source */
 int tsch_queue_update_time_source(const linkaddr_t *new_addr);
-/* Add packet to neighbor queue. Use same lockfree implementation as ringbuf.c (put is atomic) */
-int tsch_queue_add_packet(const linkaddr_t *addr, mac_callback_t sent, void *ptr);
+/* Add packet to neighbor queue. Use same lockfree implementation as ringbuf.c (put is atomic).
+ * deadline is relative, in slots, and only used in the data classes */
+int tsch_queue_add_packet(const linkaddr_t *addr, uint8_t tx_class, uint16_t deadline,
+                          mac_callback_t sent, void *ptr);
 /* Returns the number of packets currently in the queue */
 int tsch_queue_packet_count(const linkaddr_t *addr);
-/* Remove first packet from a neighbor queue. The packet is stored in a seprate
- * dequeued packet list, for later processing. Return the packet. */
+/* Remove the packet last returned by tsch_queue_get_packet_for_nbr (or, if it
+ * was dequeued already, the first packet) from a neighbor queue. The packet is
+ * stored in a seprate dequeued packet list, for later processing. Return the packet. */
 struct tsch_packet *tsch_queue_remove_packet_from_queue(struct tsch_neighbor *n);
 /* Free a packet */
 void tsch_queue_free_packet(struct tsch_packet *p);
@@ -120,8 +188,9 @@ void tsch_queue_flush_all();
 void tsch_queue_free_unused_neighbors();
 /* Is the neighbor queue empty? */
 int tsch_queue_is_empty(const struct tsch_neighbor *n);
-/* Returns the first packet from a neighbor queue */
-struct tsch_packet *tsch_queue_get_packet_for_nbr(const struct tsch_neighbor *n, int is_shared_link);
+/* Returns the first packet from a neighbor queue: the head of the control queue,
+ * else the data packet with the earliest deadline, which is moved to the head */
+struct tsch_packet *tsch_queue_get_packet_for_nbr(struct tsch_neighbor *n, int is_shared_link);
 /* Returns the head packet from a neighbor queue (from neighbor address) */
 struct tsch_packet *tsch_queue_get_packet_for_dest_addr(const linkaddr_t *addr, int is_shared_link);
 /* Returns the head packet of any neighbor queue with zero backoff counter.
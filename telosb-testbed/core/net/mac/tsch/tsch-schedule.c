@@ -102,6 +102,10 @@ tsch_schedule_add_slotframe(uint16_t handle, uint16_t size)
         sf->handle = handle;
         ASN_DIVISOR_INIT(sf->size, size);
         LIST_STRUCT_INIT(sf, links_list);
+        ASN_INIT(sf->offset.asn, 0, 0);
+        sf->offset.val = 0;
+        sf->next_link = NULL;
+        sf->next_link_valid = 0;
         /* Add the slotframe to the global list */
         list_add(slotframe_list, sf);
       }
@@ -188,8 +192,19 @@ tsch_schedule_add_link(struct tsch_slotframe *slotframe,
       } else {
         static int current_link_handle = 0;
         struct tsch_neighbor *n;
-        /* Add the link to the slotframe */
-        list_add(slotframe->links_list, l);
+        struct tsch_link *prev = NULL;
+        struct tsch_link *next = list_head(slotframe->links_list);
+        /* Add the link to the slotframe, keeping the list sorted by timeslot */
+        while(next != NULL && next->timeslot < timeslot) {
+          prev = next;
+          next = list_item_next(next);
+        }
+        if(prev == NULL) {
+          list_push(slotframe->links_list, l);
+        } else {
+          list_insert(slotframe->links_list, prev, l);
+        }
+        slotframe->next_link_valid = 0;
         /* Initialize link */
         l->handle = current_link_handle++;
         l->link_options = link_options;
@@ -250,6 +265,7 @@ tsch_schedule_remove_link(struct tsch_slotframe *slotframe, struct tsch_link *l)
 
       list_remove(slotframe->links_list, l);
       memb_free(&link_memb, l);
+      slotframe->next_link_valid = 0;
 
       /* Release the lock before we update the neighbor (will take the lock) */
       tsch_release_lock();
@@ -287,31 +303,52 @@ tsch_schedule_get_link_from_timeslot(struct tsch_slotframe *slotframe, uint16_t
     if(slotframe != NULL) {
       struct tsch_link *l = list_head(slotframe->links_list);
       /* Loop over all items. Assume there is max one link per timeslot */
-      while(l != NULL) {
-        if(l->timeslot == timeslot) {
-          return l;
-        }
+      while(l != NULL && l->timeslot < timeslot) {
         l = list_item_next(l);
       }
-      return l;
+      if(l != NULL && l->timeslot == timeslot) {
+        return l;
+      }
     }
   }
   return NULL;
 }
+/* Moves the cursor of a slotframe to an ASN and returns its timeslot.
+ * next_link walks the sorted link list from where it stopped and restarts
+ * from the head only after a wrap or a schedule change */
+static uint16_t
+tsch_schedule_seek(struct tsch_slotframe *sf, struct asn_t *asn)
+{
+  uint16_t prev_timeslot = sf->offset.val;
+  uint32_t diff = ASN_DIFF(*asn, sf->offset.asn);
+  uint16_t timeslot = tsch_asn_offset(&sf->offset, asn, &sf->size);
+  if(!sf->next_link_valid || diff >= sf->size.val || timeslot < prev_timeslot) {
+    sf->next_link = list_head(sf->links_list);
+    sf->next_link_valid = 1;
+  }
+  while(sf->next_link != NULL && sf->next_link->timeslot < timeslot) {
+    sf->next_link = list_item_next(sf->next_link);
+  }
+  return timeslot;
+}
 /* Returns the link to be used at a given ASN */
 struct tsch_link *
 tsch_schedule_get_link_from_asn(struct asn_t *asn)
 {
   struct tsch_link *curr_best = NULL;
-  struct tsch_slotframe *sf = list_head(slotframe_list);
+  struct tsch_slotframe *sf;
+  if(tsch_is_locked()) {
+    return NULL;
+  }
+  sf = list_head(slotframe_list);
   /* For each slotframe, looks for a link matching the asn.
    * Tx links have priority, then lower handle have priority. */
   while(sf != NULL) {
     /* Get timeslot from ASN, given the slotframe length */
-    uint16_t timeslot = ASN_MOD(*asn, sf->size);
-    struct tsch_link *l = tsch_schedule_get_link_from_timeslot(sf, timeslot);
+    uint16_t timeslot = tsch_schedule_seek(sf, asn);
+    struct tsch_link *l = sf->next_link;
     /* We have a match */
-    if(l != NULL) {
+    if(l != NULL && l->timeslot == timeslot) {
       if(curr_best == NULL) {
         curr_best = l;
       } else {
@@ -352,9 +389,16 @@ tsch_schedule_get_next_active_link(struct asn_t *asn, uint16_t *time_offset)
     /* For each slotframe, look for the earliest occurring link */
     while(sf != NULL) {
       /* Get timeslot from ASN, given the slotframe length */
-      uint16_t timeslot = ASN_MOD(*asn, sf->size);
-      struct tsch_link *l = list_head(sf->links_list);
-      while(l != NULL) {
+      uint16_t timeslot = tsch_schedule_seek(sf, asn);
+      /* The first link after timeslot, or the first one of the next round */
+      struct tsch_link *l = sf->next_link;
+      if(l != NULL && l->timeslot == timeslot) {
+        l = list_item_next(l);
+      }
+      if(l == NULL) {
+        l = list_head(sf->links_list);
+      }
+      if(l != NULL) {
         uint16_t time_to_timeslot =
           l->timeslot > timeslot ?
           l->timeslot - timeslot :
@@ -363,7 +407,6 @@ tsch_schedule_get_next_active_link(struct asn_t *asn, uint16_t *time_offset)
           curr_earliest = time_to_timeslot;
           curr_earliest_link = l;
         }
-        l = list_item_next(l);
       }
       sf = list_item_next(sf);
     }
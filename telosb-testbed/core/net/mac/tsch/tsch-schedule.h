@@ -91,8 +91,14 @@ struct tsch_slotframe {
   /* Number of timeslots in the slotframe.
    * Stored as struct asn_divisor_t because we often need ASN%size */
   struct asn_divisor_t size;
-  /* List of links belonging to this slotframe */
+  /* List of links belonging to this slotframe, sorted by timeslot */
   LIST_STRUCT(links_list);
+  /* Timeslot at the ASN of the last lookup */
+  struct asn_offset_t offset;
+  /* First link at or after offset, NULL if none before the wrap.
+   * Reset when links are added or removed */
+  struct tsch_link *next_link;
+  uint8_t next_link_valid;
 };
 
 /* Initialization. Return 1 is success, 0 if failure. */
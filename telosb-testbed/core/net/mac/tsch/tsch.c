@@ -52,6 +52,7 @@
 #include "net/mac/tsch/tsch-log.h"
 #include "net/mac/tsch/tsch-packet.h"
 #include "net/mac/tsch/tsch-schedule.h"
+#include "net/mac/tsch/ctc-codebook.h"
 #include "net/mac/frame802154.h"
 #include "lib/random.h"
 #include "lib/ringbufindex.h"
@@ -124,6 +125,92 @@ void TSCH_CALLBACK_LEAVING_NETWORK();
 #define TSCH_EB_AUTOSELECT 0
 #endif /* TSCH_CONF_EB_AUTOSELECT */
 
+/* Log width and start of every downlink CTC pulse for the
+ * closed-loop encoder calibration of lora_control */
+#ifdef CTC_CONF_CALIBRATION
+#define CTC_CALIBRATION CTC_CONF_CALIBRATION
+#else
+#define CTC_CALIBRATION 0
+#endif /* CTC_CONF_CALIBRATION */
+
+/* Codebook of the ASN words in sync slots, see ctc-codebook.h.
+ * Must match CODEBOOK of lora_control */
+#ifdef CTC_CONF_CODEBOOK
+#define CTC_CODEBOOK CTC_CONF_CODEBOOK
+#else
+#define CTC_CODEBOOK ctc_cb_legacy
+#endif /* CTC_CONF_CODEBOOK */
+
+/* Time CTC pulses with CC2420 CCA edge interrupts instead of polling the
+ * RSSI register over SPI, needs platform support (CC2420_ENABLE_CCA_INT) */
+#ifdef CTC_CONF_CCA_CAPTURE
+#define CTC_CCA_CAPTURE CTC_CONF_CCA_CAPTURE
+#else
+#define CTC_CCA_CAPTURE 0
+#endif /* CTC_CONF_CCA_CAPTURE */
+
+#if CTC_CCA_CAPTURE && !defined(CC2420_ENABLE_CCA_INT)
+#error "CTC_CONF_CCA_CAPTURE: no CC2420 CCA interrupt on this platform"
+#endif
+
+/* Track the CTC RSSI threshold online: noise floor and pulse peak are
+ * averaged from every decoded slot, the threshold follows their midpoint */
+#ifdef CTC_CONF_RSST_ADAPTIVE
+#define CTC_RSST_ADAPTIVE CTC_CONF_RSST_ADAPTIVE
+#else
+#define CTC_RSST_ADAPTIVE 1
+#endif /* CTC_CONF_RSST_ADAPTIVE */
+
+/* Threshold range [dBm], change only by at least CTC_RSST_HYST [dB] and
+ * stay CTC_RSST_MARGIN [dB] above the noise floor */
+#define CTC_RSST_MIN -90
+#define CTC_RSST_MAX -60
+#define CTC_RSST_HYST 2
+#define CTC_RSST_MARGIN 4
+/* EWMA weight of a new observation: 1 / CTC_RSST_WEIGHT */
+#define CTC_RSST_WEIGHT 8
+/* RSSI reads of the boot survey */
+#define CTC_RSST_SURVEY 2000
+
+/* Decode downlink CTC slots as ctc_cb_downlink messages of lora_control */
+#ifdef CTC_CONF_DL_WORDS
+#define CTC_DL_WORDS CTC_CONF_DL_WORDS
+#else
+#define CTC_DL_WORDS 0
+#endif /* CTC_CONF_DL_WORDS */
+
+/* CTC resynchronisation: after a missed sync slot the search window grows
+ * by the drift two clocks of CTC_RESYNC_PPM can build up since the last
+ * sync. After CTC_RESYNC_FALLBACK misses the node stops slot operation and
+ * listens for the CTC bell for one bell period of CTC_CODEBOOK, then scans
+ * for EBs for CTC_RESYNC_EB_TIMEOUT, alternating until either syncs.
+ * Neighbors, RPL and Orchestra state are kept */
+#ifdef CTC_CONF_RESYNC_FALLBACK
+#define CTC_RESYNC_FALLBACK CTC_CONF_RESYNC_FALLBACK
+#else
+#define CTC_RESYNC_FALLBACK 4
+#endif /* CTC_CONF_RESYNC_FALLBACK */
+
+#ifdef CTC_CONF_RESYNC_PPM
+#define CTC_RESYNC_PPM CTC_CONF_RESYNC_PPM
+#else
+#define CTC_RESYNC_PPM 50
+#endif /* CTC_CONF_RESYNC_PPM */
+
+/* Search window of a tracked sync slot and upper bound while resyncing [us] */
+#define CTC_SYNC_WINDOW 15000
+#define CTC_RESYNC_MAX_WINDOW 30000
+#define CTC_RESYNC_MARGIN 500
+/* Seconds of EB scanning before listening for the bell again. Short, as
+ * CTC nodes send no EBs: it only finds a neighbor that still does */
+#ifdef CTC_CONF_RESYNC_EB_TIMEOUT
+#define CTC_RESYNC_EB_TIMEOUT CTC_CONF_RESYNC_EB_TIMEOUT
+#else
+#define CTC_RESYNC_EB_TIMEOUT 3
+#endif /* CTC_CONF_RESYNC_EB_TIMEOUT */
+/* Seconds of listening beyond one bell period before scanning for EBs */
+#define CTC_RESYNC_CTC_MARGIN 5
+
 #ifndef TSCH_802154_DUPLICATE_DETECTION
 #ifdef TSCH_CONF_802154_DUPLICATE_DETECTION
 #define TSCH_802154_DUPLICATE_DETECTION TSCH_CONF_802154_DUPLICATE_DETECTION
@@ -282,20 +369,33 @@ static volatile int tsch_locked = 0;
 /* As long as this is set, skip all link operation */
 static volatile int tsch_lock_requested = 0;
 
-uint8_t dlpkt[5] = {0};
+/* Downlink frame: magic, number of entries, (flow, seq high, seq low) per
+ * entry, checksum. One frame carries all pending flows of the child */
+#define DL_PKT_LEN(n) (3 + 3 * (n))
+#if N_FLOW > 8
+#error the downlink ACK bitmap has 8 bits
+#endif
+uint8_t dlpkt[DL_PKT_LEN(N_FLOW)] = {0};
 uint16_t flow_pending_seq[N_FLOW] = {0};
 
+/* Copy the application data at the end of the packetbuf, if any */
+static int ulpkt_app_data(struct app_data *data) {
+	if (packetbuf_datalen() < sizeof(struct app_data)) return 0;
+	memcpy(data, ((char*)packetbuf_dataptr() + packetbuf_datalen() - sizeof(struct app_data)), sizeof(struct app_data));
+	return data->magic == UIP_HTONL(LOG_MAGIC);
+}
+
 void log_ulpkt(char rxtx) {
 	struct app_data data;
 	uint16_t flowid, seqno;
-	memcpy(&data, ((char*)packetbuf_dataptr() + packetbuf_datalen() - sizeof(struct app_data)), sizeof(struct app_data));
-	if (data.magic != UIP_HTONL(LOG_MAGIC)) return;
+	if (!ulpkt_app_data(&data)) return;
 	flowid = UIP_HTONL(data.seqno) >> 16;
 	seqno = UIP_HTONL(data.seqno) & 0xffff;
 	if (node_id == 1) {
 		flow_pending_seq[flowid] = seqno;
 	}
-	printf("[ASN=%lu]\tUL-%cX (%u %u): [%u %u->%u]\n", current_asn.ls4b, rxtx, flowid, seqno, data.hop, UIP_HTONS(data.src), UIP_HTONS(data.dest));
+	tsch_evlog_add_process(rxtx == 'T' ? TSCH_EV_UL_TX : TSCH_EV_UL_RX, flowid, seqno,
+		((uint32_t)data.hop << 16) | ((UIP_HTONS(data.src) & 0xff) << 8) | (UIP_HTONS(data.dest) & 0xff));
 }
 
 /* Is TSCH locked? */
@@ -433,6 +533,33 @@ tsch_schedule_link_operation(struct rtimer *tm, rtimer_clock_t ref_time, rtimer_
     } \
   } while(0);
 
+/* Follow the ASN by addition while it advances by less than this many
+ * divisors, the 32-bit division is slow on 16-bit MCUs */
+#define TSCH_ASN_OFFSET_MAX_WRAPS 8
+
+/* Returns asn % div, advancing off from the ASN it was last computed for.
+ * Falls back to ASN_MOD if the ASN went back or jumped far ahead */
+uint16_t
+tsch_asn_offset(struct asn_offset_t *off, const struct asn_t *asn, const struct asn_divisor_t *div)
+{
+  uint32_t diff = ASN_DIFF(*asn, off->asn);
+  if(diff < ((uint32_t)div->val * TSCH_ASN_OFFSET_MAX_WRAPS)) {
+    uint16_t val = off->val;
+    while(diff >= div->val) {
+      diff -= div->val;
+    }
+    val += (uint16_t)diff;
+    if(val >= div->val) {
+      val -= div->val;
+    }
+    off->val = val;
+  } else {
+    off->val = ASN_MOD(*asn, *div);
+  }
+  off->asn = *asn;
+  return off->val;
+}
+
 /*
  * Channel hopping
  */
@@ -449,14 +576,40 @@ tsch_calculate_channel(struct asn_t *asn, uint8_t channel_offset)
 static void
 hop_channel(struct asn_t *asn, uint8_t offset)
 {
+  static struct asn_offset_t index_of_0;
+  uint16_t index_of_offset = (tsch_asn_offset(&index_of_0, asn, &hopping_sequence_length) + offset)
+      % hopping_sequence_length.val;
   current_channel = -1;
-  uint8_t channel = tsch_calculate_channel(asn, offset);
+  uint8_t channel = hopping_sequence_list[index_of_offset];
   if(current_channel != channel) {
     NETSTACK_RADIO_set_channel(channel);
     current_channel = channel;
   }
 }
 /*---------------------------------------------------------------------------*/
+/* Traffic class of the packet in packetbuf, and its relative deadline.
+ * Taken from the attributes 6LoWPAN sets once per datagram, never from the
+ * frame itself: all fragments of a datagram must share one class and
+ * deadline, or EDF reorders them and the receiver drops the datagram. */
+static uint8_t
+packet_class(uint16_t *deadline)
+{
+  uint16_t flow;
+  *deadline = 0;
+  /* Keepalives, ICMPv6 (RPL, ND) */
+  if(packetbuf_datalen() == 0
+      || packetbuf_attr(PACKETBUF_ATTR_NETWORK_ID) == UIP_PROTO_ICMP6) {
+    return TSCH_QUEUE_CLASS_CONTROL;
+  }
+  flow = packetbuf_attr(PACKETBUF_ATTR_APP_FLOW);
+  if(flow != 0) {
+    *deadline = TSCH_QUEUE_FLOW_DEADLINE(flow - 1);
+    return TSCH_QUEUE_CLASS_FLOW;
+  }
+  *deadline = TSCH_QUEUE_BEST_EFFORT_DEADLINE;
+  return TSCH_QUEUE_CLASS_BEST_EFFORT;
+}
+/*---------------------------------------------------------------------------*/
 /* Function send for TSCH-MAC, puts the packet in packetbuf in the MAC queue */
 static void
 send_packet(mac_callback_t sent, void *ptr)
@@ -464,6 +617,8 @@ send_packet(mac_callback_t sent, void *ptr)
   int ret = MAC_TX_DEFERRED;
   int packet_count_before;
   const linkaddr_t *addr = packetbuf_addr(PACKETBUF_ADDR_RECEIVER);
+  uint8_t tx_class;
+  uint16_t deadline;
 
   /*
   if(!associated) {
@@ -492,13 +647,14 @@ send_packet(mac_callback_t sent, void *ptr)
   packetbuf_set_attr(PACKETBUF_ATTR_MAC_SEQNO, tsch_packet_seqno);
 
   packet_count_before = tsch_queue_packet_count(addr);
+  tx_class = packet_class(&deadline);
 
   if(NETSTACK_FRAMER.create() < 0) {
     //LOGP("TSCH:! can't send packet due to framer error");
     ret = MAC_TX_ERR;
   } else {
     /* Enqueue packet */
-    if(!tsch_queue_add_packet(addr, sent, ptr)) {
+    if(!tsch_queue_add_packet(addr, tx_class, deadline, sent, ptr)) {
       LOGP("TSCH:! can't send packet !tsch_queue_add_packet");
       ret = MAC_TX_ERR;
     } else {
@@ -684,6 +840,7 @@ update_neighbor_state(struct tsch_neighbor *n, struct tsch_packet *p,
       /* Drop packet */
       tsch_queue_remove_packet_from_queue(n);
       in_queue = 0;
+      tsch_queue_stats[p->tx_class].tx_drops++;
     }
     /* Update CSMA state in the unicast case */
     if(is_unicast) {
@@ -696,6 +853,11 @@ update_neighbor_state(struct tsch_neighbor *n, struct tsch_packet *p,
     }
   }
 
+  if(!in_queue && p->tx_class != TSCH_QUEUE_CLASS_CONTROL
+      && (int16_t)((uint16_t)current_asn.ls4b - p->deadline) > 0) {
+    tsch_queue_stats[p->tx_class].late++;
+  }
+
   t0post_tx = RTIMER_NOW() - t0post_tx;
 
   return in_queue;
@@ -707,8 +869,13 @@ const int FR_LEN[] = {397, 31, 101, 103};
 //const int FR_LEN[] = {ORCHESTRA_EBSF_PERIOD, ORCHESTRA_COMMON_SHARED_PERIOD, ORCHESTRA_UNICAST_PERIOD, ORCHESTRA_UNICAST_PERIOD2};
 
 void current_slot(uint8_t *type, uint16_t *num) {
+	static struct asn_divisor_t fr_div[3];
+	static struct asn_offset_t fr_off[3]; //incremental current_asn % FR_LEN[]
+	if (!fr_div[0].val) for (*type = 0; *type < 3; (*type)++) {
+		ASN_DIVISOR_INIT(fr_div[*type], FR_LEN[*type]);
+	}
 	for (*type = 0; ; (*type)++) {
-		*num = current_asn.ls4b % FR_LEN[*type];
+		*num = tsch_asn_offset(&fr_off[*type], &current_asn, &fr_div[*type]);
 		if (*type == 2 || *num == 0) return;
 	}
 }
@@ -938,10 +1105,11 @@ PT_THREAD(tsch_tx_link(struct pt *pt, struct rtimer *t))
 extern uint8_t src_dst_flow[2];
 extern uint32_t dl_fwdflow_bitmap;
 extern uint8_t dl_slot_rx, dl_slot_tx[];
+extern uint8_t dl_flow_child[];
 extern const uint8_t dl_slot_0;
 
-const uint8_t DL_MAGIC = 0xEB;
-uint8_t dlack[1];
+const uint8_t DL_MAGIC = 0xEC; //aggregated frames, 0xEB was one flow per frame
+uint8_t dlack[2]; //checksum, bitmap of the entries taken
 
 static uint8_t wait_rx() {
 	rtimer_clock_t t0;
@@ -959,25 +1127,39 @@ static uint8_t checksum(uint8_t *dat, uint8_t len) {
 }
 
 static void downlink_rx() {
+	uint8_t ii, n, flow, *entry;
+	int len;
 	active_slots++;
 	on();
 	cc2420_address_decode(0);
 	NETSTACK_RADIO_set_channel(26);
 	if (!wait_rx()) goto END;
 	dlpkt[0] = 0;
-	NETSTACK_RADIO.read(dlpkt, sizeof(dlpkt));
+	len = NETSTACK_RADIO.read(dlpkt, sizeof(dlpkt));
 //	do {
 //		ok = NETSTACK_RADIO.read(dlpkt, sizeof(dlpkt)) && dlpkt[0] == DL_MAGIC;
 //	} while (!ok && ++cnt < 200); //RTIMER_NOW() < t0 + ((unsigned)US_TO_RTIMERTICKS(4000))
 	if (dlpkt[0] != DL_MAGIC) goto END;
-	if (dlpkt[4] != checksum(dlpkt, 4)) goto END;
-	if ((dl_fwdflow_bitmap >> dlpkt[1]) & 1);
-	else if (dlpkt[1] == src_dst_flow[1]);
-	else goto END;
-	dlack[0] = dlpkt[4];
+	n = dlpkt[1];
+	if (!n || n > N_FLOW || len < DL_PKT_LEN(n)) goto END;
+	if (dlpkt[DL_PKT_LEN(n) - 1] != checksum(dlpkt, DL_PKT_LEN(n) - 1)) goto END;
+	dlack[0] = dlpkt[DL_PKT_LEN(n) - 1];
+	dlack[1] = 0;
+	for (ii = 0, entry = &dlpkt[2]; ii < n; ii++, entry += 3) {
+		flow = entry[0];
+		if (flow >= N_FLOW) continue;
+		if ((dl_fwdflow_bitmap >> flow) & 1);
+		else if (flow == src_dst_flow[1]);
+		else continue;
+		dlack[1] |= 1 << ii;
+	}
+	if (!dlack[1]) goto END;
 	NETSTACK_RADIO.send(dlack, sizeof(dlack));
-	flow_pending_seq[dlpkt[1]] = ((uint16_t)dlpkt[2] << 8) | dlpkt[3];
-	printf("[ASN=%lu]\tDL-RX: [%u %u]\n", current_asn.ls4b, dlpkt[1], flow_pending_seq[dlpkt[1]]);
+	for (ii = 0, entry = &dlpkt[2]; ii < n; ii++, entry += 3) {
+		if (!((dlack[1] >> ii) & 1)) continue;
+		flow_pending_seq[entry[0]] = ((uint16_t)entry[1] << 8) | entry[2];
+		tsch_evlog_add(TSCH_EV_DL_RX, entry[0], flow_pending_seq[entry[0]], 0);
+	}
 END:
 	cc2420_address_decode(1);
 	off();
@@ -1006,62 +1188,153 @@ uint8_t dl_flow_sel(uint8_t slot_num) {
 	return 0xff;
 }
 
+/* Frame the pending flows that go to the same child in the same slot as
+ * flowid (all of the slot when receiver based). Returns the number of
+ * entries */
 uint8_t dlpkt_gen(uint8_t flowid) {
-	if (!flow_pending_seq[flowid]) return 0;
+	uint8_t ii, n, *entry;
+	for (ii = 0, n = 0, entry = &dlpkt[2]; ii < N_FLOW; ii++) {
+		if (!flow_pending_seq[ii]) continue;
+		if (dl_slot_tx[ii] != dl_slot_tx[flowid] || dl_flow_child[ii] != dl_flow_child[flowid]) continue;
+		*entry++ = ii;
+		*entry++ = flow_pending_seq[ii] >> 8;
+		*entry++ = flow_pending_seq[ii] & 0xff;
+		n++;
+	}
+	if (!n) return 0;
 	dlpkt[0] = DL_MAGIC;
-	dlpkt[1] = flowid;
-	dlpkt[2] = flow_pending_seq[flowid] >> 8;
-	dlpkt[3] = flow_pending_seq[flowid] & 0xff;
-	dlpkt[4] = checksum(dlpkt, 4);
-	return 1;
+	dlpkt[1] = n;
+	dlpkt[DL_PKT_LEN(n) - 1] = checksum(dlpkt, DL_PKT_LEN(n) - 1);
+	return n;
 }
 
 static void downlink_tx() {
-	uint8_t ok;
+	uint8_t ii, n, *entry;
+	uint16_t seq;
 	active_slots++;
 	on();
 	cc2420_address_decode(0);
 	NETSTACK_RADIO_set_channel(26);
 	//while (RTIMER_NOW() < t0 + ((unsigned)US_TO_RTIMERTICKS(2000)));//lock?
-	NETSTACK_RADIO.send(dlpkt, sizeof(dlpkt)); // == RADIO_TX_OK
-	if (!wait_rx()) { ok = 0; goto LOG; }
-	dlack[0] = 0;
-	NETSTACK_RADIO.read(dlack, sizeof(dlack));
+	n = dlpkt[1];
+	NETSTACK_RADIO.send(dlpkt, DL_PKT_LEN(n)); // == RADIO_TX_OK
+	dlack[0] = dlack[1] = 0;
+	if (wait_rx()) NETSTACK_RADIO.read(dlack, sizeof(dlack));
 //	do {
 //		ok = NETSTACK_RADIO.read(dlack, sizeof(dlack)) && dlack[0] == 0xBB;
 //	} while (!ok && RTIMER_NOW() < t0 + ((unsigned)US_TO_RTIMERTICKS(4000)));//lock?
-	ok = (dlack[0] == dlpkt[4]);
-	if (ok) flow_pending_seq[dlpkt[1]] = 0;
-LOG:
-	printf("[ASN=%lu]\tDL-TX: [%u %u]\t%s\n", current_asn.ls4b, dlpkt[1], ((uint16_t)dlpkt[2] << 8) | dlpkt[3], ok ? "OK" : "FAIL");
+	if (dlack[0] != dlpkt[DL_PKT_LEN(n) - 1]) dlack[1] = 0;
+	for (ii = 0, entry = &dlpkt[2]; ii < n; ii++, entry += 3) {
+		seq = ((uint16_t)entry[1] << 8) | entry[2];
+		if ((dlack[1] >> ii) & 1) {
+			if (flow_pending_seq[entry[0]] == seq) flow_pending_seq[entry[0]] = 0;
+		}
+		tsch_evlog_add(TSCH_EV_DL_TX, entry[0], seq, (dlack[1] >> ii) & 1);
+	}
 	cc2420_address_decode(1);
 	off();
 }
 
-const int8_t CTC_CODES = 11, CTC_SYNC_CODES = 4, CTC_SYNC_MINCODE = 7, CTC_SYNC_PERIOD = 8;
+const int8_t CTC_CODES = 11, CTC_SYNC_MINCODE = 7;
+static struct ctc_cb_rx ctc_sync_rx;
 static int ctc_rsst = -75; //-88; // rssi threshold
+static uint16_t ctc_width, ctc_start; //last pulse [us], start relative to t0
+static int ctc_peak; //rssi of the last pulse
+
+enum { CTC_TRACKING, CTC_REACQUIRE, CTC_EB_FALLBACK };
+static uint8_t ctc_state = CTC_TRACKING;
+static uint16_t ctc_window = CTC_SYNC_WINDOW; //upper edge search window [us]
+static int32_t ctc_shift; //ticks the slots are moved early to center the window
+static unsigned long ctc_sync_sec; //clock_seconds() of the last sync
+static uint32_t ctc_fr_offset; //sync frame of lora_control minus ours
+static uint8_t ctc_fr_known;
+
+#if CTC_RSST_ADAPTIVE
+static struct {
+	int16_t noise, peak; //averages, dBm * 16
+} ctc_est;
+
+static void ctc_rsst_seed(int noise, int peak) {
+	ctc_est.noise = noise * 16;
+	ctc_est.peak = peak * 16;
+}
 
-static int8_t ctc_decode(rtimer_clock_t t0) {
+/* Midpoint of the estimates, at least CTC_RSST_MARGIN above the noise and
+ * within [CTC_RSST_MIN, CTC_RSST_MAX] */
+static int16_t ctc_rsst_target() {
+	int16_t noise = ctc_est.noise / 16, target = (ctc_est.noise + ctc_est.peak) / 32;
+	if (target < noise + CTC_RSST_MARGIN) target = noise + CTC_RSST_MARGIN;
+	if (target < CTC_RSST_MIN) target = CTC_RSST_MIN;
+	if (target > CTC_RSST_MAX) target = CTC_RSST_MAX;
+	return target;
+}
+
+/* One observation per decoded slot: rssi after the pulse or timeout is
+ * noise, ctc_peak of a valid code is signal and of a too long pulse is
+ * interference */
+static void ctc_rsst_observe(int8_t code, int rssi) {
+	int16_t target;
+	if (code >= 0) ctc_est.peak += (ctc_peak * 16 - ctc_est.peak) / CTC_RSST_WEIGHT;
+	if (code == -3) rssi = ctc_peak;
+	ctc_est.noise += (rssi * 16 - ctc_est.noise) / CTC_RSST_WEIGHT;
+
+	target = ctc_rsst_target();
+	if (target - ctc_rsst < CTC_RSST_HYST && ctc_rsst - target < CTC_RSST_HYST) return;
+
+	ctc_rsst = target;
+	TSCH_LOG_ADD(tsch_log_message,
+		snprintf(log->message, sizeof(log->message),
+			"CTC rsst %d n %d p %d", ctc_rsst, ctc_est.noise / 16, ctc_est.peak / 16);
+	);
+}
+#endif /* CTC_RSST_ADAPTIVE */
+
+static int8_t ctc_pulse(rtimer_clock_t t0) {
 	uint32_t td, tb;
 	uint8_t cc, cond;
-	rtimer_clock_t tt;
+	rtimer_clock_t tt, te;
+#if !CTC_CCA_CAPTURE
+	int rssi;
+#endif
 	NETSTACK_RADIO_set_channel(26); //11~26
 	watchdog_stop();
 	
 	cond = 0;
+#if CTC_CCA_CAPTURE
+	cc2420_cca_capture_start(ctc_rsst);
+	BUSYWAIT_UNTIL_ABS ( //wait for upper edge
+		cond = (cc2420_cca_capture_read(NULL, NULL) > 0),
+		t0, (unsigned)US_TO_RTIMERTICKS(ctc_window)
+	);
+	ctc_width = ctc_start = 0;
+	if (!cond) { cc2420_cca_capture_stop(); return -1; } //no signal, timeout
+	ctc_peak = cc2420_rssi();
+	BUSYWAIT_UNTIL_ABS (
+		cc2420_cca_capture_read(NULL, NULL) == 2,
+		t0, (unsigned)US_TO_RTIMERTICKS(ctc_window + 2500)
+	); //wait for lower edge, also while not associated
+	te = RTIMER_NOW();
+	cc2420_cca_capture_read(&tt, &te); //edge times, te stays now on timeout
+	cc2420_cca_capture_stop();
+#else
 	BUSYWAIT_UNTIL_ABS ( //wait for upper edge
 		cond = (cc2420_rssi() >= ctc_rsst),
-		t0, (unsigned)US_TO_RTIMERTICKS(15000)
+		t0, (unsigned)US_TO_RTIMERTICKS(ctc_window)
 	);
+	ctc_width = ctc_start = 0;
 	if (!cond) return -1; //no signal, timeout
 	tt = RTIMER_NOW();
-	if (associated) BUSYWAIT_UNTIL_ABS (
-		cc2420_rssi() < ctc_rsst,
-		t0, (unsigned)US_TO_RTIMERTICKS(17500)
-	); //wait for lower edge
-	else while (cc2420_rssi() >= ctc_rsst);
+	ctc_peak = ctc_rsst;
+	BUSYWAIT_UNTIL_ABS (
+		(rssi = cc2420_rssi()) < ctc_rsst || ((ctc_peak = rssi > ctc_peak ? rssi : ctc_peak), 0),
+		t0, (unsigned)US_TO_RTIMERTICKS(ctc_window + 2500)
+	); //wait for lower edge, also while not associated
+	te = RTIMER_NOW();
+#endif
 
-	td = RTIMERTICKS_TO_US(RTIMER_NOW() - tt);
+	td = RTIMERTICKS_TO_US(te - tt);
+	ctc_width = td > 0xffff ? 0xffff : td;
+	ctc_start = RTIMERTICKS_TO_US(tt - t0);
 	if (td < 2000) return -2; //pulse too short
 	if (td > 6000) return -3; //pulse too long
 	tb = 2350; //upper bound of shortest pulse
@@ -1072,6 +1345,57 @@ static int8_t ctc_decode(rtimer_clock_t t0) {
 	return CTC_CODES - 1; //default long pattern
 }
 
+static int8_t ctc_decode(rtimer_clock_t t0) {
+	int8_t code = ctc_pulse(t0);
+#if CTC_RSST_ADAPTIVE
+	ctc_rsst_observe(code, cc2420_rssi());
+#endif
+	return code;
+}
+
+#if CTC_RSST_ADAPTIVE
+/* Seed the threshold estimator from a short RSSI survey instead of a
+ * threshold sweep: the init signal of lora_control shows as the samples
+ * above the midpoint of min and max, without it the threshold starts
+ * CTC_RSST_MARGIN above the floor and ctc_decode() adapts it later */
+static uint8_t ctc_init() {
+	int16_t rssi, rs_min, rs_max, mid;
+	int32_t sum_low, sum_high;
+	uint16_t cnt, cnt_high;
+	uint8_t cnt_miss, found;
+	rtimer_clock_t t0;
+	watchdog_stop();
+	rs_min = 0; rs_max = -128;
+	for (cnt = 0; cnt < CTC_RSST_SURVEY; cnt++) {
+		rssi = cc2420_rssi();
+		if (rssi < rs_min) rs_min = rssi;
+		if (rssi > rs_max) rs_max = rssi;
+	}
+	mid = (rs_min + rs_max) / 2;
+	sum_low = sum_high = 0; cnt_high = 0;
+	for (cnt = 0; cnt < CTC_RSST_SURVEY; cnt++) {
+		rssi = cc2420_rssi();
+		if (rssi > mid) { sum_high += rssi; cnt_high++; }
+		else sum_low += rssi;
+	}
+	found = rs_max - rs_min >= 4 * CTC_RSST_MARGIN && cnt_high && cnt_high < CTC_RSST_SURVEY;
+	if (found) {
+		ctc_rsst_seed(sum_low / (CTC_RSST_SURVEY - cnt_high), sum_high / cnt_high);
+	} else {
+		printf("* No CTC init signal. Adapting threshold from noise floor.\n");
+		ctc_rsst_seed(mid, mid + 2 * CTC_RSST_MARGIN);
+	}
+	ctc_rsst = ctc_rsst_target();
+	printf("* ctc_rsst = %d (noise %d, peak %d)\n", ctc_rsst, ctc_est.noise / 16, ctc_est.peak / 16);
+	for (cnt_miss = 0; found && cnt_miss < 20;) {
+		t0 = RTIMER_NOW();
+		if (ctc_decode(t0) < CTC_SYNC_MINCODE)
+			cnt_miss++;
+		else cnt_miss = 0;
+	}
+	return found;
+}
+#else
 static uint8_t ctc_init() {
 	int16_t rsth, rsth_min, rsth_max;
 	uint8_t cnt_low, cnt_high, cnt_miss, cnt_valid;//[40]
@@ -1115,65 +1439,151 @@ static uint8_t ctc_init() {
 	printf("* noise ratio = %lu / %lu\n", cnt_noise, cnt);
 	return 1;
 }
+#endif /* CTC_RSST_ADAPTIVE */
+
+/* Decode one pulse of the sync window: *code keeps the latest valid code,
+ * or the latest error while no valid code was seen */
+static int8_t ctc_sync_decode(rtimer_clock_t t0, int8_t *code) {
+	int8_t got = ctc_decode(t0);
+	if (got >= 0 || *code < 0) *code = got;
+	return got;
+}
 
-static int8_t ctc_sync(uint32_t *p_asn) {
-	static uint32_t sync_index = 0;
-	int8_t ii, code, code_buf[5];
+/* lock: only the bell is a sync, used while the ASN is unknown, the data
+ * codes of a dense codebook are also sent in APP slots */
+static int8_t ctc_sync(uint32_t *p_asn, uint8_t lock) {
+	int8_t code, min_code;
+	uint32_t word;
+	int ret;
 	rtimer_clock_t t0;
 	t0 = RTIMER_NOW();
-	ii = 0;
+	code = -1; //no pulse decoded
+	min_code = lock ? CTC_CODEBOOK.codes - 1 : CTC_CODEBOOK.min_code;
 	BUSYWAIT_UNTIL_ABS (
-		(code_buf[ii++] = ctc_decode(t0)) >= CTC_SYNC_MINCODE,
-		t0, (unsigned)US_TO_RTIMERTICKS(15000)
+		ctc_sync_decode(t0, &code) >= min_code,
+		t0, (unsigned)US_TO_RTIMERTICKS(ctc_window)
 	);
-	do {
-		if ((code = code_buf[--ii]) >= 0) break;
-	} while (ii);
+	if (lock && code >= 0 && code < min_code) return 0; //no bell
+	if (!ctc_sync_rx.cb) ctc_cb_rx_init(&ctc_sync_rx, &CTC_CODEBOOK);
+	ret = ctc_cb_rx_push(&ctc_sync_rx, code, &word); //errors are erasures of the word
 	if (code < 0) return code; //missed sync
-	if (code < CTC_SYNC_MINCODE) return 0; //blurry sync
-	if (code == CTC_CODES - 1) {
-		if (p_asn) *p_asn = sync_index * CTC_SYNC_PERIOD * FR_LEN[0];
-		sync_index = 0;
+	if (code < CTC_CODEBOOK.min_code) return 0; //blurry sync
+	if (ret == CTC_CB_WORD) {
+		if (p_asn) *p_asn = word * ctc_cb_period(&CTC_CODEBOOK) * FR_LEN[0];
 		return 1; //sync with asn complete
 	}
-	sync_index *= CTC_SYNC_CODES - 1;
-	sync_index += code - CTC_SYNC_MINCODE;
+	if (ret == CTC_CB_BELL) return 3; //sync at a word boundary
 	return 2; //sync with asn pending
 }
 
+/* Slots the pulse was off by whole slots are ASN, not drift */
+static void ctc_slot_resync() {
+	int32_t half = TsSlotDuration / 2;
+	int16_t slots = 0;
+	while (estimated_drift > half) { estimated_drift -= TsSlotDuration; slots++; }
+	while (estimated_drift < -half) { estimated_drift += TsSlotDuration; slots--; }
+	if (!slots) return;
+	if (slots > 0) {
+		ASN_INC(current_asn, slots);
+	} else {
+		ASN_DEC(current_asn, -slots);
+	}
+	printf("* CTC-Resync %d slots\n", slots);
+}
+
+/* Sync frames the ASN is off, from the sync word (sync_state 1) or the bell
+ * (sync_state 3) of lora_control. The offset of its frame number is learnt
+ * from the first word, a later word checks the frame, a bell the frame
+ * modulo the word period */
+static int16_t ctc_frame_error(int8_t sync_state, uint32_t asn_update) {
+	uint32_t period = ctc_cb_period(&CTC_CODEBOOK);
+	uint32_t mod = period * ctc_cb_capacity(&CTC_CODEBOOK);
+	uint32_t fr = ((current_asn.ls4b + FR_LEN[0] / 2) / FR_LEN[0]) % mod, err;
+	if (sync_state == 1) {
+		fr = (asn_update / FR_LEN[0] + mod - fr) % mod;
+		err = (fr + mod - ctc_fr_offset) % mod;
+		if (ctc_fr_known && (err <= period || mod - err <= period)) //else: lora_control restarted
+			return err <= period ? (int16_t)err : -(int16_t)(mod - err);
+		ctc_fr_offset = fr;
+		ctc_fr_known = 1;
+		return 0;
+	}
+	if (sync_state != 3 || !ctc_fr_known) return 0;
+	err = (fr + ctc_fr_offset) % period;
+	if (!err) return 0;
+	return err > period / 2 ? (int16_t)(period - err) : -(int16_t)err;
+}
+
+/* Widen the search window by the drift since the last sync and move the
+ * slots early by half of the widening */
+static void ctc_widen_window() {
+	uint32_t drift_us, window;
+	int32_t shift;
+	drift_us = (uint32_t)ASN_DIFF(current_asn, last_sync_asn) * CTC_RESYNC_PPM
+		* (RTIMERTICKS_TO_US(TsSlotDuration) / 1000) / 1000 + CTC_RESYNC_MARGIN;
+	window = CTC_SYNC_WINDOW + 2 * drift_us;
+	if (window > CTC_RESYNC_MAX_WINDOW) window = CTC_RESYNC_MAX_WINDOW;
+	ctc_window = window;
+	shift = US_TO_RTIMERTICKS((window - CTC_SYNC_WINDOW) / 2);
+	drift_correction = ctc_shift - shift;
+	ctc_shift = shift;
+}
+
 static void ctc_keep_sync() {
 	uint32_t asn_update;
 	int32_t drift_us;
+	int16_t frames;
 	int8_t sync_state;
 	static uint8_t cnt_miss = 0;
 	active_slots++;
 	on();
-	sync_state = ctc_sync(&asn_update);
+	sync_state = ctc_sync(&asn_update, 0);
 	rx_start_time = RTIMER_NOW() - US_TO_RTIMERTICKS(12000) + TsTxOffset;
 	off();
 	if (sync_state >= 0) {
-		last_sync_asn = current_asn;
-		estimated_drift = ((int32_t)expected_rx_time - (int32_t)rx_start_time);
+		estimated_drift = (signed short)(expected_rx_time - rx_start_time);
+		ctc_slot_resync();
 		drift_correction = -estimated_drift;
+		frames = ctc_frame_error(sync_state, asn_update);
+		if (frames > 0) {
+			ASN_INC(current_asn, frames * FR_LEN[0]);
+		} else if (frames < 0) {
+			ASN_DEC(current_asn, -frames * FR_LEN[0]);
+		}
+		if (frames) tsch_evlog_add(TSCH_EV_CTC_RESYNC, 0, 0, frames);
+		if (ctc_state != CTC_TRACKING) tsch_evlog_add(TSCH_EV_CTC_REACQUIRED, 0, 0, cnt_miss);
+		last_sync_asn = current_asn;
+		ctc_sync_sec = clock_seconds();
+		ctc_state = CTC_TRACKING;
+		ctc_window = CTC_SYNC_WINDOW;
+		ctc_shift = 0;
+		cnt_miss = 0;
 	}
 	tsch_schedule_keepalive();
 	
 	drift_us = RTIMERTICKS_TO_US(estimated_drift);
-	printf("* %s Drift = %ld us\n", drift_us > 2500 || drift_us < -2500 ? "Large" : "Est.", drift_us);
-	printf("* Duty Cycle = %ld / %ld\n", active_slots, current_asn.ls4b);
+	tsch_evlog_add(TSCH_EV_CTC_DRIFT, 0, 0, drift_us);
+	tsch_evlog_add(TSCH_EV_CTC_DUTY, 0, 0, active_slots);
 	if (sync_state < 0) {
-		printf("* CTC-Sync missed (%d)\n", sync_state);
-		printf("* Last-Sync ASN = %ld\n", last_sync_asn.ls4b);
-		if (++cnt_miss == 5) {
-			printf("* CTC-Sync corrupted !\n");
-			for (;;);
+		tsch_evlog_add(TSCH_EV_CTC_MISS, sync_state, 0, last_sync_asn.ls4b);
+		if (++cnt_miss >= CTC_RESYNC_FALLBACK) {
+			tsch_evlog_add(TSCH_EV_CTC_LOST, 0, 0, 0);
+			ctc_state = CTC_EB_FALLBACK;
+			ctc_window = CTC_SYNC_WINDOW;
+			ctc_shift = 0;
+			cnt_miss = 0;
+			associated = 0;
+			process_post(&tsch_process, PROCESS_EVENT_POLL, NULL);
+			return;
 		}
+		ctc_state = CTC_REACQUIRE;
+		ctc_widen_window();
+		tsch_evlog_add(TSCH_EV_CTC_WINDOW, 0, 0, ctc_window);
 		return;
 	}
 	if (sync_state == 1) {
-		printf("* ASN update = %lu\n", asn_update);
+		tsch_evlog_add(TSCH_EV_CTC_ASN_UPDATE, 0, 0, asn_update);
 	}
-	cnt_miss = 0;
 }
 
 static void ctc_dlrx() {
@@ -1184,8 +1594,42 @@ static void ctc_dlrx() {
 	on();
 	code = ctc_decode(t0);
 	off();
+#if CTC_CALIBRATION
+	tsch_evlog_add(TSCH_EV_CTC_CAL, code, ctc_width, ctc_start);
+	return;
+#endif
+#if CTC_DL_WORDS
+	{
+		static struct ctc_cb_rx dl_rx;
+		static uint32_t header; //pending header word, 0: none
+		static uint8_t last_seq[CTC_DL_MAX_FLOWS]; //seqno + 1 of the last message per flow
+		uint32_t word;
+		uint8_t flow, seq;
+		int ret;
+		if (!dl_rx.cb) ctc_cb_rx_init(&dl_rx, &ctc_cb_downlink);
+		ret = ctc_cb_rx_push(&dl_rx, code, &word);
+		if (ret == CTC_CB_ERROR) {
+			if (header) tsch_evlog_add(TSCH_EV_DL_CTC_LOST, CTC_DL_FLOW(header), 0, 0);
+			header = 0;
+			return;
+		}
+		if (ret != CTC_CB_WORD) return;
+		if (word >= CTC_DL_HEADER) { //a new header drops an incomplete message
+			header = word;
+			return;
+		}
+		if (!header) return; //command without header
+		flow = CTC_DL_FLOW(header);
+		seq = CTC_DL_SEQ(header);
+		header = 0;
+		if (last_seq[flow] == seq + 1) return; //repetition
+		last_seq[flow] = seq + 1;
+		tsch_evlog_add(TSCH_EV_DL_CTC, flow, seq, word);
+		return;
+	}
+#endif
 	if (code < 4 || code > 6) return;
-	printf("[ASN=%lu]\tDL-CTC: OK\n", current_asn.ls4b);
+	tsch_evlog_add(TSCH_EV_DL_CTC_OK, 0, 0, 0);
 }
 
 static
@@ -1449,8 +1893,15 @@ PT_THREAD(tsch_link_operation(struct rtimer *t, void *ptr))
                 "! leaving the network, last sync %u\n",
                           (unsigned)ASN_DIFF(current_asn, last_sync_asn));
       );
+#if WITH_CTC
+      ctc_state = CTC_EB_FALLBACK;
+#endif
       associated = 0;
       process_post(&tsch_process, PROCESS_EVENT_POLL, NULL);
+#if WITH_CTC
+    } else if(!associated) {
+      /* CTC sync lost in this slot, tsch_process resynchronizes */
+#endif
     } else {
       /* backup of drift correction for printing debug messages */
       /* int32_t drift_correction_backup = drift_correction; */
@@ -1508,10 +1959,11 @@ static void ctc_first_sync() {
 	uint32_t sync_asn = 0;
 	on();
 	ctc_init();
-	while (ctc_sync(&sync_asn) <= 0); //== 1
+	while (ctc_sync(&sync_asn, 1) <= 0); //== 3
 	current_link_start = RTIMER_NOW() - US_TO_RTIMERTICKS(15000);
 	ASN_INIT(current_asn, 0, /*sync_asn +*/ 133); //133: unknown offset
 	last_sync_asn = current_asn;
+	ctc_sync_sec = clock_seconds();
 	//tsch_schedule_keepalive();
 	tsch_join_priority = 0;
 	associated = 1;
@@ -1520,6 +1972,40 @@ static void ctc_first_sync() {
 	printf("* CTC synced %ld s after boot\n* ASN = 0\n", clock_seconds());
 }
 
+/* Seconds of listening for the bell before an EB scan: the bell is sent
+ * once per ctc_cb_period() sync frames */
+static unsigned long ctc_resume_timeout() {
+	return (uint32_t)ctc_cb_period(&CTC_CODEBOOK) * FR_LEN[0]
+		* (RTIMERTICKS_TO_US(TsSlotDuration) / 1000) / 1000 + CTC_RESYNC_CTC_MARGIN;
+}
+
+/* Reacquire CTC sync without EBs, one search window per call so that
+ * tsch_associate() can yield in between. The threshold of ctc_init() is
+ * kept, the ASN is extrapolated to the sync frame nearest to the time since
+ * the last sync so the schedule stays aligned with the neighbors. Returns 1
+ * once the bell was heard */
+static uint8_t ctc_resume_sync() {
+	uint32_t frame_ms, frames;
+	on();
+	ctc_window = CTC_RESYNC_MAX_WINDOW;
+	if (ctc_sync(NULL, 1) <= 0) {
+		off();
+		return 0;
+	}
+	ctc_window = CTC_SYNC_WINDOW;
+	current_link_start = RTIMER_NOW() - US_TO_RTIMERTICKS(12000);
+	frame_ms = FR_LEN[0] * (RTIMERTICKS_TO_US(TsSlotDuration) / 1000);
+	frames = ((clock_seconds() - ctc_sync_sec) * 1000 + frame_ms / 2) / frame_ms;
+	ASN_INIT(current_asn, 0, (last_sync_asn.ls4b / FR_LEN[0] + frames) * FR_LEN[0]);
+	last_sync_asn = current_asn;
+	ctc_sync_sec = clock_seconds();
+	ctc_state = CTC_TRACKING;
+	associated = 1;
+	off();
+	printf("* CTC resynced after %lu frames\n* ASN = %lu\n", frames, current_asn.ls4b);
+	return 1;
+}
+
 
 /* Associate:
  * If we are a master, start right away.
@@ -1533,7 +2019,15 @@ PT_THREAD(tsch_associate(struct pt *pt))
   ASN_INIT(current_asn, 0, 0);
 
 #if WITH_CTC
-	ctc_first_sync();
+	static unsigned long resync_deadline;
+	static uint8_t ctc_listen;
+	if (ctc_state == CTC_EB_FALLBACK) {
+		/* CTC nodes send no EBs, listen for the bell first */
+		ctc_listen = 1;
+		resync_deadline = clock_seconds() + ctc_resume_timeout();
+	} else {
+		ctc_first_sync();
+	}
 	tsch_is_coordinator = 0;
 #endif
 
@@ -1615,6 +2109,21 @@ PT_THREAD(tsch_associate(struct pt *pt))
         }
 #endif
 
+#if WITH_CTC
+        if(eb_parsed != 0 && ctc_state == CTC_EB_FALLBACK) {
+          /* Timing and ASN only, the neighbor stays a plain neighbor and
+           * the next sync slot hands over to CTC again */
+          last_sync_asn = current_asn;
+          ctc_sync_sec = clock_seconds();
+          current_link_start = t0 - TsTxOffset;
+          tsch_join_priority = 0;
+          ctc_state = CTC_TRACKING;
+          associated = 1;
+          printf("* EB resynced\n* ASN = %lu\n", current_asn.ls4b);
+          eb_parsed = 0;
+        }
+#endif
+
         if(eb_parsed != 0 && tsch_join_priority < TSCH_MAX_JOIN_PRIORITY) {
           struct tsch_neighbor *n;
 
@@ -1652,9 +2161,27 @@ PT_THREAD(tsch_associate(struct pt *pt))
         }
       }
 
+#if WITH_CTC
+      if(!associated && ctc_listen && !ctc_resume_sync()
+          && clock_seconds() >= resync_deadline) {
+        /* No bell within one bell period, scan for EBs for a while */
+        ctc_listen = 0;
+        resync_deadline = clock_seconds() + CTC_RESYNC_EB_TIMEOUT;
+      } else if(!associated && !ctc_listen && clock_seconds() >= resync_deadline) {
+        ctc_listen = 1;
+        resync_deadline = clock_seconds() + ctc_resume_timeout();
+      }
+#endif
+
       if(associated) {
         /* End of association turn the radio off */
         off();
+#if WITH_CTC
+      } else if(ctc_listen) {
+        /* Next search window as soon as the other processes ran */
+        process_poll(&tsch_process);
+        PT_YIELD(pt);
+#endif
       } else {
         etimer_reset(&associate_timer);
         PT_WAIT_UNTIL(pt, etimer_expired(&associate_timer));
@@ -1711,6 +2238,16 @@ PROCESS_THREAD(tsch_process, ev, data)
     /* Resynchronize */
     LOG("TSCH: will re-synchronize\n");
     off();
+#if WITH_CTC
+    if(ctc_state == CTC_EB_FALLBACK) {
+      /* Only the timing is lost: keep neighbors, queues and the
+       * RPL and Orchestra state */
+      current_link = NULL;
+      current_packet = NULL;
+      current_neighbor = NULL;
+      continue;
+    }
+#endif
     tsch_reset();
   }
 
@@ -1923,7 +2460,7 @@ PROCESS_THREAD(tsch_send_eb_process, ev, data)
         if(eb_len != 0) {
           packetbuf_set_datalen(eb_len);
           /* Enqueue EB packet */
-          if(!tsch_queue_add_packet(&tsch_eb_address, NULL, NULL)) {
+          if(!tsch_queue_add_packet(&tsch_eb_address, TSCH_QUEUE_CLASS_CONTROL, 0, NULL, NULL)) {
 //            LOG("TSCH:! could not enqueue EB packet\n");
           } else {
 //            LOG("TSCH: enqueue EB packet\n");
@@ -1996,6 +2533,7 @@ tsch_init(void)
   tsch_queue_init();
   tsch_schedule_init();
   tsch_log_init();
+  tsch_packet_update_templates();
   ringbufindex_init(&input_ringbuf, TSCH_MAX_INCOMING_PACKETS);
   ringbufindex_init(&dequeued_ringbuf, DEQUEUED_ARRAY_SIZE);
   ASN_DIVISOR_INIT(hopping_sequence_length, TSCH_N_CHANNELS);
@@ -39,6 +39,7 @@
 #include "lib/memb.h"
 #include "lib/list.h"
 #include "net/nbr-table.h"
+#include "net/linkaddr-index.h"
 
 /* List of link-layer addresses of the neighbors, used as key in the tables */
 typedef struct nbr_table_key {
@@ -61,6 +62,8 @@ static unsigned num_tables;
 /* The neighbor address table */
 MEMB(neighbor_addr_mem, nbr_table_key_t, NBR_TABLE_MAX_NEIGHBORS);
 LIST(nbr_table_keys);
+/* Hash index of the keys, by link-layer address */
+LINKADDR_INDEX(nbr_table_index, NBR_TABLE_MAX_NEIGHBORS);
 
 /*---------------------------------------------------------------------------*/
 /* Get a key from a neighbor index */
@@ -109,20 +112,12 @@ key_from_item(nbr_table_t *table, const nbr_table_item_t *item)
 static int
 index_from_lladdr(const linkaddr_t *lladdr)
 {
-  nbr_table_key_t *key;
   /* Allow lladdr-free insertion, useful e.g. for IPv6 ND.
    * Only one such entry is possible at a time, indexed by linkaddr_null. */
   if(lladdr == NULL) {
     lladdr = &linkaddr_null;
   }
-  key = list_head(nbr_table_keys);
-  while(key != NULL) {
-    if(lladdr && linkaddr_cmp(lladdr, &key->lladdr)) {
-      return index_from_key(key);
-    }
-    key = list_item_next(key);
-  }
-  return -1;
+  return linkaddr_index_get(&nbr_table_index, lladdr);
 }
 /*---------------------------------------------------------------------------*/
 /* Get bit from "used" or "locked" bitmap */
@@ -216,8 +211,9 @@ nbr_table_allocate(void)
       }
       /* Empty used map */
       used_map[index_from_key(least_used_key)] = 0;
-      /* Remove neighbor from list */
+      /* Remove neighbor from list and index */
       list_remove(nbr_table_keys, least_used_key);
+      linkaddr_index_remove(&nbr_table_index, index_from_key(least_used_key));
       /* Return associated key */
       return least_used_key;
     }
@@ -230,6 +226,10 @@ int
 nbr_table_register(nbr_table_t *table, nbr_table_callback *callback)
 {
   if(num_tables < MAX_NUM_TABLES) {
+    if(num_tables == 0) {
+      linkaddr_index_init(&nbr_table_index, neighbor_addr_mem.mem,
+                          sizeof(nbr_table_key_t), offsetof(nbr_table_key_t, lladdr));
+    }
     table->index = num_tables++;
     table->callback = callback;
     all_tables[table->index] = table;
@@ -298,6 +298,7 @@ nbr_table_add_lladdr(nbr_table_t *table, const linkaddr_t *lladdr)
 
     /* Set link-layer address */
     linkaddr_copy(&key->lladdr, lladdr);
+    linkaddr_index_add(&nbr_table_index, index);
   }
 
   /* Get item in the current table */
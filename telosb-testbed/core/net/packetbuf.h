@@ -341,6 +341,7 @@ enum {
 #ifndef WITHOUT_6LOWPAN_ATTR
   PACKETBUF_ATTR_CHANNEL,
   PACKETBUF_ATTR_NETWORK_ID,
+  PACKETBUF_ATTR_APP_FLOW,
 #endif /* WITHOUT_6LOWPAN_ATTR */
 #ifndef WITHOUT_ATTR_LINK_QUALITY
   PACKETBUF_ATTR_LINK_QUALITY,
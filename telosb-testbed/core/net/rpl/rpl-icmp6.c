@@ -85,6 +85,15 @@ void RPL_DEBUG_DIO_INPUT(uip_ipaddr_t *, rpl_dio_t *);
 void RPL_DEBUG_DAO_OUTPUT(rpl_parent_t *);
 #endif
 
+/* application-defined DIO options: output returns the bytes written */
+#ifdef RPL_CALLBACK_DIO_OPTION_OUTPUT
+int RPL_CALLBACK_DIO_OPTION_OUTPUT(uint8_t *buffer, int max_len);
+#endif
+
+#ifdef RPL_CALLBACK_DIO_OPTION_INPUT
+void RPL_CALLBACK_DIO_OPTION_INPUT(const uint8_t *option, int len);
+#endif
+
 static uint8_t dao_sequence = RPL_LOLLIPOP_INIT;
 
 extern rpl_of_t RPL_OF;
@@ -417,6 +426,9 @@ dio_input(void)
       memcpy(&dio.prefix_info.prefix, &buffer[i + 16], 16);
       break;
     default:
+#ifdef RPL_CALLBACK_DIO_OPTION_INPUT
+      RPL_CALLBACK_DIO_OPTION_INPUT(&buffer[i], len);
+#endif
       PRINTF("RPL: Unsupported suboption type in DIO: %u\n",
 	(unsigned)subopt_type);
     }
@@ -556,6 +568,11 @@ dio_output(rpl_instance_t *instance, uip_ipaddr_t *uc_addr)
            dag->prefix_info.length);
   }
 
+#ifdef RPL_CALLBACK_DIO_OPTION_OUTPUT
+  pos += RPL_CALLBACK_DIO_OPTION_OUTPUT(&buffer[pos],
+      UIP_BUFSIZE - UIP_LLH_LEN - UIP_IPICMPH_LEN - pos);
+#endif
+
   LOG("RPL: DIO output to %d, rank %u\n", LOG_NODEID_FROM_IPADDR(uc_addr), (unsigned)instance->current_dag->rank);
 
 #if RPL_LEAF_ONLY
@@ -52,9 +52,19 @@ ISR(CC2420_IRQ, cc2420_port1_interrupt)
 {
   ENERGEST_ON(ENERGEST_TYPE_IRQ);
 
+#ifdef CC2420_ENABLE_CCA_INT
+  /* CCA and FIFOP share the port interrupt */
+  if(CC2420_CCA_INT_PENDING()) {
+    cc2420_cca_interrupt();
+  }
+  if(CC2420_FIFOP_INT_PENDING() && cc2420_interrupt()) {
+    LPM4_EXIT;
+  }
+#else /* CC2420_ENABLE_CCA_INT */
   if(cc2420_interrupt()) {
     LPM4_EXIT;
   }
+#endif /* CC2420_ENABLE_CCA_INT */
 
   ENERGEST_OFF(ENERGEST_TYPE_IRQ);
 }
@@ -1227,3 +1227,87 @@ cc2420_get_interrupt_enable(void)
 {
 	return interrupt_enabled;
 }
+
+#ifdef CC2420_ENABLE_CCA_INT
+/* CCA edge capture. The CCA pin is high while the channel is clear, so a
+ * signal above the threshold is the time from the falling to the rising
+ * edge. Edges are timestamped with RTIMER_NOW() in the port interrupt. */
+static volatile rtimer_clock_t cca_edge_time[2];
+static volatile uint8_t cca_edges;
+
+/* Store one edge and arm the next one, called with interrupts disabled */
+static void
+cca_capture_edge(void)
+{
+	cca_edge_time[cca_edges++] = RTIMER_NOW();
+	if(cca_edges == 2) {
+		CC2420_DISABLE_CCA_INT();
+		CC2420_CLEAR_CCA_INT();
+		return;
+	}
+	CC2420_CCA_INT_RISING();
+	CC2420_CLEAR_CCA_INT();
+	/* Signal already gone while switching the edge */
+	if(CC2420_CCA_IS_1) {
+		cca_capture_edge();
+	}
+}
+
+/* Start capturing the next signal above threshold [dBm], radio must be on */
+void
+cc2420_cca_capture_start(int threshold)
+{
+	int s;
+
+	GET_LOCK();
+	setreg(CC2420_RSSI, (uint16_t)((threshold - RSSI_OFFSET) & 0xff) << 8);
+	wait_for_status(BV(CC2420_RSSI_VALID));
+	RELEASE_LOCK();
+
+	s = splhigh();
+	cca_edges = 0;
+	CC2420_CCA_INT_FALLING();
+	CC2420_CLEAR_CCA_INT();
+	CC2420_ENABLE_CCA_INT();
+	/* Channel already busy: the signal starts now */
+	if(!CC2420_CCA_IS_1) {
+		cca_capture_edge();
+	}
+	splx(s);
+}
+
+/* Number of captured edges (0..2), start and end times of the signal */
+uint8_t
+cc2420_cca_capture_read(rtimer_clock_t *start, rtimer_clock_t *end)
+{
+	uint8_t n = cca_edges;
+	if(n > 0 && start) {
+		*start = cca_edge_time[0];
+	}
+	if(n > 1 && end) {
+		*end = cca_edge_time[1];
+	}
+	return n;
+}
+
+/* Stop capturing and restore the default CCA threshold */
+void
+cc2420_cca_capture_stop(void)
+{
+	CC2420_DISABLE_CCA_INT();
+	CC2420_CLEAR_CCA_INT();
+	cc2420_set_cca_threshold(CC2420_CONF_CCA_THRESH);
+}
+
+/* CCA edge interrupt, called from the port interrupt of the arch driver */
+void
+cc2420_cca_interrupt(void)
+{
+	if(cca_edges < 2) {
+		cca_capture_edge();
+	} else {
+		CC2420_DISABLE_CCA_INT();
+		CC2420_CLEAR_CCA_INT();
+	}
+}
+#endif /* CC2420_ENABLE_CCA_INT */
@@ -113,6 +113,15 @@ void cc2420_set_interrupt_enable(uint8_t e);
 /* Get radio interrupt enable status */
 uint8_t cc2420_get_interrupt_enable(void);
 
+#ifdef CC2420_ENABLE_CCA_INT
+/* Timestamp the CCA edges of the next signal above threshold [dBm]
+ * instead of polling the RSSI register, see cc2420.c */
+void cc2420_cca_capture_start(int threshold);
+uint8_t cc2420_cca_capture_read(rtimer_clock_t *start, rtimer_clock_t *end);
+void cc2420_cca_capture_stop(void);
+void cc2420_cca_interrupt(void);
+#endif /* CC2420_ENABLE_CCA_INT */
+
 /************************************************************************/
 /* Generic names for special functions */
 /************************************************************************/
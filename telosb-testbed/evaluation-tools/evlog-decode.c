@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "evlog.h"
+
+// Decoder of the TSCH event log records ("@" + 16 base64 characters, see
+// core/net/mac/tsch/tsch-log.c).
+//   evlog-decode <log>: print the log with the records as text
+//   evlog-decode <flow> <src log> <root log> <dst log>: write the flow-eval
+//   inputs UL-TX.csv, UL-RX.csv, DL-RX.csv and DL-CTC.csv of a flow
+
+// same text as the firmware prints without TSCH_EVLOG
+void print(FILE *fp, const struct Event *ev) {
+	switch (ev->type) {
+	case UL_TX:
+	case UL_RX:
+		fprintf(fp, "[ASN=%u]\tUL-%cX (%u %u): [%u %u->%u]\n", ev->asn, ev->type == UL_TX ? 'T' : 'R',
+			ev->flow, ev->seq, (ev->arg >> 16) & 0xff, (ev->arg >> 8) & 0xff, ev->arg & 0xff);
+		break;
+	case DL_RX:
+		fprintf(fp, "[ASN=%u]\tDL-RX: [%u %u]\n", ev->asn, ev->flow, ev->seq);
+		break;
+	case DL_TX:
+		fprintf(fp, "[ASN=%u]\tDL-TX: [%u %u]\t%s\n", ev->asn, ev->flow, ev->seq, ev->arg ? "OK" : "FAIL");
+		break;
+	case DL_CTC:
+		fprintf(fp, "[ASN=%u]\tDL-CTC: flow %u seq %u cmd %u\n", ev->asn, ev->flow, ev->seq, ev->arg);
+		break;
+	case DL_CTC_LOST:
+		fprintf(fp, "[ASN=%u]\tDL-CTC: flow %u lost\n", ev->asn, ev->flow);
+		break;
+	case DL_CTC_OK:
+		fprintf(fp, "[ASN=%u]\tDL-CTC: OK\n", ev->asn);
+		break;
+	case CTC_CAL:
+		fprintf(fp, "[ASN=%u]\tCTC-CAL: %d %u %u\n", ev->asn, (int8_t)ev->flow, ev->seq, ev->arg);
+		break;
+	case CTC_DRIFT:
+		fprintf(fp, "* %s Drift = %d us\n", (int32_t)ev->arg > 2500 || (int32_t)ev->arg < -2500 ? "Large" : "Est.", (int32_t)ev->arg);
+		break;
+	case CTC_DUTY:
+		fprintf(fp, "* Duty Cycle = %u / %u\n", ev->arg, ev->asn);
+		break;
+	case CTC_MISS:
+		fprintf(fp, "* CTC-Sync missed (%d)\n* Last-Sync ASN = %u\n", (int8_t)ev->flow, ev->arg);
+		break;
+	case CTC_LOST:
+		fprintf(fp, "* CTC-Sync lost, EB fallback\n");
+		break;
+	case CTC_WINDOW:
+		fprintf(fp, "* CTC-Sync window = %u us\n", ev->arg);
+		break;
+	case CTC_RESYNC:
+		fprintf(fp, "* CTC-Resync %d frames\n", (int32_t)ev->arg);
+		break;
+	case CTC_REACQUIRED:
+		fprintf(fp, "* CTC-Sync reacquired after %u misses\n", ev->arg);
+		break;
+	case CTC_ASN_UPDATE:
+		fprintf(fp, "* ASN update = %u\n", ev->arg);
+		break;
+	case DROPPED:
+		fprintf(fp, "TSCH:! events dropped %u\n", ev->arg);
+		break;
+	}
+}
+
+FILE *openfile(char *filename, char *mode) {
+	FILE *fp = fopen(filename, mode);
+	if (!fp) {
+		printf("[error] %s: can't open\n", filename);
+		exit(2);
+	}
+	return fp;
+}
+
+void decode(char *filename) {
+	char line[512], *p;
+	struct Event ev;
+	FILE *fp = openfile(filename, "r");
+	while (fgets(line, sizeof(line), fp)) {
+		if (!(p = parse(line, &ev))) {
+			fputs(line, stdout);
+			continue;
+		}
+		*p = '\0'; //keep the line prefix of the testbed
+		fputs(line, stdout);
+		print(stdout, &ev);
+	}
+	fclose(fp);
+}
+
+// write "asn,seq" (or "asn" if !with_seq) of the given event types of a flow
+void extract(char *logname, char *csvname, uint8_t flow, uint32_t types, int with_seq) {
+	char line[512];
+	struct Event ev;
+	FILE *fp = openfile(logname, "r");
+	FILE *out = openfile(csvname, "w");
+	while (fgets(line, sizeof(line), fp)) {
+		if (!parse(line, &ev) || !((types >> ev.type) & 1)) continue;
+		if (ev.type != DL_CTC_OK && ev.flow != flow) continue;
+		if (with_seq) fprintf(out, "%u,%u\n", ev.asn, ev.seq);
+		else fprintf(out, "%u\n", ev.asn);
+	}
+	fclose(fp);
+	fclose(out);
+}
+
+int main(int argn, char *argv[]) {
+	unsigned flow;
+	if (argn == 2) {
+		decode(argv[1]);
+		return 0;
+	}
+	if (argn != 5 || sscanf(argv[1], "%u", &flow) != 1 || flow > 0xff) {
+		printf("usage: %s <log>\n", argv[0]);
+		printf("       %s <flow> <src log> <root log> <dst log>\n", argv[0]);
+		return 1;
+	}
+	extract(argv[2], "UL-TX.csv", flow, 1 << UL_TX, 1);
+	extract(argv[3], "UL-RX.csv", flow, 1 << UL_RX, 1);
+	extract(argv[4], "DL-RX.csv", flow, 1 << DL_RX, 1);
+	extract(argv[4], "DL-CTC.csv", flow, 1 << DL_CTC | 1 << DL_CTC_OK, 0);
+	return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef EVLOG_H
+#define EVLOG_H
+
+#include <stdint.h>
+#include <string.h>
+
+// TSCH event log records ("@" + 16 base64 characters, see
+// core/net/mac/tsch/tsch-log.c)
+
+// keep in sync with enum tsch_evlog_type in tsch-log.h
+enum EvType {UL_TX, UL_RX, DL_RX, DL_TX, DL_CTC, DL_CTC_LOST, DL_CTC_OK,
+	CTC_CAL, CTC_DRIFT, CTC_DUTY, CTC_MISS, CTC_LOST, CTC_WINDOW,
+	CTC_RESYNC, CTC_REACQUIRED, CTC_ASN_UPDATE, DROPPED};
+
+struct Event {
+	uint8_t type, flow;
+	uint16_t seq;
+	uint32_t asn, arg;
+};
+
+#define REC_LEN 16 //base64 characters of a record
+
+static int b64val(char c) {
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+// find a record in a line, returns its position or NULL
+static char *parse(char *line, struct Event *ev) {
+	uint8_t raw[12];
+	int ii, jj, v[4];
+	char *p, *end;
+	for (p = strchr(line, '@'); p; p = strchr(p + 1, '@')) {
+		end = p + 1 + REC_LEN;
+		if ((int)strlen(p + 1) < REC_LEN || (*end && *end != '\r' && *end != '\n')) continue;
+		for (ii = jj = 0; ii < REC_LEN; ii += 4) {
+			for (int kk = 0; kk < 4; kk++) {
+				if ((v[kk] = b64val(p[1 + ii + kk])) < 0) goto NEXT;
+			}
+			raw[jj++] = v[0] << 2 | v[1] >> 4;
+			raw[jj++] = v[1] << 4 | v[2] >> 2;
+			raw[jj++] = v[2] << 6 | v[3];
+		}
+		ev->type = raw[0];
+		ev->flow = raw[1];
+		ev->seq = raw[2] << 8 | raw[3];
+		ev->asn = (uint32_t)raw[4] << 24 | raw[5] << 16 | raw[6] << 8 | raw[7];
+		ev->arg = (uint32_t)raw[8] << 24 | raw[9] << 16 | raw[10] << 8 | raw[11];
+		if (ev->type > DROPPED) continue;
+		return p;
+NEXT:;
+	}
+	return NULL;
+}
+#endif
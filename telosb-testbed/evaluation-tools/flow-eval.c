@@ -1,142 +1,376 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
-#include <assert.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// End-to-end evaluation of the uplink/downlink flows of testbed runs.
+// A run is a directory with UL-TX.csv, UL-RX.csv, DL-RX.csv ("asn,seq" or
+// "asn,seq,flow" lines) and with -c DL-CTC.csv ("asn" or "asn,flow").
+// The files are merged by ASN and streamed, only a window of seqnos per
+// flow is kept, so the memory does not grow with the length of the run.
+// 16 bit seqnos are unwrapped. Runs are evaluated in parallel (-j).
+//   gcc -O2 -pthread -o flow-eval flow-eval.c
+
+#define SLOT_MS 15
+#define HIST_LEN 8192 //latency histogram in slots, longer ones go to the last bin
+#define MAX_FLOWS 256
+
+enum Transmissions {CTC, UT, UR, DR, N_TRANS}; //order of events with the same ASN
+
+const char *trans_file[N_TRANS] = {"DL-CTC.csv", "UL-TX.csv", "UL-RX.csv", "DL-RX.csv"};
 
 int8_t  EN_CTC;
-int32_t MINSEQ, MAXSEQ;
+int32_t MINSEQ = 0, MAXSEQ = INT32_MAX, SEGLEN = 100, WINDOW = 1024;
+int8_t  JSON;
 
-void readfile(char *filename, int32_t *asn_seq) {
-	int32_t asn, seq, seq_last, asn_last;
-	int res;
-	FILE *fp;
-	fp = fopen(filename, "r");
-	if (!fp) {
-		printf("[error] %s: can't open\n", filename);
-		exit(2);
-	}
-	seq_last = asn_last = 0;
-	do {
-		do {
-			res = fscanf(fp, "%d,%d", &asn, &seq);
-			if (res < 2 || seq > 0xfffe || seq < seq_last || asn < asn_last) {
-				printf("[error] %s: seq=%d\n", filename, seq_last);
-				exit(3);
-			}
-		} while (seq == seq_last);
-		seq_last = seq;
-		asn_last = asn;
-		asn_seq[seq] = asn;
-	} while (seq < MAXSEQ);
-	fclose(fp);
+struct Pkt {
+	int32_t ut, ur, dr, bell, deliv; //ASNs, 0: none
+	uint8_t valid;
+};
+
+struct Stats {
+	int32_t att, scs;
+	int32_t seg_att, seg_scs;
+	double pdrsegmin, pdrsegmax;
+	int64_t laten_ee, laten_dl;
+	int32_t latmin, latmax;
+	uint32_t hist[HIST_LEN];
+};
+
+struct Flow {
+	struct Pkt *win; //WINDOW packets from seq base on
+	int64_t base, top;
+	int64_t awaiting; //last seq received by the root, -1: none
+	uint16_t last_raw[N_TRANS];
+	int64_t last_seq[N_TRANS]; //unwrapped
+	int8_t started[N_TRANS];
+	struct Stats st;
+};
+
+struct Run {
+	char *dir;
+	struct Flow *flow[MAX_FLOWS];
+	struct Stats all;
+	char error[1200];
+};
+
+void stats_init(struct Stats *st) {
+	memset(st, 0, sizeof(*st));
+	st->pdrsegmin = 2.0;
+	st->pdrsegmax = -1.0;
+	st->latmin = INT32_MAX;
 }
 
-/*
-void readfile_DR(char *filename, int32_t *asn_seq) {
-	int32_t asn, seq, seq_last, asn_last;
-	int res;
-	FILE *fp;
-	fp = fopen(filename, "r");
-	if (!fp) {
-		printf("[error] %s: can't open\n", filename);
-		exit(2);
-	}
-	seq_last = asn_last = 0;
-	do {
-		do {
-			res = fscanf(fp, "%d,%d", &asn, &seq);
-			if (res < 2 || seq > 0xfffe || seq < seq_last || asn < asn_last) {
-				printf("[error] %s: seq=%d\n", filename, seq_last);
-				exit(3);
-			}
-		} while (seq == seq_last);
-		seq_last = seq;
-		asn_last = asn;
-		asn_seq[seq] = asn;
-	} while (seq < 59);
-	fclose(fp);
+struct Flow *flow_get(struct Run *run, uint8_t id) {
+	struct Flow *f = run->flow[id];
+	if (f) return f;
+	f = calloc(1, sizeof(*f));
+	if (f) f->win = calloc(WINDOW, sizeof(*f->win));
+	if (!f || !f->win) {
+		fprintf(stderr, "[error] out of memory\n");
+		exit(4);
+	}
+	f->awaiting = -1;
+	f->base = MINSEQ;
+	f->top = MINSEQ;
+	stats_init(&f->st);
+	run->flow[id] = f;
+	return f;
 }
-*/
 
-enum Transmissions {UT, UR, DR, N_TRANS};
+void segment_end(struct Stats *st) {
+	double pdr = (double)st->seg_scs / st->seg_att;
+	if (pdr < st->pdrsegmin) st->pdrsegmin = pdr;
+	if (pdr > st->pdrsegmax) st->pdrsegmax = pdr;
+	st->seg_att = st->seg_scs = 0;
+}
 
-int main(int argn, char *argv[]) {
-	int32_t asn_ctc, asn_ctc_last, asn_dr;
-	int32_t seq, att, scs;
-	int32_t asn[N_TRANS][0xffff] = {0};
-	int64_t laten_ee, laten_dl, laten_seg;
-	uint16_t seglen, scsseg, scssegmin = -1, scssegmax = 0;
-	double latseg, latsegmin = 1e10, latsegmax = 0.0;
-	int res;
-	FILE *fp_ctc;
-	if (argn != 5) {
-		printf("usage: %s <CTC:0/1> <SEGLEN (pkts)> <MINSEQ> <MAXSEQ>\n", argv[0]);
+// account the packet at the base of the window and move on
+void finalize(struct Flow *f) {
+	struct Pkt *p = &f->win[f->base % WINDOW];
+	struct Stats *st = &f->st;
+	int32_t lat;
+	if (!p->deliv) p->deliv = p->dr; //the CTC confirmation was not for it
+	if (p->valid && p->ut) {
+		st->att++;
+		st->seg_att++;
+		if (p->ur && p->deliv) {
+			lat = p->deliv - p->ut;
+			st->scs++;
+			st->seg_scs++;
+			st->laten_ee += lat;
+			st->laten_dl += p->deliv - p->ur;
+			if (lat < st->latmin) st->latmin = lat;
+			if (lat > st->latmax) st->latmax = lat;
+			st->hist[lat < 0 ? 0 : lat < HIST_LEN ? lat : HIST_LEN - 1]++;
+		}
+		if (st->seg_att == SEGLEN) segment_end(st);
+	}
+	memset(p, 0, sizeof(*p));
+	if (f->awaiting == f->base) f->awaiting = -1;
+	f->base++;
+}
+
+// the packet seq in the window, NULL if it is out of it
+struct Pkt *slot(struct Flow *f, int64_t seq, int8_t create) {
+	struct Pkt *p;
+	if (seq < f->base || seq < MINSEQ || seq >= MAXSEQ) return NULL;
+	if (seq >= f->base + WINDOW) {
+		if (!create) return NULL;
+		if (seq >= f->top + WINDOW) { //nothing in the window to keep
+			while (f->base < f->top) finalize(f);
+			f->base = f->top = seq - WINDOW + 1;
+		}
+		while (seq >= f->base + WINDOW) finalize(f);
+	}
+	p = &f->win[seq % WINDOW];
+	if (!p->valid && !create) return NULL;
+	p->valid = 1;
+	if (seq >= f->top) f->top = seq + 1;
+	return p;
+}
+
+// 16 bit seqno to the closest one of the stream so far
+int64_t unwrap(struct Flow *f, int8_t trans, uint16_t raw) {
+	int16_t diff = raw - f->last_raw[trans];
+	int64_t seq = f->last_seq[trans] + diff;
+	if (!f->started[trans]) {
+		f->started[trans] = 1;
+		seq = raw;
+	}
+	else if (diff <= 0) return seq;
+	f->last_raw[trans] = raw;
+	f->last_seq[trans] = seq;
+	return seq;
+}
+
+void event(struct Run *run, int8_t trans, int32_t asn, uint16_t raw, uint8_t flowid) {
+	struct Flow *f = flow_get(run, flowid);
+	struct Pkt *p;
+	int64_t seq;
+	struct Pkt *prev;
+	if (trans == CTC) { //first confirmation after the root received the packet
+		p = f->awaiting < 0 ? NULL : slot(f, f->awaiting, 0);
+		if (p && !p->bell && !p->deliv) p->bell = asn;
+		return;
+	}
+	seq = unwrap(f, trans, raw);
+	p = slot(f, seq, trans == UT);
+	if (trans == UR && EN_CTC && seq > f->awaiting) {
+		// the confirmation counts for the previous packet if the root got
+		// this one next, otherwise it falls back to the downlink packet
+		prev = f->awaiting < 0 ? NULL : slot(f, f->awaiting, 0);
+		if (prev && !prev->deliv) prev->deliv = f->awaiting == seq - 1 && prev->bell ? prev->bell : prev->dr;
+		f->awaiting = seq;
+	}
+	if (!p) return;
+	switch (trans) {
+	case UT:
+		if (!p->ut) p->ut = asn;
+		break;
+	case UR:
+		if (!p->ut || p->ur) break;
+		p->ur = asn;
+		break;
+	case DR:
+		if (!p->ur || p->dr) break;
+		p->dr = asn;
+		if (!p->bell) p->deliv = asn; //a later confirmation would not be earlier
+		break;
+	}
+	while (f->base < f->top && f->win[f->base % WINDOW].deliv) finalize(f);
+}
+
+struct Input {
+	FILE *fp;
+	int32_t asn;
+	uint16_t seq;
+	uint8_t flow;
+	int8_t eof;
+};
+
+int input_next(struct Run *run, struct Input *in, int8_t trans) {
+	char line[128];
+	int asn, seq = 0, flow = 0, res;
+	while (fgets(line, sizeof(line), in->fp)) {
+		if (trans == CTC) res = sscanf(line, "%d,%d", &asn, &flow) + 1;
+		else res = sscanf(line, "%d,%d,%d", &asn, &seq, &flow);
+		if (res < 2) continue;
+		if (asn < in->asn || seq < 0 || seq > 0xffff || flow < 0 || flow >= MAX_FLOWS) {
+			snprintf(run->error, sizeof(run->error), "%s/%s: ASN %d seq %d flow %d", run->dir, trans_file[trans], asn, seq, flow);
+			return -1;
+		}
+		in->asn = asn;
+		in->seq = seq;
+		in->flow = flow;
 		return 1;
 	}
-	sscanf(argv[1], "%hhd", &EN_CTC);
-	sscanf(argv[2], "%hd", &seglen);
-	sscanf(argv[3], "%d", &MINSEQ);
-	sscanf(argv[4], "%d", &MAXSEQ);
-	readfile("UL-TX.csv", asn[UT]);
-	readfile("UL-RX.csv", asn[UR]);
-	readfile("DL-RX.csv", asn[DR]);
-	//printf("file loaded\n");
-	if (EN_CTC) fp_ctc = fopen("DL-CTC.csv", "r");
-	att = scs = 0; scsseg = 0;
-	asn_dr = asn_ctc = asn_ctc_last = 0;
-	laten_ee = laten_dl = laten_seg = 0;
-	for (seq = MINSEQ; seq < MAXSEQ; seq++) {
-		if (!asn[UT][seq]) continue;
-		//printf("seq=%d\n", seq);
-		att++;
-		if (att > seglen && att % seglen == 1) {
-			if (!scsseg) printf("seq %d, pdr 0.00, lat -\n", seq);
-			else {
-				latseg = (double)laten_seg * 15 / scsseg;
-				if (scsseg < scssegmin) scssegmin = scsseg;
-				if (scsseg > scssegmax) scssegmax = scsseg;
-				if (latseg < latsegmin) latsegmin = latseg;
-				if (latseg > latsegmax) latsegmax = latseg;
-				printf("seq %d, pdr %f, lat %.2f ms\n", seq, (float)scsseg / seglen, latseg);
-				scsseg = 0;
-				laten_seg = 0;
-			}
+	in->eof = 1;
+	return 0;
+}
+
+void merge_hist(struct Stats *to, const struct Stats *from) {
+	int ii;
+	to->att += from->att;
+	to->scs += from->scs;
+	to->laten_ee += from->laten_ee;
+	to->laten_dl += from->laten_dl;
+	if (from->latmin < to->latmin) to->latmin = from->latmin;
+	if (from->latmax > to->latmax) to->latmax = from->latmax;
+	if (from->pdrsegmin < to->pdrsegmin) to->pdrsegmin = from->pdrsegmin;
+	if (from->pdrsegmax > to->pdrsegmax) to->pdrsegmax = from->pdrsegmax;
+	for (ii = 0; ii < HIST_LEN; ii++) to->hist[ii] += from->hist[ii];
+}
+
+void evaluate(struct Run *run) {
+	struct Input in[N_TRANS];
+	char path[1024];
+	int ii, next;
+	memset(in, 0, sizeof(in));
+	stats_init(&run->all);
+	for (ii = EN_CTC ? CTC : UT; ii < N_TRANS; ii++) {
+		snprintf(path, sizeof(path), "%s/%s", run->dir, trans_file[ii]);
+		if (!(in[ii].fp = fopen(path, "r"))) {
+			snprintf(run->error, sizeof(run->error), "%s: can't open", path);
+			goto END;
 		}
-		//printf("att=%d\n", att);
-		if (!asn[UR][seq]) continue;
-		if (!EN_CTC) goto NO_CTC;
-		while (asn_ctc <= asn[UR][seq]) {
-			res = fscanf(fp_ctc, "%d", &asn_ctc);
-			if (res < 1 || asn_ctc < asn_ctc_last) {
-				printf("[error] DL-CTC: ASN = %d\n", asn_ctc);
-				exit(3);
-			}
+		if (input_next(run, &in[ii], ii) < 0) goto END;
+	}
+	if (!EN_CTC) in[CTC].eof = 1;
+	while (1) { //merge the streams by ASN
+		for (ii = 0, next = -1; ii < N_TRANS; ii++) {
+			if (in[ii].eof) continue;
+			if (next < 0 || in[ii].asn < in[next].asn) next = ii;
 		}
-		asn_ctc_last = asn_ctc;
-		if (asn_ctc <= asn[UR][seq+1]) {
-			asn_dr = (asn[DR][seq] && asn[DR][seq] < asn_ctc) ? asn[DR][seq] : asn_ctc;
+		if (next < 0) break;
+		event(run, next, in[next].asn, in[next].seq, in[next].flow);
+		if (input_next(run, &in[next], next) < 0) goto END;
+	}
+	for (ii = 0; ii < MAX_FLOWS; ii++) {
+		struct Flow *f = run->flow[ii];
+		if (!f) continue;
+		while (f->base < f->top) finalize(f);
+		merge_hist(&run->all, &f->st);
+	}
+END:
+	for (ii = 0; ii < N_TRANS; ii++) {
+		if (in[ii].fp) fclose(in[ii].fp);
+	}
+}
+
+double percentile(const struct Stats *st, double q) {
+	uint64_t sum = 0, rank = (uint64_t)(q * st->scs + 0.5);
+	int ii;
+	if (rank < 1) rank = 1;
+	for (ii = 0; ii < HIST_LEN; ii++) {
+		sum += st->hist[ii];
+		if (sum >= rank) return (double)ii * SLOT_MS;
+	}
+	return (double)st->latmax * SLOT_MS;
+}
+
+void report(const struct Run *run, const char *flow, const struct Stats *st, int first) {
+	double pdr = st->att ? (double)st->scs / st->att : 0.0;
+	if (JSON) {
+		printf("%s\n  {\"run\": \"%s\", \"flow\": \"%s\", \"attempts\": %d, \"delivered\": %d, \"pdr\": %f",
+			first ? "" : ",", run->dir, flow, st->att, st->scs, pdr);
+		if (st->pdrsegmax >= 0) printf(", \"pdr_seg_min\": %f, \"pdr_seg_max\": %f", st->pdrsegmin, st->pdrsegmax);
+		if (st->scs) {
+			printf(", \"lat_ms\": {\"min\": %.2f, \"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"max\": %.2f, \"avg\": %.2f}",
+				(double)st->latmin * SLOT_MS, percentile(st, 0.5), percentile(st, 0.9), percentile(st, 0.99),
+				(double)st->latmax * SLOT_MS, (double)st->laten_ee * SLOT_MS / st->scs);
+			printf(", \"dl_lat_ms_avg\": %.2f", (double)st->laten_dl * SLOT_MS / st->scs);
 		}
-		else {
-NO_CTC:
-			if (!asn[DR][seq]) continue;
-			asn_dr = asn[DR][seq];
+		printf("}");
+		return;
+	}
+	printf("%s,%s,%d,%d,%f,", run->dir, flow, st->att, st->scs, pdr);
+	if (st->pdrsegmax >= 0) printf("%f,%f,", st->pdrsegmin, st->pdrsegmax);
+	else printf(",,");
+	if (st->scs) {
+		printf("%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+			(double)st->latmin * SLOT_MS, percentile(st, 0.5), percentile(st, 0.9), percentile(st, 0.99),
+			(double)st->latmax * SLOT_MS, (double)st->laten_ee * SLOT_MS / st->scs,
+			(double)st->laten_dl * SLOT_MS / st->scs);
+	}
+	else printf(",,,,,,\n");
+}
+
+struct Run *runs;
+int n_runs, next_run;
+pthread_mutex_t run_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void *worker(void *arg) {
+	int ii;
+	while (1) {
+		pthread_mutex_lock(&run_lock);
+		ii = next_run++;
+		pthread_mutex_unlock(&run_lock);
+		if (ii >= n_runs) return NULL;
+		evaluate(&runs[ii]);
+	}
+}
+
+void usage(char *name) {
+	printf("usage: %s [-c] [-l SEGLEN] [-s MINSEQ] [-e MAXSEQ] [-w WINDOW] [-j JOBS] [-J] <run dir>...\n", name);
+	printf("  -c  CTC downlink confirmations (DL-CTC.csv)\n");
+	printf("  -l  packets per PDR segment (%d)\n", SEGLEN);
+	printf("  -s, -e  seqno range [MINSEQ, MAXSEQ) of the evaluation, unwrapped\n");
+	printf("  -w  seqnos kept open per flow (%d)\n", WINDOW);
+	printf("  -j  runs evaluated in parallel (cores)\n");
+	printf("  -J  JSON instead of CSV\n");
+	exit(1);
+}
+
+int main(int argn, char *argv[]) {
+	pthread_t *threads;
+	char name[8];
+	int opt, jobs, ii, jj, first, ret = 0;
+	jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	while ((opt = getopt(argn, argv, "cl:s:e:w:j:J")) != -1) {
+		switch (opt) {
+		case 'c': EN_CTC = 1; break;
+		case 'l': SEGLEN = atoi(optarg); break;
+		case 's': MINSEQ = atoi(optarg); break;
+		case 'e': MAXSEQ = atoi(optarg); break;
+		case 'w': WINDOW = atoi(optarg); break;
+		case 'j': jobs = atoi(optarg); break;
+		case 'J': JSON = 1; break;
+		default: usage(argv[0]);
 		}
-		laten_ee += asn_dr - asn[UT][seq];
-		laten_dl += asn_dr - asn[UR][seq];
-		laten_seg += asn_dr - asn[UT][seq];
-		//printf("seq %d, ee %d, dl %d\n", seq, asn_dr - asn[UT][seq], asn_dr - asn[UR][seq]);
-		scs++;
-		scsseg++;
-		//printf("scsseg=%d\n", scsseg);
-	}
-	if (EN_CTC) fclose(fp_ctc);
-	fflush(stdout);
-	printf("- - - - - - - - - -\n");
-	assert(seglen);
-	assert(att);
-	assert(scs);
-	printf("PDR[min,max,overall] = %f,%f,%f (%d/%d)\n", (float)scssegmin / seglen, (float)scssegmax / seglen, (double)scs / att, scs, att);
-	printf("Latency[min,max,avg] = %.2f,%.2f,%.2f (ms)\n", latsegmin, latsegmax, (double)laten_ee * 15 / scs);
-	//printf("Downlink Latency (mean) = %.2lf ms\n", (double)laten_dl * 15 / scs);
-	return 0;
+	}
+	if (optind >= argn || SEGLEN < 1 || WINDOW < 2 || MINSEQ < 0 || MAXSEQ <= MINSEQ) usage(argv[0]);
+	n_runs = argn - optind;
+	if (jobs < 1) jobs = 1;
+	if (jobs > n_runs) jobs = n_runs;
+	runs = calloc(n_runs, sizeof(*runs));
+	threads = calloc(jobs, sizeof(*threads));
+	if (!runs || !threads) {
+		fprintf(stderr, "[error] out of memory\n");
+		return 4;
+	}
+	for (ii = 0; ii < n_runs; ii++) runs[ii].dir = argv[optind + ii];
+	for (ii = 0; ii < jobs; ii++) pthread_create(&threads[ii], NULL, worker, NULL);
+	for (ii = 0; ii < jobs; ii++) pthread_join(threads[ii], NULL);
+	if (JSON) printf("[");
+	else printf("run,flow,attempts,delivered,pdr,pdr_seg_min,pdr_seg_max,lat_min,lat_p50,lat_p90,lat_p99,lat_max,lat_avg,dl_lat_avg\n");
+	for (ii = 0, first = 1; ii < n_runs; ii++) {
+		if (runs[ii].error[0]) {
+			fprintf(stderr, "[error] %s\n", runs[ii].error);
+			ret = 3;
+			continue;
+		}
+		for (jj = 0; jj < MAX_FLOWS; jj++) {
+			if (!runs[ii].flow[jj]) continue;
+			snprintf(name, sizeof(name), "%d", jj);
+			report(&runs[ii], name, &runs[ii].flow[jj]->st, first);
+			first = 0;
+		}
+		report(&runs[ii], "all", &runs[ii].all, first);
+		first = 0;
+	}
+	if (JSON) printf("\n]\n");
+	return ret;
 }
@@ -0,0 +1,322 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "evlog.h"
+
+// Single-pass ingester of serialdump logs (text lines or event log records).
+// Indexes the Duty Cycle, UL-TX, DL-RX, Drift and CTC-Sync missed events by
+// node and ASN and writes time series with one row per checkpoint interval:
+//   PREFIXduty.csv: checkpoint,node,active,asn,duty
+//     first Duty Cycle sample in [checkpoint, checkpoint + WINDOW)
+//   PREFIXevents.csv: from,to,node,ul_tx,dl_rx,ctc_miss,drift_n,drift_avg_us,drift_max_us
+//     events with ASN in [from, to)
+// The node is the "ID:<n>" prefix of a line if there is one, the log file
+// name otherwise. Logs are read in parallel (-j).
+//   gcc -O2 -pthread -o log-ingest log-ingest.c
+
+#define MAX_BUCKETS (1 << 20)
+#define NAME_LEN 32
+
+uint32_t INTERVAL = 240000, WINDOW = 1000; //defaults of the former duty-cycle.sh
+char *PREFIX = "";
+
+struct Bucket {
+	uint32_t ul_tx, dl_rx, miss, drift_n;
+	int64_t drift_sum;
+	int32_t drift_max;
+	uint32_t duty_active, duty_asn; //duty_asn 0: no sample
+};
+
+struct Node {
+	char name[NAME_LEN];
+	struct Bucket *b;
+	uint32_t nb;
+	uint32_t last_asn;
+	struct Node *next;
+};
+
+struct Log {
+	char *filename;
+	struct Node *nodes;
+	char error[300];
+};
+
+struct Node *node_get(struct Log *log, const char *name) {
+	struct Node *n;
+	for (n = log->nodes; n; n = n->next) {
+		if (!strcmp(n->name, name)) return n;
+	}
+	n = calloc(1, sizeof(*n));
+	if (!n) {
+		fprintf(stderr, "[error] out of memory\n");
+		exit(4);
+	}
+	snprintf(n->name, sizeof(n->name), "%s", name);
+	n->next = log->nodes;
+	log->nodes = n;
+	return n;
+}
+
+struct Bucket *bucket(struct Node *n, uint32_t asn) {
+	uint32_t ii = asn / INTERVAL, nb;
+	if (ii >= MAX_BUCKETS) return NULL;
+	if (ii >= n->nb) {
+		for (nb = n->nb ? n->nb : 16; nb <= ii; nb *= 2);
+		n->b = realloc(n->b, nb * sizeof(*n->b));
+		if (!n->b) {
+			fprintf(stderr, "[error] out of memory\n");
+			exit(4);
+		}
+		memset(&n->b[n->nb], 0, (nb - n->nb) * sizeof(*n->b));
+		n->nb = nb;
+	}
+	return &n->b[ii];
+}
+
+void add_duty(struct Node *n, uint32_t active, uint32_t asn) {
+	struct Bucket *b = bucket(n, asn);
+	if (!b || asn % INTERVAL >= WINDOW) return;
+	if (b->duty_asn && b->duty_asn <= asn) return;
+	b->duty_active = active;
+	b->duty_asn = asn;
+}
+
+void add_drift(struct Node *n, int32_t drift) {
+	struct Bucket *b = bucket(n, n->last_asn);
+	if (!b) return;
+	b->drift_n++;
+	b->drift_sum += drift;
+	if (abs(drift) > abs(b->drift_max)) b->drift_max = drift;
+}
+
+void add_event(struct Node *n, const struct Event *ev) {
+	struct Bucket *b;
+	n->last_asn = ev->asn;
+	switch (ev->type) {
+	case CTC_DUTY:
+		add_duty(n, ev->arg, ev->asn);
+		break;
+	case CTC_DRIFT:
+		add_drift(n, (int32_t)ev->arg);
+		break;
+	case UL_TX:
+	case DL_RX:
+	case CTC_MISS:
+		if (!(b = bucket(n, ev->asn))) break;
+		if (ev->type == UL_TX) b->ul_tx++;
+		else if (ev->type == DL_RX) b->dl_rx++;
+		else b->miss++;
+		break;
+	}
+}
+
+// the text lines of the firmware, see the printf of tsch.c
+void add_line(struct Node *n, char *line) {
+	struct Event ev;
+	char *p;
+	unsigned long active, asn;
+	long drift;
+	if ((p = strstr(line, "[ASN="))) {
+		n->last_asn = strtoul(p + 5, &p, 10);
+		if (strstr(p, "UL-TX")) ev.type = UL_TX;
+		else if (strstr(p, "DL-RX")) ev.type = DL_RX;
+		else return;
+		ev.asn = n->last_asn;
+		add_event(n, &ev);
+	}
+	else if ((p = strstr(line, "Duty Cycle = "))) {
+		if (sscanf(p + 13, "%lu / %lu", &active, &asn) != 2) return;
+		n->last_asn = asn;
+		add_duty(n, active, asn);
+	}
+	else if ((p = strstr(line, " Drift = "))) { //no ASN of its own, counted at the last one
+		if (sscanf(p + 9, "%ld", &drift) == 1) add_drift(n, drift);
+	}
+	else if (strstr(line, "CTC-Sync missed")) {
+		ev.type = CTC_MISS;
+		ev.asn = n->last_asn;
+		add_event(n, &ev);
+	}
+	else if ((p = strstr(line, "* ASN = "))) {
+		n->last_asn = strtoul(p + 8, NULL, 10);
+	}
+}
+
+void ingest(struct Log *log) {
+	static __thread char buf[1 << 20];
+	char line[1024], name[NAME_LEN], *p, *base;
+	struct Node *file_node, *n;
+	struct Event ev;
+	FILE *fp = fopen(log->filename, "r");
+	if (!fp) {
+		snprintf(log->error, sizeof(log->error), "%s: can't open", log->filename);
+		return;
+	}
+	setvbuf(fp, buf, _IOFBF, sizeof(buf));
+	base = strrchr(log->filename, '/');
+	snprintf(name, sizeof(name), "%s", base ? base + 1 : log->filename);
+	if ((p = strrchr(name, '.'))) *p = '\0';
+	file_node = node_get(log, name);
+	while (fgets(line, sizeof(line), fp)) {
+		n = file_node;
+		if ((p = strstr(line, "ID:")) && p - line < 24) {
+			snprintf(name, sizeof(name), "%d", atoi(p + 3));
+			n = node_get(log, name);
+		}
+		if (strchr(line, '@') && (p = parse(line, &ev))) add_event(n, &ev);
+		else add_line(n, line);
+	}
+	fclose(fp);
+}
+
+struct Log *logs;
+int n_logs, next_log;
+pthread_mutex_t log_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void *worker(void *arg) {
+	int ii;
+	while (1) {
+		pthread_mutex_lock(&log_lock);
+		ii = next_log++;
+		pthread_mutex_unlock(&log_lock);
+		if (ii >= n_logs) return NULL;
+		ingest(&logs[ii]);
+	}
+}
+
+// merge the nodes of all logs, a node may log into several files
+struct Node *merge() {
+	struct Node *all = NULL, *n, *m, *next;
+	struct Bucket *a, *b;
+	struct Log tmp = {0};
+	uint32_t ii;
+	int jj;
+	for (jj = 0; jj < n_logs; jj++) {
+		for (n = logs[jj].nodes; n; n = next) {
+			next = n->next;
+			if (!n->nb) continue; //no events, e.g. the file of "ID:" logs
+			tmp.nodes = all;
+			m = node_get(&tmp, n->name);
+			all = tmp.nodes;
+			for (ii = 0; ii < n->nb; ii++) {
+				b = &n->b[ii];
+				if (!(a = bucket(m, ii * INTERVAL))) break;
+				a->ul_tx += b->ul_tx;
+				a->dl_rx += b->dl_rx;
+				a->miss += b->miss;
+				a->drift_n += b->drift_n;
+				a->drift_sum += b->drift_sum;
+				if (abs(b->drift_max) > abs(a->drift_max)) a->drift_max = b->drift_max;
+				if (b->duty_asn && (!a->duty_asn || b->duty_asn < a->duty_asn)) {
+					a->duty_asn = b->duty_asn;
+					a->duty_active = b->duty_active;
+				}
+			}
+		}
+	}
+	return all;
+}
+
+int node_cmp(const void *a, const void *b) {
+	const struct Node *x = *(const struct Node **)a, *y = *(const struct Node **)b;
+	long ix = strtol(x->name, NULL, 10), iy = strtol(y->name, NULL, 10);
+	if (ix != iy) return ix < iy ? -1 : 1;
+	return strcmp(x->name, y->name);
+}
+
+FILE *openfile(const char *suffix) {
+	char filename[512];
+	FILE *fp;
+	snprintf(filename, sizeof(filename), "%s%s", PREFIX, suffix);
+	if (!(fp = fopen(filename, "w"))) {
+		printf("[error] %s: can't open\n", filename);
+		exit(2);
+	}
+	return fp;
+}
+
+void report(struct Node *all) {
+	struct Node **nodes, *n;
+	struct Bucket *b;
+	FILE *duty, *events;
+	uint32_t ii, nb = 0;
+	int jj, cnt = 0;
+	for (n = all; n; n = n->next) {
+		cnt++;
+		if (n->nb > nb) nb = n->nb;
+	}
+	nodes = malloc((cnt + 1) * sizeof(*nodes));
+	for (n = all, jj = 0; n; n = n->next) nodes[jj++] = n;
+	qsort(nodes, cnt, sizeof(*nodes), node_cmp);
+	duty = openfile("duty.csv");
+	events = openfile("events.csv");
+	fprintf(duty, "checkpoint,node,active,asn,duty\n");
+	fprintf(events, "from,to,node,ul_tx,dl_rx,ctc_miss,drift_n,drift_avg_us,drift_max_us\n");
+	for (ii = 0; ii < nb; ii++) { //one table per interval, rows by node
+		for (jj = 0; jj < cnt; jj++) {
+			if (ii >= nodes[jj]->nb) continue;
+			b = &nodes[jj]->b[ii];
+			if (b->duty_asn) {
+				fprintf(duty, "%u,%s,%u,%u,%f\n", ii * INTERVAL, nodes[jj]->name,
+					b->duty_active, b->duty_asn, (double)b->duty_active / b->duty_asn);
+			}
+			if (b->ul_tx || b->dl_rx || b->miss || b->drift_n) {
+				fprintf(events, "%u,%u,%s,%u,%u,%u,%u,", ii * INTERVAL, (ii + 1) * INTERVAL, nodes[jj]->name,
+					b->ul_tx, b->dl_rx, b->miss, b->drift_n);
+				if (b->drift_n) fprintf(events, "%.1f,%d\n", (double)b->drift_sum / b->drift_n, b->drift_max);
+				else fprintf(events, ",\n");
+			}
+		}
+	}
+	fclose(duty);
+	fclose(events);
+	free(nodes);
+}
+
+void usage(char *name) {
+	printf("usage: %s [-i INTERVAL] [-w WINDOW] [-o PREFIX] [-j JOBS] <log>...\n", name);
+	printf("  -i  checkpoint interval in slots (%u)\n", INTERVAL);
+	printf("  -w  slots after a checkpoint to take the Duty Cycle sample from (%u)\n", WINDOW);
+	printf("  -o  prefix of duty.csv and events.csv\n");
+	printf("  -j  logs read in parallel (cores)\n");
+	exit(1);
+}
+
+int main(int argn, char *argv[]) {
+	pthread_t *threads;
+	int opt, jobs, ii, ret = 0;
+	jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	while ((opt = getopt(argn, argv, "i:w:o:j:")) != -1) {
+		switch (opt) {
+		case 'i': INTERVAL = strtoul(optarg, NULL, 10); break;
+		case 'w': WINDOW = strtoul(optarg, NULL, 10); break;
+		case 'o': PREFIX = optarg; break;
+		case 'j': jobs = atoi(optarg); break;
+		default: usage(argv[0]);
+		}
+	}
+	if (optind >= argn || !INTERVAL || !WINDOW) usage(argv[0]);
+	n_logs = argn - optind;
+	if (jobs < 1) jobs = 1;
+	if (jobs > n_logs) jobs = n_logs;
+	logs = calloc(n_logs, sizeof(*logs));
+	threads = calloc(jobs, sizeof(*threads));
+	if (!logs || !threads) {
+		fprintf(stderr, "[error] out of memory\n");
+		return 4;
+	}
+	for (ii = 0; ii < n_logs; ii++) logs[ii].filename = argv[optind + ii];
+	for (ii = 0; ii < jobs; ii++) pthread_create(&threads[ii], NULL, worker, NULL);
+	for (ii = 0; ii < jobs; ii++) pthread_join(threads[ii], NULL);
+	for (ii = 0; ii < n_logs; ii++) {
+		if (logs[ii].error[0]) {
+			fprintf(stderr, "[error] %s\n", logs[ii].error);
+			ret = 3;
+		}
+	}
+	report(merge());
+	return ret;
+}
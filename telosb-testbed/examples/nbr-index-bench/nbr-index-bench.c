@@ -0,0 +1,139 @@
+/**
+ * \file
+ *         Cycles per neighbor lookup: the list walk with linkaddr_cmp that
+ *         nbr-table, tsch-queue and uip-ds6-nbr used before, against the
+ *         linkaddr-index behind nbr_table_get_from_lladdr() now.
+ *
+ *         make TARGET=sky: cycles from RTIMER_NOW() and F_CPU
+ *         make TARGET=native: TSC cycles on x86, nanoseconds elsewhere
+ */
+
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/random.h"
+#include "net/nbr-table.h"
+#include "dev/watchdog.h"
+#include <stdio.h>
+#include <string.h>
+
+#if CONTIKI_TARGET_NATIVE
+#define ROUNDS 100000
+#if defined(__x86_64__) || defined(__i386__)
+#define UNIT "cycles"
+#define bench_now() __builtin_ia32_rdtsc()
+#else
+#include <time.h>
+#define UNIT "ns"
+static uint64_t
+bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+#define per_lookup(t, n) ((unsigned long)((t) / (n)))
+#else /* CONTIKI_TARGET_NATIVE */
+#define ROUNDS 20 /* below the 2 s rtimer wrap at 48 neighbors */
+#define UNIT "cycles"
+#define bench_now() RTIMER_NOW()
+#define per_lookup(t, n) ((unsigned long)((uint64_t)(rtimer_clock_t)(t) * F_CPU / RTIMER_SECOND / (n)))
+#endif /* CONTIKI_TARGET_NATIVE */
+
+#define MAX_NBR NBR_TABLE_MAX_NEIGHBORS
+
+/* The old key list */
+struct key {
+  struct key *next;
+  linkaddr_t lladdr;
+};
+static struct key keys[MAX_NBR];
+LIST(key_list);
+
+NBR_TABLE(uint8_t, bench_table);
+
+static linkaddr_t addrs[MAX_NBR];
+static linkaddr_t absent[MAX_NBR];
+static volatile uintptr_t sink;
+
+/*---------------------------------------------------------------------------*/
+/* Testbed-like EUI-64: fixed OUI, random serial */
+static void
+make_addr(linkaddr_t *addr)
+{
+  static const uint8_t oui[] = { 0x00, 0x12, 0x74, 0x00 };
+  uint8_t i;
+  memset(addr, 0, sizeof(linkaddr_t));
+  for(i = 0; i < LINKADDR_SIZE; i++) {
+    addr->u8[i] = i < sizeof(oui) && LINKADDR_SIZE > sizeof(oui) ? oui[i] : random_rand();
+  }
+}
+/*---------------------------------------------------------------------------*/
+static struct key *
+list_lookup(const linkaddr_t *addr)
+{
+  struct key *k;
+  for(k = list_head(key_list); k != NULL; k = list_item_next(k)) {
+    if(linkaddr_cmp(&k->lladdr, addr)) {
+      return k;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Look up each of the n addresses of set ROUNDS times with method m */
+static unsigned long
+run(int m, const linkaddr_t *set, int n)
+{
+  uint64_t t;
+  uint32_t r;
+  int i;
+  watchdog_periodic();
+  t = bench_now();
+  for(r = 0; r < ROUNDS; r++) {
+    for(i = 0; i < n; i++) {
+      if(m == 0) {
+        sink += (uintptr_t)list_lookup(&set[i]);
+      } else {
+        sink += (uintptr_t)nbr_table_get_from_lladdr(bench_table, &set[i]);
+      }
+    }
+  }
+  t = bench_now() - t;
+  return per_lookup(t, (uint32_t)ROUNDS * n);
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(nbr_index_bench_process, "Neighbor lookup benchmark");
+AUTOSTART_PROCESSES(&nbr_index_bench_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(nbr_index_bench_process, ev, data)
+{
+  static int n, i;
+  static const int sizes[] = { 8, 16, 32, 48 };
+#define N_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+  PROCESS_BEGIN();
+
+  nbr_table_register(bench_table, NULL);
+  list_init(key_list);
+  for(i = 0; i < MAX_NBR; i++) {
+    make_addr(&addrs[i]);
+    make_addr(&absent[i]);
+  }
+
+  printf("nbrs  list-hit  index-hit  list-miss  index-miss  [%s/lookup]\n", UNIT);
+  for(n = 0, i = 0; i < N_SIZES && sizes[i] <= MAX_NBR; i++) {
+    /* Grow both tables to sizes[i] entries, in the same order */
+    for(; n < sizes[i]; n++) {
+      linkaddr_copy(&keys[n].lladdr, &addrs[n]);
+      list_add(key_list, &keys[n]);
+      nbr_table_add_lladdr(bench_table, &addrs[n]);
+    }
+    printf("%4d  %8lu  %9lu  %9lu  %10lu\n", n,
+           run(0, addrs, n), run(1, addrs, n), run(0, absent, n), run(1, absent, n));
+    PROCESS_PAUSE();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
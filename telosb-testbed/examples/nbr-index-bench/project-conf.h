@@ -0,0 +1,12 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* Testbed addresses: EUI-64 */
+#undef LINKADDR_CONF_SIZE
+#define LINKADDR_CONF_SIZE 8
+
+/* A root or forwarder in the 45-node testbed */
+#undef NBR_TABLE_CONF_MAX_NEIGHBORS
+#define NBR_TABLE_CONF_MAX_NEIGHBORS 48
+
+#endif /* PROJECT_CONF_H_ */
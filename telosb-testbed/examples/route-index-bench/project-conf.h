@@ -0,0 +1,15 @@
+#ifndef PROJECT_CONF_H_
+#define PROJECT_CONF_H_
+
+/* Routing table of a storing-mode root, up to the largest benchmark */
+#undef UIP_CONF_MAX_ROUTES
+#define UIP_CONF_MAX_ROUTES 1024
+
+#undef NBR_TABLE_CONF_MAX_NEIGHBORS
+#define NBR_TABLE_CONF_MAX_NEIGHBORS 8
+
+/* sicslowpan.c logs through the deployment macros */
+#define WITH_LOG 0
+#include "deployment-log.h"
+
+#endif /* PROJECT_CONF_H_ */
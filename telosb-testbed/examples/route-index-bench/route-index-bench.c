@@ -0,0 +1,118 @@
+/**
+ * \file
+ *         Cycles per uip_ds6_route_lookup() in a table of /128 host routes,
+ *         as on a storing-mode RPL root, with and without the route index
+ *         (UIP_DS6_ROUTE_CONF_INDEX).
+ *
+ *         hit:      the destinations of the routes, least recently used
+ *                   first, the worst case of the list walk
+ *         miss:     destinations without a route
+ *         fallback: the same with an extra /64 route that matches them,
+ *                   i.e. the walk the index falls back to
+ *
+ *         make TARGET=native INDEX=1 clean all
+ *         make TARGET=native INDEX=0 clean all
+ *
+ *         TSC cycles on x86, nanoseconds elsewhere
+ */
+
+#include "contiki.h"
+#include "lib/random.h"
+#include "net/ip/uip.h"
+#include "net/ipv6/uip-ds6.h"
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define UNIT "cycles"
+#define bench_now() __builtin_ia32_rdtsc()
+#else
+#include <time.h>
+#define UNIT "ns"
+static uint64_t
+bench_now(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+
+#define MAX_ROUTES 1000
+#define LOOKUPS 200000 /* per measurement */
+
+static uip_ipaddr_t addrs[MAX_ROUTES];
+static uip_ipaddr_t absent[MAX_ROUTES];
+static uip_ipaddr_t nexthop;
+static volatile uintptr_t sink;
+
+/*---------------------------------------------------------------------------*/
+/* fd00::212:7400:xxxx:xxxx, like the testbed nodes */
+static void
+make_addr(uip_ipaddr_t *addr)
+{
+  uip_ip6addr(addr, 0xfd00, 0, 0, 0, 0x0212, 0x7400,
+              random_rand(), random_rand());
+}
+/*---------------------------------------------------------------------------*/
+/* Look up each of the n addresses of set, in order, LOOKUPS times in all */
+static unsigned long
+run(uip_ipaddr_t *set, int n)
+{
+  uint64_t t;
+  uint32_t r, rounds = LOOKUPS / n;
+  int i;
+  t = bench_now();
+  for(r = 0; r < rounds; r++) {
+    for(i = 0; i < n; i++) {
+      sink += (uintptr_t)uip_ds6_route_lookup(&set[i]);
+    }
+  }
+  t = bench_now() - t;
+  return (unsigned long)(t / (rounds * n));
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(route_index_bench_process, "Route lookup benchmark");
+AUTOSTART_PROCESSES(&route_index_bench_process);
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(route_index_bench_process, ev, data)
+{
+  static int n, i;
+  static const int sizes[] = { 50, 200, 1000 };
+#define N_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+  static uip_lladdr_t nexthop_lladdr;
+  static uip_ipaddr_t prefix;
+  uip_ds6_route_t *r;
+
+  PROCESS_BEGIN();
+
+  /* Let tcpip_process initialize uip-ds6 */
+  PROCESS_PAUSE();
+
+  uip_ip6addr(&nexthop, 0xfe80, 0, 0, 0, 0, 0, 0, 0);
+  memset(&nexthop_lladdr, 0, sizeof(nexthop_lladdr));
+  nexthop_lladdr.addr[sizeof(nexthop_lladdr) - 1] = 1;
+  uip_ds6_set_addr_iid(&nexthop, &nexthop_lladdr);
+  uip_ds6_nbr_add(&nexthop, &nexthop_lladdr, 1, NBR_REACHABLE);
+  uip_ip6addr(&prefix, 0xfd00, 0, 0, 0, 0, 0, 0, 0);
+  for(i = 0; i < MAX_ROUTES; i++) {
+    make_addr(&addrs[i]);
+    make_addr(&absent[i]);
+  }
+
+  printf("route index %s\n", UIP_DS6_ROUTE_INDEX ? "on" : "off");
+  printf("routes  hit  miss  fallback  [%s/lookup]\n", UNIT);
+  for(n = 0, i = 0; i < N_SIZES; i++) {
+    for(; n < sizes[i]; n++) {
+      uip_ds6_route_add(&addrs[n], 128, &nexthop);
+    }
+    printf("%6d  %5lu  %5lu", n, run(addrs, n), run(absent, n));
+    r = uip_ds6_route_add(&prefix, 64, &nexthop);
+    printf("  %8lu\n", run(absent, n));
+    uip_ds6_route_rm(r);
+    PROCESS_PAUSE();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -134,14 +134,16 @@ PROCESS_THREAD(unicast_sender_process, ev, data)
 #endif
 	//printf("App: Init Done\n");
 
-  if(src_dst_flow[0] != 0xff) {
-  //was if (node_id != ROOT_ID) {
+  /* The root may make this node a source at runtime (downlink flow table) */
+  if(node_id != ROOT_ID) {
     etimer_set(&periodic_timer, SEND_INTERVAL);
     while(1) {
       etimer_set(&send_timer, random_rand() % (SEND_INTERVAL));
       PROCESS_WAIT_UNTIL(etimer_expired(&send_timer));
 
-      if(default_instance != NULL) {
+      if(src_dst_flow[0] == 0xff) {
+        /* Not a source */
+      } else if(default_instance != NULL) {
         to_send_cnt++;
         while(to_send_cnt > 0) {
           seqno = ((uint32_t)src_dst_flow[0] << 16) | cnt;
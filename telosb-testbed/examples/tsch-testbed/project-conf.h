@@ -38,6 +38,12 @@
 
 #define N_FLOW 8
 #define WITH_CTC 1
+#define CTC_CONF_CALIBRATION 0 /* log all CTC pulses for lora_control -c */
+#define CTC_CONF_CODEBOOK ctc_cb_dense /* ASN words, must match CODEBOOK of lora_control */
+#define CTC_CONF_DL_WORDS 1 /* downlink messages of lora_control, 0: fixed code 4..6 */
+#ifdef CONTIKI_TARGET_SKY
+#define CTC_CONF_CCA_CAPTURE 1 /* time pulses with CCA edge interrupts, 0: RSSI polling */
+#endif
 #define WITH_RPL 1
 #define WITH_APP_PROBING (!WITH_RPL)
 #define TSCH_CONF_EB_AUTOSELECT (!WITH_RPL)
@@ -80,6 +86,8 @@
 #define TSCH_CALLBACK_NEW_TIME_SOURCE orchestra_callback_new_time_source
 #define TSCH_CALLBACK_JOINING_NETWORK orchestra_callback_joining_network
 //#define TSCH_CALLBACK_DO_NACK orchestra_callback_do_nack
+#define RPL_CALLBACK_DIO_OPTION_OUTPUT orchestra_dio_option_output
+#define RPL_CALLBACK_DIO_OPTION_INPUT orchestra_dio_option_input
 #define TSCH_CONF_MIN_EB_PERIOD (2 * CLOCK_SECOND)
 #define TSCH_CONF_MAX_EB_PERIOD (2 * CLOCK_SECOND)
 
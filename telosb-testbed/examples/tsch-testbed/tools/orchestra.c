@@ -45,7 +45,11 @@
 #include "deployment.h"
 #include "net/rime/rime.h"
 #include "tools/orchestra.h"
+#include "dev/serial-line.h"
+#include "net/rpl/rpl-private.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #define DEBUG DEBUG_NONE
 #include "net/ip/uip-debug.h"
@@ -392,30 +396,98 @@ const uint8_t dl_fwd_nodes[N_FLOW][MAX_DL_FWDS] = {
 };
 #endif
 
-void dataflow_init() {
-	uint8_t ii, jj, kk;
+extern uint8_t dl_slot_rx, dl_slot_tx[];
+uint8_t dl_slot_rx = 0, dl_slot_tx[N_FLOW] = {0};
+extern const uint8_t dl_slot_0;
+const uint8_t dl_slot_0 = 50;
+
+/* Downlink flow table. The tables above are the boot entries, the root
+ * installs new ones at runtime ("dlflow" serial command) and every node
+ * passes them on in its DIOs. seq orders the versions of an entry, 0 is
+ * the boot entry */
+struct dl_flow {
+	uint8_t seq;
+	uint8_t src, dst;
+	uint8_t n_fwd;
+	uint8_t fwd[MAX_DL_FWDS];
+};
+static struct dl_flow dl_flows[N_FLOW];
+static uint32_t dl_flow_dirty; //entries changed but not yet advertised
+static uint8_t dl_flow_next; //next entry of the DIO rotation
+
+/* Role of this node in all flows and its downlink slots */
+struct dl_roles {
+	uint8_t src_dst_flow[2];
+	uint8_t parent;
+	uint8_t flow_child[N_FLOW];
+	uint32_t fwdflow_bitmap;
+	uint8_t slot_rx, slot_tx[N_FLOW];
+};
+
+static void dl_flows_init() {
+	uint8_t ii, kk;
 	for (ii = 0; ii < N_FLOW; ii++) {
+		dl_flows[ii].seq = 0;
+		dl_flows[ii].src = src_dst_nodes[ii][0];
+		dl_flows[ii].dst = src_dst_nodes[ii][1];
+		for (kk = 0; kk < MAX_DL_FWDS && dl_fwd_nodes[ii][kk]; kk++) {
+			dl_flows[ii].fwd[kk] = dl_fwd_nodes[ii][kk];
+		}
+		dl_flows[ii].n_fwd = kk;
+	}
+}
+
+static void dl_roles_get(struct dl_roles *r) {
+	uint8_t ii, jj;
+	const struct dl_flow *f;
+	memset(r, 0, sizeof(*r));
+	r->src_dst_flow[0] = r->src_dst_flow[1] = 0xff;
+	for (ii = 0, f = dl_flows; ii < N_FLOW; ii++, f++) {
 		if (node_id == 1) {
-			dl_flow_child[ii] = dl_fwd_nodes[ii][0] ? dl_fwd_nodes[ii][0] : src_dst_nodes[ii][1];
+			r->flow_child[ii] = f->n_fwd ? f->fwd[0] : f->dst;
 			continue;
 		}
-		for (jj = 0; jj < 2; jj++) {
-			if (node_id != src_dst_nodes[ii][jj]) continue;
-			src_dst_flow[jj] = ii;
-			if (!jj) continue;
-			for (kk = 0; kk < MAX_DL_FWDS; kk++) {
-				if (!dl_fwd_nodes[ii][kk]) break;
-			}
-			dl_parent = kk ? dl_fwd_nodes[ii][kk-1] : 1;
+		if (node_id == f->src) r->src_dst_flow[0] = ii;
+		if (node_id == f->dst) {
+			r->src_dst_flow[1] = ii;
+			r->parent = f->n_fwd ? f->fwd[f->n_fwd - 1] : 1;
 		}
-		for (jj = 0; jj < MAX_DL_FWDS; jj++) {
-			if (node_id != dl_fwd_nodes[ii][jj]) continue;
-			dl_fwdflow_bitmap |= 1UL << ii;
-			dl_parent = jj ? dl_fwd_nodes[ii][jj-1] : 1;
-			dl_flow_child[ii] = jj < MAX_DL_FWDS - 1 && dl_fwd_nodes[ii][jj+1] ? dl_fwd_nodes[ii][jj+1] : src_dst_nodes[ii][1];
+		for (jj = 0; jj < f->n_fwd; jj++) {
+			if (node_id != f->fwd[jj]) continue;
+			r->fwdflow_bitmap |= 1UL << ii;
+			r->parent = jj ? f->fwd[jj - 1] : 1;
+			r->flow_child[ii] = jj + 1 < f->n_fwd ? f->fwd[jj + 1] : f->dst;
 			break;
 		}
 	}
+	if (node_id == 1 || r->fwdflow_bitmap) {
+		for (ii = 0; ii < N_FLOW; ii++) {
+			if (!r->flow_child[ii]) continue;
+#ifdef DL_SENDER_BASED
+			r->slot_tx[ii] = dl_slot_0 + node_id;
+#else //Receiver based downlink by default
+			r->slot_tx[ii] = dl_slot_0 + r->flow_child[ii];
+#endif
+		}
+	}
+	if (r->parent) {
+#ifdef DL_SENDER_BASED
+		r->slot_rx = dl_slot_0 + r->parent;
+#else //Receiver based downlink by default
+		r->slot_rx = dl_slot_0 + node_id;
+#endif
+	}
+}
+
+void dataflow_init() {
+	struct dl_roles r;
+	dl_flows_init();
+	dl_roles_get(&r);
+	src_dst_flow[0] = r.src_dst_flow[0];
+	src_dst_flow[1] = r.src_dst_flow[1];
+	dl_parent = r.parent;
+	memcpy(dl_flow_child, r.flow_child, sizeof(dl_flow_child));
+	dl_fwdflow_bitmap = r.fwdflow_bitmap;
 }
 /*
 struct SlotPair {
@@ -429,49 +501,163 @@ const struct SlotPair dl_node[3] = {
 	{4, {34,0}}
 };
 */
-extern uint8_t dl_slot_rx, dl_slot_tx[];
-uint8_t dl_slot_rx = 0, dl_slot_tx[N_FLOW] = {0};
-extern const uint8_t dl_slot_0;
-const uint8_t dl_slot_0 = 50;
+static struct tsch_slotframe *sf_dl;
 
-void add_downlink(struct tsch_slotframe *sf) {
-	uint8_t ii, jj;
-	if (node_id == 1 || dl_fwdflow_bitmap) {
-		for (ii = 0; ii < N_FLOW; ii++) {
-			if (!dl_flow_child[ii]) continue;
-#ifdef DL_SENDER_BASED
-			dl_slot_tx[ii] = dl_slot_0 + node_id;
-#else //Receiver based downlink by default
-			dl_slot_tx[ii] = dl_slot_0 + dl_flow_child[ii];
-#endif
-			for (jj = 0; jj < ii; jj++) {
-				if (dl_slot_tx[ii] == dl_slot_tx[jj]) goto NEXT;
-			}
-			tsch_schedule_add_link(sf, LINK_OPTION_RX, LINK_TYPE_NORMAL, &tsch_broadcast_address, dl_slot_tx[ii], 2);
-NEXT:;
-		}
+static uint8_t dl_slot_used(const struct dl_roles *r, uint8_t slot) {
+	uint8_t ii;
+	if (slot == r->slot_rx) return 1;
+	for (ii = 0; ii < N_FLOW; ii++) {
+		if (slot == r->slot_tx[ii]) return 1;
+	}
+	return 0;
+}
+
+/* Move the downlink links of sf_dl from the roles in use to r. The slot
+ * operation sees either the old or the new roles: dl_slot_tx[] and
+ * dl_slot_rx change under the TSCH lock, links of dropped slots are gone
+ * before and links of new slots come after */
+static void dl_roles_apply(const struct dl_roles *r) {
+	struct dl_roles old;
+	struct tsch_link *l;
+	uint8_t ii, slot, locked;
+	old.slot_rx = dl_slot_rx;
+	memcpy(old.slot_tx, dl_slot_tx, sizeof(old.slot_tx));
+	for (ii = 0; ii <= N_FLOW; ii++) {
+		slot = ii < N_FLOW ? old.slot_tx[ii] : old.slot_rx;
+		if (!slot || dl_slot_used(r, slot)) continue;
+		l = tsch_schedule_get_link_from_timeslot(sf_dl, slot);
+		if (l != NULL && l->data == NULL) tsch_schedule_remove_link(sf_dl, l); //not an Orchestra unicast link
+	}
+#if WITH_CTC
+	if (src_dst_flow[1] != 0xff && r->src_dst_flow[1] == 0xff) {
+		tsch_schedule_remove_link_from_timeslot(sf_dl, dl_slot_0);
 	}
-	if (dl_parent) {
-#ifdef DL_SENDER_BASED
-		dl_slot_rx = dl_slot_0 + dl_parent;
-#else //Receiver based downlink by default
-		dl_slot_rx = dl_slot_0 + node_id;
 #endif
-		tsch_schedule_add_link(sf, LINK_OPTION_RX, LINK_TYPE_NORMAL, &tsch_broadcast_address, dl_slot_rx, 2);
+	locked = tsch_get_lock();
+	src_dst_flow[0] = r->src_dst_flow[0];
+	src_dst_flow[1] = r->src_dst_flow[1];
+	dl_parent = r->parent;
+	memcpy(dl_flow_child, r->flow_child, sizeof(dl_flow_child));
+	dl_fwdflow_bitmap = r->fwdflow_bitmap;
+	dl_slot_rx = r->slot_rx;
+	memcpy(dl_slot_tx, r->slot_tx, sizeof(dl_slot_tx));
+	if (locked) tsch_release_lock();
+	for (ii = 0; ii <= N_FLOW; ii++) {
+		slot = ii < N_FLOW ? r->slot_tx[ii] : r->slot_rx;
+		if (!slot || tsch_schedule_get_link_from_timeslot(sf_dl, slot)) continue;
+		tsch_schedule_add_link(sf_dl, LINK_OPTION_RX, LINK_TYPE_NORMAL, &tsch_broadcast_address, slot, 2);
 	}
 #if WITH_CTC
-	if (src_dst_flow[1] != 0xff) {
-		tsch_schedule_add_link(sf, LINK_OPTION_RX, LINK_TYPE_ADVERTISING_ONLY, NULL, dl_slot_0, 2);
+	if (r->src_dst_flow[1] != 0xff && !tsch_schedule_get_link_from_timeslot(sf_dl, dl_slot_0)) {
+		tsch_schedule_add_link(sf_dl, LINK_OPTION_RX, LINK_TYPE_ADVERTISING_ONLY, NULL, dl_slot_0, 2);
 	}
 #endif
-/*for (ii=0; ii < dl_nodes; ii++) {
-		if (node_id != dl_node[ii].nodeid) continue;
-		for (jj=0; jj < 2; jj++) {
-			if (!dl_node[ii].slot[jj]) continue;
-			dl_slot[jj] = dl_node[ii].slot[jj] + dl_slot_0;
-			tsch_schedule_add_link(sf, LINK_OPTION_RX, LINK_TYPE_NORMAL, &tsch_broadcast_address, dl_slot[jj], 2);
+}
+
+void add_downlink(struct tsch_slotframe *sf) {
+	struct dl_roles r;
+	sf_dl = sf;
+	dl_roles_get(&r);
+	dl_roles_apply(&r);
+}
+
+/* Store a new version of an entry, advertise it and apply it */
+static void dl_flow_update(uint8_t flow, const struct dl_flow *f) {
+	struct dl_roles r;
+	uint8_t ii;
+	dl_flows[flow] = *f;
+	dl_flow_dirty |= 1UL << flow;
+	printf("DL-FLOW: [%u %u] %u -> %u via", flow, f->seq, f->src, f->dst);
+	for (ii = 0; ii < f->n_fwd; ii++) printf(" %u", f->fwd[ii]);
+	printf("\n");
+	if (sf_dl == NULL) return;
+	dl_roles_get(&r);
+	dl_roles_apply(&r);
+	if (default_instance != NULL) rpl_reset_dio_timer(default_instance, 0);
+}
+
+/* DIO option: flow, seq, src, dst, forwarders. Changed entries are sent
+ * first, then one entry installed at runtime per DIO so that rebooted
+ * nodes catch up */
+int
+orchestra_dio_option_output(uint8_t *buffer, int max_len)
+{
+	uint8_t ii, flow;
+	int pos = 0;
+	const struct dl_flow *f;
+	if (max_len > ORCHESTRA_DL_FLOW_DIO_SPACE) max_len = ORCHESTRA_DL_FLOW_DIO_SPACE;
+	for (ii = 0; ii < N_FLOW; ii++) {
+		if (dl_flow_dirty) {
+			for (flow = 0; !((dl_flow_dirty >> flow) & 1); flow++);
+		} else {
+			flow = dl_flow_next;
+			dl_flow_next = (dl_flow_next + 1) % N_FLOW;
+			if (!dl_flows[flow].seq) continue;
+		}
+		f = &dl_flows[flow];
+		if (pos + 6 + f->n_fwd > max_len) break;
+		dl_flow_dirty &= ~(1UL << flow);
+		buffer[pos++] = ORCHESTRA_DL_FLOW_OPTION;
+		buffer[pos++] = 4 + f->n_fwd;
+		buffer[pos++] = flow;
+		buffer[pos++] = f->seq;
+		buffer[pos++] = f->src;
+		buffer[pos++] = f->dst;
+		memcpy(&buffer[pos], f->fwd, f->n_fwd);
+		pos += f->n_fwd;
+		if (!dl_flow_dirty) break;
+	}
+	return pos;
+}
+
+void
+orchestra_dio_option_input(const uint8_t *option, int len)
+{
+	struct dl_flow f;
+	uint8_t flow;
+	if (option[0] != ORCHESTRA_DL_FLOW_OPTION || len < 6 || len > 6 + MAX_DL_FWDS) return;
+	flow = option[2];
+	if (flow >= N_FLOW || (int8_t)(option[3] - dl_flows[flow].seq) <= 0) return;
+	f.seq = option[3];
+	f.src = option[4];
+	f.dst = option[5];
+	f.n_fwd = len - 6;
+	memcpy(f.fwd, &option[6], f.n_fwd);
+	dl_flow_update(flow, &f);
+}
+
+/* Root: "dlflow <flow> <src> <dst> [forwarder ...]" installs an entry */
+PROCESS(dl_flow_shell_process, "Orchestra: downlink flow shell");
+PROCESS_THREAD(dl_flow_shell_process, ev, data)
+{
+	static struct dl_flow f;
+	char *p, *next;
+	unsigned long v[3 + MAX_DL_FWDS];
+	uint8_t n;
+
+	PROCESS_BEGIN();
+	while(1) {
+		PROCESS_WAIT_EVENT_UNTIL(ev == serial_line_event_message && data != NULL);
+		p = (char *)data;
+		if (strncmp(p, "dlflow ", 7)) continue;
+		for (p += 7, n = 0; n < 3 + MAX_DL_FWDS; n++, p = next) {
+			v[n] = strtoul(p, &next, 10);
+			if (next == p) break;
 		}
-	}*/
+		if (n < 3 || v[0] >= N_FLOW || v[1] > 0xff || v[2] > 0xff) {
+			printf("DL-FLOW: usage dlflow <flow> <src> <dst> [forwarder ...]\n");
+			continue;
+		}
+		f.seq = dl_flows[v[0]].seq + 1;
+		if (!f.seq) f.seq = 1;
+		f.src = v[1];
+		f.dst = v[2];
+		for (f.n_fwd = 0; f.n_fwd < n - 3; f.n_fwd++) {
+			f.fwd[f.n_fwd] = v[3 + f.n_fwd];
+		}
+		dl_flow_update(v[0], &f);
+	}
+	PROCESS_END();
 }
 
 void
@@ -513,6 +699,9 @@ orchestra_init()
   /* Sender-based slotframe for unicast */
   sf_sb = tsch_schedule_add_slotframe(2, ORCHESTRA_SBUNICAST_PERIOD);
   add_downlink(sf_sb);
+  if(node_id == 1) {
+    process_start(&dl_flow_shell_process, NULL);
+  }
 #ifdef ORCHESTRA_SBUNICAST_PERIOD2
   sf_sb2 = tsch_schedule_add_slotframe(3, ORCHESTRA_SBUNICAST_PERIOD2);
   //add_downlink(sf_sb2);
@@ -76,9 +76,16 @@
 
 #endif
 
+/* RPL DIO option of the downlink flow table (unassigned type, testbed
+ * only) and the bytes of it a DIO may carry without 6LoWPAN fragments */
+#define ORCHESTRA_DL_FLOW_OPTION                  0x20
+#define ORCHESTRA_DL_FLOW_DIO_SPACE               16
+
 void orchestra_init();
 void orchestra_callback_new_time_source(struct tsch_neighbor *old, struct tsch_neighbor *new);
 void orchestra_callback_joining_network();
 int orchestra_callback_do_nack(struct tsch_link *link, linkaddr_t *src, linkaddr_t *dst);
+int orchestra_dio_option_output(uint8_t *buffer, int max_len);
+void orchestra_dio_option_input(const uint8_t *option, int len);
 
 #endif /* __ORCHESTRA_H__ */
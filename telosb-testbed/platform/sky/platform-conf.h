@@ -199,6 +199,15 @@ typedef unsigned long off_t;
 #define CC2420_DISABLE_FIFOP_INT() do {CC2420_FIFOP_PORT(IE) &= ~BV(CC2420_FIFOP_PIN);} while(0)
 #define CC2420_CLEAR_FIFOP_INT()   do {CC2420_FIFOP_PORT(IFG) &= ~BV(CC2420_FIFOP_PIN);} while(0)
 
+/* CCA edges on external interrupt 0, used to time CTC pulses. */
+#define CC2420_CCA_INT_FALLING()   do {CC2420_CCA_PORT(IES) |= BV(CC2420_CCA_PIN);} while(0)
+#define CC2420_CCA_INT_RISING()    do {CC2420_CCA_PORT(IES) &= ~BV(CC2420_CCA_PIN);} while(0)
+#define CC2420_ENABLE_CCA_INT()    do {CC2420_CCA_PORT(IE) |= BV(CC2420_CCA_PIN);} while(0)
+#define CC2420_DISABLE_CCA_INT()   do {CC2420_CCA_PORT(IE) &= ~BV(CC2420_CCA_PIN);} while(0)
+#define CC2420_CLEAR_CCA_INT()     do {CC2420_CCA_PORT(IFG) &= ~BV(CC2420_CCA_PIN);} while(0)
+#define CC2420_CCA_INT_PENDING()   (CC2420_CCA_PORT(IFG) & CC2420_CCA_PORT(IE) & BV(CC2420_CCA_PIN))
+#define CC2420_FIFOP_INT_PENDING() (CC2420_FIFOP_PORT(IFG) & CC2420_FIFOP_PORT(IE) & BV(CC2420_FIFOP_PIN))
+
 /*
  * Enables/disables CC2420 access to the SPI bus (not the bus).
  * (Chip Select)
@@ -0,0 +1,164 @@
+package org.contikios.cooja.ctc;
+
+import java.util.Collection;
+
+import org.jdom.Element;
+
+import org.contikios.cooja.ClassDescription;
+import org.contikios.cooja.RadioConnection;
+import org.contikios.cooja.Simulation;
+import org.contikios.cooja.interfaces.Radio;
+import org.contikios.cooja.radiomediums.UDGM;
+
+/**
+ * UDGM with the LoRa pulses of {@link CtcTransmitterMoteType}.
+ *
+ * A pulse has no destinations: it only raises the signal strength of the
+ * radios on its channel for its duration, by a log-distance path loss.
+ * Msp802154Radio passes the signal strength on to the RSSI register of
+ * the CC2420 model, which is what cc2420_rssi() and the CCA pin of the
+ * nodes see. 802.15.4 frames are lost at receivers where a pulse is above
+ * the interference threshold.
+ */
+@ClassDescription("UDGM with LoRa CTC")
+public class CtcRadioMedium extends UDGM {
+  public double CTC_TX_POWER = 10; /* [dBm] */
+  public double CTC_PATH_LOSS = 40; /* [dB] at 1 m */
+  public double CTC_PATH_LOSS_EXPONENT = 2.5;
+  public double CTC_INTERFERENCE = -85; /* [dBm], pulses above corrupt frames */
+
+  public CtcRadioMedium(Simulation simulation) {
+    super(simulation);
+  }
+
+  public static boolean isCtcRadio(Radio radio) {
+    return radio.getMote().getType() instanceof CtcTransmitterMoteType;
+  }
+
+  private static boolean sameChannel(Radio a, Radio b) {
+    return a.getChannel() < 0 || b.getChannel() < 0 || a.getChannel() == b.getChannel();
+  }
+
+  /**
+   * @return Signal strength of a pulse from source at dest [dBm]
+   */
+  public double getPulseRssi(Radio source, Radio dest) {
+    double distance = source.getPosition().getDistanceTo(dest.getPosition());
+    return CTC_TX_POWER - CTC_PATH_LOSS
+        - 10 * CTC_PATH_LOSS_EXPONENT * Math.log10(Math.max(distance, 1.0));
+  }
+
+  /* strongest active pulse at radio, SS_NOTHING if none */
+  private double getActivePulseRssi(Radio radio) {
+    double rssi = SS_NOTHING;
+    for (RadioConnection conn : getActiveConnections()) {
+      if (isCtcRadio(conn.getSource()) && sameChannel(conn.getSource(), radio)) {
+        rssi = Math.max(rssi, getPulseRssi(conn.getSource(), radio));
+      }
+    }
+    return rssi;
+  }
+
+  public RadioConnection createConnections(Radio sender) {
+    if (isCtcRadio(sender)) {
+      RadioConnection pulse = new RadioConnection(sender);
+      for (Radio recv : getRegisteredRadios()) {
+        if (recv == sender || isCtcRadio(recv) || !sameChannel(sender, recv) ||
+            getPulseRssi(sender, recv) < CTC_INTERFERENCE) {
+          continue;
+        }
+        /* Interfere ongoing receptions, kept out of the pulse itself so
+         * that UDGM does not assign them a distance signal strength */
+        for (RadioConnection conn : getActiveConnections()) {
+          if (conn.isDestination(recv)) {
+            conn.addInterfered(recv);
+            if (!recv.isInterfered()) {
+              recv.interfereAnyReception();
+            }
+          }
+        }
+      }
+      return pulse;
+    }
+
+    RadioConnection newConnection = super.createConnections(sender);
+    for (Radio recv : newConnection.getDestinations()) {
+      if (isCtcRadio(recv)) {
+        newConnection.removeDestination(recv);
+      } else if (getActivePulseRssi(recv) >= CTC_INTERFERENCE) {
+        /* Frame starts during a pulse: interfered only */
+        newConnection.removeDestination(recv);
+        newConnection.addInterfered(recv);
+        recv.interfereAnyReception();
+      }
+    }
+    return newConnection;
+  }
+
+  public void updateSignalStrengths() {
+    super.updateSignalStrengths();
+
+    /* Add the pulses */
+    for (RadioConnection conn : getActiveConnections()) {
+      Radio source = conn.getSource();
+      if (!isCtcRadio(source)) {
+        continue;
+      }
+      source.setCurrentSignalStrength(getBaseRssi(source));
+      for (Radio radio : getRegisteredRadios()) {
+        if (radio == source || isCtcRadio(radio) || !sameChannel(source, radio)) {
+          continue;
+        }
+        double rssi = getPulseRssi(source, radio);
+        if (radio.getCurrentSignalStrength() < rssi) {
+          radio.setCurrentSignalStrength(rssi);
+        }
+      }
+    }
+  }
+
+  public Collection<Element> getConfigXML() {
+    Collection<Element> config = super.getConfigXML();
+    Element element;
+
+    element = new Element("ctc_tx_power");
+    element.setText(Double.toString(CTC_TX_POWER));
+    config.add(element);
+
+    element = new Element("ctc_path_loss");
+    element.setText(Double.toString(CTC_PATH_LOSS));
+    config.add(element);
+
+    element = new Element("ctc_path_loss_exponent");
+    element.setText(Double.toString(CTC_PATH_LOSS_EXPONENT));
+    config.add(element);
+
+    element = new Element("ctc_interference");
+    element.setText(Double.toString(CTC_INTERFERENCE));
+    config.add(element);
+
+    return config;
+  }
+
+  public boolean setConfigXML(Collection<Element> configXML, boolean visAvailable) {
+    super.setConfigXML(configXML, visAvailable);
+    for (Element element : configXML) {
+      if (element.getName().equals("ctc_tx_power")) {
+        CTC_TX_POWER = Double.parseDouble(element.getText());
+      }
+
+      if (element.getName().equals("ctc_path_loss")) {
+        CTC_PATH_LOSS = Double.parseDouble(element.getText());
+      }
+
+      if (element.getName().equals("ctc_path_loss_exponent")) {
+        CTC_PATH_LOSS_EXPONENT = Double.parseDouble(element.getText());
+      }
+
+      if (element.getName().equals("ctc_interference")) {
+        CTC_INTERFERENCE = Double.parseDouble(element.getText());
+      }
+    }
+    return true;
+  }
+}
@@ -0,0 +1,401 @@
+package org.contikios.cooja.ctc;
+
+import java.awt.Container;
+import java.util.ArrayDeque;
+import java.util.Collection;
+import java.util.Random;
+
+import org.apache.log4j.Logger;
+import org.jdom.Element;
+
+import org.contikios.cooja.AbstractionLevelDescription;
+import org.contikios.cooja.COOJARadioPacket;
+import org.contikios.cooja.ClassDescription;
+import org.contikios.cooja.Mote;
+import org.contikios.cooja.MoteTimeEvent;
+import org.contikios.cooja.MoteType;
+import org.contikios.cooja.RadioPacket;
+import org.contikios.cooja.Simulation;
+import org.contikios.cooja.interfaces.ApplicationRadio;
+import org.contikios.cooja.motes.AbstractApplicationMote;
+import org.contikios.cooja.motes.AbstractApplicationMoteType;
+
+/**
+ * Application-level LoRa transmitter of the cross-technology sync.
+ *
+ * Sends the RSSI pulses of assign_code() in lora-ctc-transmitter/main.cpp
+ * (ASN_ENCODING 1, downlink queue): slot 0 of every SYNC frame carries the
+ * bell and the ctc_cb_dense words of the ASN, slot 50 of every APP frame the
+ * ctc_cb_downlink codes of the queued downlink messages, silent while the
+ * queue is empty. Messages are queued every downlink_period APP frames and
+ * by serial input "flow seqno command", as for lora_control -d. With
+ * codebook "legacy" every SYNC frame carries the bell and, with downlink
+ * off, app_code is sent in every APP frame. The pulse of
+ * code c starts HEADWAIT - c * CODE_STEP into the slot and lasts
+ * BIN0 - CODE_STEP / 2 + c * CODE_STEP, i.e. in the middle of the width bin
+ * ctc_pulse() of the nodes maps to c.
+ *
+ * The pulses carry no 802.15.4 frame. Use with {@link CtcRadioMedium},
+ * which turns them into RSSI at the nodes on the same channel.
+ */
+@ClassDescription("LoRa CTC transmitter")
+@AbstractionLevelDescription("Application level")
+public class CtcTransmitterMoteType extends AbstractApplicationMoteType {
+  private static Logger logger = Logger.getLogger(CtcTransmitterMoteType.class);
+
+  /* Frame control of lora-ctc-transmitter/main.cpp */
+  public static final int[] FR_LEN = {397, 31, 101}; /* SYNC, RPL, APP */
+  public static final int[] CTC_SLOT = {0, 0, 50};
+  public static final int[] CTC_LEN = {1, 0, 1};
+  public static final int FR_SYNC = 0, FR_APP = 2;
+  public static final int CODES = 11;
+  public static final long HEADWAIT = 12795; /* [us] */
+  public static final long CODE_STEP = 300; /* [us] */
+  public static final long BIN0 = 2350; /* [us], upper bound of the shortest pulse */
+  public static final int CHANNEL = 26; /* 2480 MHz */
+
+  /* ctc-codebook.h */
+  public static final Codebook CB_LEGACY = new Codebook(11, 7, 7, false);
+  public static final Codebook CB_DENSE = new Codebook(11, 0, 5, true);
+  public static final Codebook CB_DOWNLINK = new Codebook(11, 0, 3, true);
+  public static final int DL_HEADER = 500, DL_MAX_FLOWS = 50, DL_SEQ_MOD = 10;
+  public static final int DL_MAX_CMD = DL_HEADER - 1;
+
+  /* The plant uses 15011 us to follow the TelosB crystals, simulated
+   * clocks are exact */
+  private long slotLength = 15000; /* [us] */
+  private int appCode = 5; /* without downlink, -1: silent in APP slots */
+  private double jitter = 0; /* [us], standard deviation of the pulse start */
+  private boolean legacy = false; /* codebook of the nodes: legacy or dense */
+  private boolean downlink = true; /* CTC_CONF_DL_WORDS of the nodes */
+  private int downlinkPeriod = 20; /* [APP frames] between queued messages, 0: serial input only */
+  private int downlinkFlows = 1; /* queued messages cycle through flows 0.. */
+  private int downlinkRepeats = 1; /* sends of a message if nothing else is queued */
+
+  public CtcTransmitterMoteType() {
+    super();
+  }
+
+  public CtcTransmitterMoteType(String identifier) {
+    super(identifier);
+    setDescription("LoRa CTC Transmitter #" + identifier);
+  }
+
+  public boolean configureAndInit(Container parentContainer,
+      Simulation simulation, boolean visAvailable)
+  throws MoteTypeCreationException {
+    if (!super.configureAndInit(parentContainer, simulation, visAvailable)) {
+      return false;
+    }
+    setDescription("LoRa CTC Transmitter #" + getIdentifier());
+    return true;
+  }
+
+  public Mote generateMote(Simulation simulation) {
+    return new CtcTransmitterMote(this, simulation);
+  }
+
+  public static long pulseOffset(int code) {
+    return HEADWAIT - code * CODE_STEP;
+  }
+
+  public static long pulseWidth(int code) {
+    return BIN0 - CODE_STEP / 2 + code * CODE_STEP;
+  }
+
+  /** Java port of ctc_cb_encode() and friends, see ctc-codebook.c */
+  public static class Codebook {
+    public final int codes, minCode, dataLen;
+    public final boolean check;
+
+    public Codebook(int codes, int minCode, int dataLen, boolean check) {
+      this.codes = codes;
+      this.minCode = minCode;
+      this.dataLen = dataLen;
+      this.check = check;
+    }
+    public int bell() {
+      return codes - 1;
+    }
+    public int base() {
+      return codes - 1 - minCode;
+    }
+    public int period() {
+      return 1 + dataLen + (check ? 1 : 0);
+    }
+    public long capacity() {
+      long cap = 1;
+      for (int i = 0; i < dataLen; i++) {
+        cap *= base();
+      }
+      return cap;
+    }
+    private static int gcd(int a, int b) {
+      while (b != 0) {
+        int t = a % b;
+        a = b;
+        b = t;
+      }
+      return a;
+    }
+    private static int weight(int base, int i) {
+      int n = 0;
+      for (int k = 1; k < base; k++) {
+        n += gcd(k, base) == 1 ? 1 : 0;
+      }
+      i %= n;
+      for (int k = 1; ; k++) {
+        if (gcd(k, base) == 1 && i-- == 0) {
+          return k;
+        }
+      }
+    }
+    /* codes of value after the bell, null if it does not fit */
+    public int[] encode(long value) {
+      int base = base(), sum = 0;
+      int[] codes = new int[period() - 1];
+      if (value < 0 || value >= capacity()) {
+        return null;
+      }
+      for (int i = dataLen; i-- > 0;) {
+        int d = (int) (value % base);
+        value /= base;
+        codes[i] = minCode + d;
+        sum = (sum + weight(base, i) * d) % base;
+      }
+      if (check) {
+        codes[dataLen] = minCode + sum;
+      }
+      return codes;
+    }
+  }
+
+  public Collection<Element> getConfigXML(Simulation simulation) {
+    Collection<Element> config = super.getConfigXML(simulation);
+    Element element;
+
+    element = new Element("slot_length");
+    element.setText(Long.toString(slotLength));
+    config.add(element);
+
+    element = new Element("app_code");
+    element.setText(Integer.toString(appCode));
+    config.add(element);
+
+    element = new Element("jitter");
+    element.setText(Double.toString(jitter));
+    config.add(element);
+
+    element = new Element("codebook");
+    element.setText(legacy ? "legacy" : "dense");
+    config.add(element);
+
+    element = new Element("downlink");
+    element.setText(Boolean.toString(downlink));
+    config.add(element);
+
+    element = new Element("downlink_period");
+    element.setText(Integer.toString(downlinkPeriod));
+    config.add(element);
+
+    element = new Element("downlink_flows");
+    element.setText(Integer.toString(downlinkFlows));
+    config.add(element);
+
+    element = new Element("downlink_repeats");
+    element.setText(Integer.toString(downlinkRepeats));
+    config.add(element);
+
+    return config;
+  }
+
+  public boolean setConfigXML(Simulation simulation,
+      Collection<Element> configXML, boolean visAvailable)
+  throws MoteTypeCreationException {
+    for (Element element : configXML) {
+      String name = element.getName();
+      if (name.equals("slot_length")) {
+        slotLength = Long.parseLong(element.getText());
+      } else if (name.equals("app_code")) {
+        appCode = Integer.parseInt(element.getText());
+        if (appCode >= CODES) {
+          logger.warn("app_code " + appCode + " out of range, using " + (CODES - 1));
+          appCode = CODES - 1;
+        }
+      } else if (name.equals("jitter")) {
+        jitter = Double.parseDouble(element.getText());
+      } else if (name.equals("codebook")) {
+        legacy = element.getText().equals("legacy");
+      } else if (name.equals("downlink")) {
+        downlink = Boolean.parseBoolean(element.getText());
+      } else if (name.equals("downlink_period")) {
+        downlinkPeriod = Integer.parseInt(element.getText());
+      } else if (name.equals("downlink_flows")) {
+        downlinkFlows = Integer.parseInt(element.getText());
+        if (downlinkFlows < 1 || downlinkFlows > DL_MAX_FLOWS) {
+          logger.warn("downlink_flows " + downlinkFlows + " out of range, using 1");
+          downlinkFlows = 1;
+        }
+      } else if (name.equals("downlink_repeats")) {
+        downlinkRepeats = Math.max(1, Integer.parseInt(element.getText()));
+      }
+    }
+    return super.setConfigXML(simulation, configXML, visAvailable);
+  }
+
+  public static class CtcTransmitterMote extends AbstractApplicationMote {
+    private ApplicationRadio radio = null;
+    private CtcTransmitterMoteType type;
+    private Random random;
+
+    private final RadioPacket pulse = new COOJARadioPacket(new byte[] { 0 });
+    private long epoch; /* simulation time of ASN 0 */
+    private long asn; /* next slot to consider */
+
+    private int[] word; /* ASN word after the current bell */
+    private final ArrayDeque<int[]> dlQueue = new ArrayDeque<int[]>(); /* flow, seqno, command */
+    private int[] dlCodes = new int[0]; /* codes of the current message */
+    private int dlPos, dlSent;
+    private int[] dlSeq = new int[DL_MAX_FLOWS];
+    private int dlNextFlow;
+
+    public CtcTransmitterMote() {
+      super();
+    }
+    public CtcTransmitterMote(MoteType moteType, Simulation simulation) {
+      super(moteType, simulation);
+    }
+
+    public void execute(long time) {
+      if (radio != null) {
+        return; /* pulses are chained by sentPacket() */
+      }
+      radio = (ApplicationRadio) getInterfaces().getRadio();
+      radio.setChannel(CHANNEL);
+      type = (CtcTransmitterMoteType) getType();
+      random = getSimulation().getRandomGenerator();
+      epoch = time;
+      asn = 0;
+      scheduleNextPulse();
+    }
+
+    /* code in the active slot of frame type ff, -1: stay silent */
+    private int assignCode(int ff, long frNum) {
+      if (ff == FR_SYNC) {
+        if (type.legacy) {
+          return CODES - 1;
+        }
+        int period = CB_DENSE.period();
+        if (frNum % period == 0) { /* word index of the next bell, wraps at the capacity */
+          word = CB_DENSE.encode((frNum / period + 1) % CB_DENSE.capacity());
+          return CB_DENSE.bell();
+        }
+        return word == null ? -1 : word[(int) (frNum % period) - 1];
+      }
+      if (ff == FR_APP) {
+        if (!type.downlink) {
+          return type.appCode;
+        }
+        if (type.downlinkPeriod > 0 && frNum % type.downlinkPeriod == 0) {
+          int flow = dlNextFlow;
+          dlNextFlow = (dlNextFlow + 1) % type.downlinkFlows;
+          queueDownlink(flow, dlSeq[flow]++, frNum % (DL_MAX_CMD + 1));
+        }
+        return nextDownlinkCode();
+      }
+      return -1;
+    }
+
+    /* log line for the latency: compare with DL-CTC of the nodes */
+    private void queueDownlink(int flow, int seq, long command) {
+      dlQueue.add(new int[] { flow, seq, (int) command });
+      log("[ASN=" + asn + "]\tDL-QUEUE: [" + flow + " " + seq + "] cmd " + command);
+    }
+
+    /* TDownlinkStream::NextCode() of lora_control */
+    private int nextDownlinkCode() {
+      if (dlPos >= dlCodes.length) {
+        int[] msg = dlQueue.poll();
+        if (msg != null) {
+          dlCodes = segment(msg);
+          dlPos = 0;
+          dlSent = 1;
+        } else if (dlCodes.length > 0 && dlSent < type.downlinkRepeats) {
+          dlPos = 0;
+          dlSent++;
+        } else {
+          return -1;
+        }
+      }
+      return dlCodes[dlPos++];
+    }
+
+    /* bell, header word, bell, command word, bell */
+    private static int[] segment(int[] msg) {
+      int[][] words = {
+        CB_DOWNLINK.encode(DL_HEADER + msg[0] * DL_SEQ_MOD + msg[1] % DL_SEQ_MOD),
+        CB_DOWNLINK.encode(msg[2])
+      };
+      int[] codes = new int[words.length * (1 + words[0].length) + 1];
+      int n = 0;
+      for (int[] w : words) {
+        codes[n++] = CB_DOWNLINK.bell();
+        for (int c : w) {
+          codes[n++] = c;
+        }
+      }
+      codes[n++] = CB_DOWNLINK.bell();
+      return codes;
+    }
+
+    /* "flow seqno command" as for lora_control -d */
+    public void writeString(String s) {
+      String[] f = s.trim().split("\\s+");
+      try {
+        int flow = Integer.parseInt(f[0]), seq = Integer.parseInt(f[1]);
+        long command = Long.parseLong(f[2]);
+        if (flow < 0 || flow >= DL_MAX_FLOWS || seq < 0 || command < 0 || command > DL_MAX_CMD) {
+          throw new NumberFormatException();
+        }
+        queueDownlink(flow, seq, command);
+      } catch (RuntimeException e) {
+        logger.warn("bad downlink message: " + s);
+      }
+    }
+
+    private void scheduleNextPulse() {
+      int code = -1;
+      for (; code < 0; asn++) {
+        for (int ff = 0; ff < FR_LEN.length; ff++) {
+          if (asn % FR_LEN[ff] == CTC_SLOT[ff]) {
+            code = CTC_LEN[ff] > 0 ? assignCode(ff, asn / FR_LEN[ff]) : -1;
+            break;
+          }
+        }
+      }
+      /* asn is the slot after the pulse now */
+      final int pulseCode = code;
+      long start = epoch + (asn - 1) * type.slotLength + pulseOffset(code);
+      if (type.jitter > 0) {
+        start += Math.round(random.nextGaussian() * type.jitter);
+      }
+      start = Math.max(start, getSimulation().getSimulationTime());
+      getSimulation().scheduleEvent(new MoteTimeEvent(this, 0) {
+        public void execute(long t) {
+          radio.startTransmittingPacket(pulse, pulseWidth(pulseCode));
+        }
+      }, start);
+    }
+
+    public void receivedPacket(RadioPacket p) {
+      /* Ignore */
+    }
+    public void sentPacket(RadioPacket p) {
+      scheduleNextPulse();
+    }
+
+    public String toString() {
+      return "CTC transmitter " + getID();
+    }
+  }
+}